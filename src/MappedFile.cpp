@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+// file		MappedFile.cpp
+// class	teh::MappedFile
+// brief 	Read-only view of the contents of a file, mapped into memory.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "MappedFile.h"
+#ifdef TEH_MAPPEDFILE_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #include <fstream>
+  #include <iterator>
+#endif
+
+
+namespace teh {
+
+
+MappedFile::MappedFile (
+    std::string const & fileName )	// file to map
+    : open ( false ),
+      data ( 0 ),
+      size ( 0 )
+{
+#ifdef TEH_MAPPEDFILE_MMAP
+    int const fd = ::open( fileName.c_str(), O_RDONLY );
+    if ( fd < 0 )
+    {
+	errorMessage = "MappedFile: cannot open " + fileName;
+	return;
+    }
+    struct stat info;
+    if ( ::fstat( fd, &info ) != 0 || !S_ISREG( info.st_mode ) )
+    {
+	errorMessage = "MappedFile: not a regular file: " + fileName;
+	::close( fd );
+	return;
+    }
+    size = static_cast<std::size_t>( info.st_size );
+    if ( size > 0 )
+    {
+	void * const map = ::mmap( 0, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	if ( map == MAP_FAILED )
+	{
+	    errorMessage = "MappedFile: cannot map " + fileName;
+	    size = 0;
+	    ::close( fd );
+	    return;
+	}
+	::madvise( map, size, MADV_SEQUENTIAL );
+	data = static_cast<char const *>( map );
+    }
+    ::close( fd );			// the mapping stays
+    open = true;
+#else
+    std::ifstream is ( fileName.c_str(), std::ios::binary );
+    if ( !is )
+    {
+	errorMessage = "MappedFile: cannot open " + fileName;
+	return;
+    }
+    contents.assign( std::istreambuf_iterator<char>( is ), std::istreambuf_iterator<char>() );
+    if ( is.bad() )
+    {
+	errorMessage = "MappedFile: cannot read " + fileName;
+	contents.clear();
+	return;
+    }
+    size = contents.size();
+    data = ( size > 0 ? &contents[0] : 0 );
+    open = true;
+#endif
+}
+
+MappedFile::~MappedFile ()
+{
+#ifdef TEH_MAPPEDFILE_MMAP
+    if ( data != 0 )
+	::munmap( const_cast<char *>( data ), size );
+#endif
+}
+
+} // namespace teh
@@ -0,0 +1,85 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		MappedFile.h
+@class		teh::MappedFile
+@brief 		Read-only view of the contents of a file, mapped into memory.
+@details {
+		The constructor maps a regular file into memory with mmap,
+		where it is available (POSIX), so that the pages are read
+		when they are first used, and can be read by several
+		threads at once; the destructor unmaps the file.
+		On other systems, the file is read into memory.
+		IsOpen is false, with a message from ErrorMessage, if the
+		file could not be opened, or it is not a regular file
+		(a pipe or a terminal), which cannot be mapped; the caller
+		can read it as a stream instead.
+		An empty file is open, with Size zero.
+}
+@example {
+	Example:
+	    teh::MappedFile const file ( "soils.csv" );
+	    if ( !file.IsOpen() )
+		std::cerr << file.ErrorMessage() << std::endl;
+	    else
+		Scan( file.Data(), file.Size() );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_MappedFile_h
+#define INC_teh_MappedFile_h
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #define TEH_MAPPEDFILE_MMAP 1
+#endif
+
+namespace teh {
+
+
+    class MappedFile
+    {
+      public:
+
+	/// Maps the file; check IsOpen.
+	explicit MappedFile (
+	    std::string const & fileName );	///< file to map
+
+	~MappedFile ();
+
+	/// True if the file is mapped.
+	bool IsOpen () const { return open; }
+
+	/// Message of the failure to open the file.
+	std::string const & ErrorMessage () const { return errorMessage; }
+
+	/// Contents of the file; null if it is empty or not open.
+	char const * Data () const { return data; }
+
+	/// Number of bytes in the file.
+	std::size_t Size () const { return size; }
+
+      private:
+
+	bool open;
+	char const * data;
+	std::size_t size;
+	std::string errorMessage;
+#ifndef TEH_MAPPEDFILE_MMAP
+	std::vector<char> contents;
+#endif
+
+	// not used
+	MappedFile ( MappedFile const & );
+	MappedFile & operator= ( MappedFile const & );
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_MappedFile_h
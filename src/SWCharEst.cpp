@@ -17,8 +17,16 @@
 //-----------------------------------------------------------------------------
 
 #include "SWCharEst.h"
+#include "SWCharEstSIMD.h"
+#include "SWCharEstMatrix.h"
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <stdint.h>
 using std::cout;
 using std::endl;
 
@@ -29,6 +37,339 @@ using std::endl;
 namespace teh {
 
 
+namespace {
+
+    // Number of soils per block in SWCharEst::GetBatch.
+    // The block work arrays fit in the L1 cache.
+    std::size_t const batchBlockSize = 256;
+
+    typedef SWCharEstMatrix M;
+
+    // SWCharEst::GetBatch pass 1: input status and regressions.
+    // There are no library calls or branches, so the compiler
+    // can vectorize the loop (g++ needs -O3 -fno-trapping-math).
+    // The terms are summed in the order of SWCharEst::Evaluate, so
+    // that the results are bit-identical to Evaluate's, unless the
+    // compiler contracts the sums into FMAs (-ffp-contract=off).
+    void BatchRegressions (
+	std::size_t const m,
+	float const * __restrict const sand,
+	float const * __restrict const clay,
+	float const * __restrict const ompc,
+	int * __restrict const status,		// InputStatus bits
+	float * __restrict const valid,		// 1 = valid soil, 0 = invalid
+	float * __restrict const regressions)	// 3 x m, ld = batchBlockSize
+    {
+	float * __restrict const t1500t = regressions + M::Theta1500t * batchBlockSize;
+	float * __restrict const t33t   = regressions + M::Theta33t * batchBlockSize;
+	float * __restrict const tS33t  = regressions + M::ThetaS33t * batchBlockSize;
+	for ( std::size_t i = 0; i < m; ++i )
+	{
+	    float const s = sand[i];
+	    float const c = clay[i];
+	    float const om = std::min ( 70.0f, ompc[i] );
+
+	    // same tests as CheckArgs, written as selects; NaN fails
+	    int st = SWCharEst::StatusOK;
+	    st |= ( s >= 0.0f ) ? 0 : SWCharEst::StatusSand;
+	    st |= ( s <= 1.0f ) ? 0 : SWCharEst::StatusSand;
+	    st |= ( c >= 0.0f ) ? 0 : SWCharEst::StatusClay;
+	    st |= ( c <= 1.0f ) ? 0 : SWCharEst::StatusClay;
+	    st |= ( om >= 0.0f ) ? 0 : SWCharEst::StatusOM;
+	    st |= ( s + c <= 1.0f ) ? 0 : SWCharEst::StatusSandClay;
+	    status[i] = st;
+	    valid[i] = ( st == 0 ) ? 1.0f : 0.0f;
+
+	    t1500t[i] = M::Regress( M::Theta1500t, s, c, om );
+	    t33t[i]   = M::Regress( M::Theta33t, s, c, om );
+	    tS33t[i]  = M::Regress( M::ThetaS33t, s, c, om );
+	}
+    }
+
+    // SWCharEst::GetBatch in portable C++.
+    // Output arrays must not overlap the input arrays.
+    // Returns the number of soils with a nonzero status.
+    std::size_t GetBatchPortable (
+	std::size_t const n,
+	float const * const sand,
+	float const * const clay,
+	float const * const ompc,
+	float * const wp,
+	float * const fc,
+	float * const thetaS,
+	float * const ks,
+	unsigned char * const status)	// may be null
+    {
+	int blockStatus[batchBlockSize];
+	float valid[batchBlockSize];	// 1 = valid soil, 0 = invalid
+	float regressions[M::numRegressions * batchBlockSize];
+
+	std::size_t rejected = 0;
+	for ( std::size_t start = 0; start < n; start += batchBlockSize )
+	{
+	    std::size_t const m = std::min( batchBlockSize, n - start );
+	    BatchRegressions( m, sand + start, clay + start, ompc + start,
+			      blockStatus, valid, regressions );
+	    // pass 2: constraints and Ks, shared with SWCharEstMatrix
+	    M::Results( m, sand + start, valid, regressions, batchBlockSize,
+			wp + start, fc + start, thetaS + start, ks + start );
+	    for ( std::size_t i = 0; i < m; ++i )
+		rejected += ( blockStatus[i] != 0 );
+	    if ( status )
+		for ( std::size_t i = 0; i < m; ++i )
+		    status[start + i] = static_cast<unsigned char>( blockStatus[i] );
+	}
+	return rejected;
+    }
+
+    // A GetBatch kernel, with a status array.
+    typedef std::size_t (*KernelFunction) (
+	std::size_t const, float const * const, float const * const, float const * const,
+	float * const, float * const, float * const, float * const, unsigned char * const );
+
+    // Finds the input status and packs the inputs of the valid soils;
+    // returns the number of valid soils.
+    typedef std::size_t (*PackFunction) (
+	std::size_t const, float const * const, float const * const, float const * const,
+	unsigned char * const, float * const, float * const, float * const );
+
+    // Unpacks one output of the valid soils; others get zero.
+    typedef void (*UnpackFunction) (
+	std::size_t const, unsigned char const * const, float const * const, float * const );
+
+    // Number of soils per chunk in GetBatch with compaction.
+    // The chunk work arrays fit in the L1 cache.
+    std::size_t const compactChunkSize = 512;
+
+    std::size_t PackPortable (
+	std::size_t const n,
+	float const * const sand,
+	float const * const clay,
+	float const * const ompc,
+	unsigned char * const status,
+	float * const packedSand,
+	float * const packedClay,
+	float * const packedOM)
+    {
+	std::size_t k = 0;
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    // every soil is written; k advances only for valid soils
+	    status[i] = SWCharEst::Status( sand[i], clay[i], ompc[i] );
+	    packedSand[k] = sand[i];
+	    packedClay[k] = clay[i];
+	    packedOM[k] = ompc[i];
+	    k += ( status[i] == 0 );
+	}
+	return k;
+    }
+
+    void UnpackPortable (
+	std::size_t const n,
+	unsigned char const * const status,
+	float const * const packed,
+	float * const values)
+    {
+	std::size_t k = 0;
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    values[i] = ( status[i] == 0 ? packed[k] : 0.0f );
+	    k += ( status[i] == 0 );
+	}
+    }
+
+    // SWCharEst::GetBatch with compaction, by chunks. The number of
+    // rejected soils in each chunk decides how the next is evaluated.
+    // If the fraction is at most the threshold, the kernel evaluates
+    // the whole chunk, and counts the rejected soils at no extra cost.
+    // Otherwise the soils are checked first and the valid ones packed;
+    // the kernel evaluates only those, and the results are unpacked.
+    std::size_t GetBatchCompacting (
+	std::size_t const n,
+	float const * const sand,
+	float const * const clay,
+	float const * const ompc,
+	float * const wp,
+	float * const fc,
+	float * const thetaS,
+	float * const ks,
+	unsigned char * const status,	// may be null
+	KernelFunction const kernel,
+	PackFunction const pack,
+	UnpackFunction const unpack,
+	float const threshold )		// fraction of rejected soils
+    {
+	unsigned char chunkStatus[compactChunkSize];
+	float in[3][compactChunkSize];	// packed sand, clay, OM
+	float out[4][compactChunkSize];	// packed WP, FC, thetaS, Ks
+
+	std::size_t rejected = 0;
+	bool compact = false;		// from the last chunk
+	for ( std::size_t start = 0; start < n; start += compactChunkSize )
+	{
+	    std::size_t const m = std::min( compactChunkSize, n - start );
+	    std::size_t chunkRejected;
+	    if ( !compact )
+	    {
+		chunkRejected = kernel( m, sand + start, clay + start, ompc + start,
+					wp + start, fc + start, thetaS + start, ks + start,
+					( status ? status + start : 0 ) );
+	    }
+	    else
+	    {
+		std::size_t const k = pack( m, sand + start, clay + start, ompc + start,
+					    chunkStatus, in[0], in[1], in[2] );
+		kernel( k, in[0], in[1], in[2], out[0], out[1], out[2], out[3], 0 );
+		unpack( m, chunkStatus, out[0], wp + start );
+		unpack( m, chunkStatus, out[1], fc + start );
+		unpack( m, chunkStatus, out[2], thetaS + start );
+		unpack( m, chunkStatus, out[3], ks + start );
+		if ( status )
+		    std::memcpy( status + start, chunkStatus, m );
+		chunkRejected = m - k;
+	    }
+	    rejected += chunkRejected;
+	    compact = ( chunkRejected > threshold * m );
+	}
+	return rejected;
+    }
+
+    // SWCharEst::EvaluateFast polynomials, fitted at Chebyshev nodes:
+    // log(1 + m) / m, sqrt(0.5) - 1 <= m < sqrt(2) - 1, absolute error 4e-7
+    // exp(r), |r| <= ln(2) / 2, relative error 1e-7
+    float const logQ[7] = {
+	1.000000964e+00f, -5.000114504e-01f, 3.331467381e-01f, -2.490828918e-01f,
+	2.049175965e-01f, -1.868075143e-01f, 1.193105444e-01f };
+    float const expP[6] = {
+	1.000000075e+00f, 1.000000038e+00f, 4.999886911e-01f,
+	1.666641548e-01f, 4.191752969e-02f, 8.375128890e-03f };
+    float const ln2 = 0.693147181f;
+    float const ln2Hi = 0.693359375f;
+    float const ln2Lo = -2.12194440e-4f;
+    float const log2e = 1.44269504088896341f;
+    float const expMax = 88.0f;
+    float const expMin = -87.3365448f;
+
+    // Natural log for SWCharEst::EvaluateFast;
+    // NaN if x < 0 or NaN, -inf if x = 0, x if x = inf.
+    inline float FastLog ( float x )
+    {
+	if ( !( x > 0.0f ) )
+	    return ( x == 0.0f ? -HUGE_VALF : NAN );
+	if ( x == HUGE_VALF )
+	    return x;
+	int e = 0;
+	if ( x < 1.17549435e-38f )	// subnormal
+	{
+	    x *= 8388608.0f;		// 2^23
+	    e = -23;
+	}
+
+	// x = (1 + m) * 2^e, sqrt(0.5) <= 1 + m < sqrt(2), without branches
+	uint32_t xi;
+	std::memcpy( &xi, &x, sizeof(xi) );
+	xi += 0x3f800000u - 0x3f3504f3u;	// bits of 1.0f - bits of sqrt(0.5)
+	e += static_cast<int>( xi >> 23 ) - 127;
+	xi = ( xi & 0x007fffffu ) + 0x3f3504f3u;
+	float m;
+	std::memcpy( &m, &xi, sizeof(m) );
+	m -= 1.0f;
+
+	// polynomial in Estrin form, for a shorter dependency chain than Horner
+	float const z = m * m;
+	float const q = ( logQ[0] + logQ[1] * m ) + ( logQ[2] + logQ[3] * m ) * z
+			+ ( ( logQ[4] + logQ[5] * m ) + logQ[6] * z ) * ( z * z );
+	return m * q + static_cast<float>(e) * ln2;
+    }
+
+    // exp for SWCharEst::EvaluateFast; zero if x underflows,
+    // inf if x overflows.
+    inline float FastExp ( float x )
+    {
+	if ( x != x )
+	    return x;
+	if ( x > expMax )
+	    return HUGE_VALF;
+	if ( x < expMin )
+	    return 0.0f;
+
+	// exp(x) = 2^n * exp(r), n = round(x / ln2);
+	// adding 1.5 * 2^23 rounds to an integer, in the low bits
+	float const shifted = x * log2e + 12582912.0f;
+	float const n = shifted - 12582912.0f;
+	uint32_t shiftedBits;
+	std::memcpy( &shiftedBits, &shifted, sizeof(shiftedBits) );
+	int const ni = static_cast<int>( shiftedBits - 0x4b400000u );
+	x -= n * ln2Hi;
+	x -= n * ln2Lo;
+
+	// polynomial in Estrin form
+	float const z = x * x;
+	float const y = ( expP[0] + expP[1] * x ) + ( expP[2] + expP[3] * x ) * z
+			+ ( expP[4] + expP[5] * x ) * ( z * z );
+
+	uint32_t const pow2ni = static_cast<uint32_t>( ni + 127 ) << 23;
+	float pow2n;
+	std::memcpy( &pow2n, &pow2ni, sizeof(pow2n) );
+	return y * pow2n;
+    }
+
+    // The best kernel the CPU supports.
+    SWCharEst::BatchKernel FastestKernel ()
+    {
+	if ( SWCharEst::IsKernelSupported( SWCharEst::KernelAVX512 ) )
+	    return SWCharEst::KernelAVX512;
+	if ( SWCharEst::IsKernelSupported( SWCharEst::KernelAVX2 ) )
+	    return SWCharEst::KernelAVX2;
+	return SWCharEst::KernelPortable;
+    }
+
+    // The kernel at startup: SWCHAREST_KERNEL if set and supported,
+    // else the fastest.
+    SWCharEst::BatchKernel StartupKernel ()
+    {
+	char const * const name = std::getenv( "SWCHAREST_KERNEL" );
+	if ( name == 0 || *name == '\0' )
+	    return FastestKernel();
+	SWCharEst::BatchKernel const kernels[] = {
+	    SWCharEst::KernelAuto, SWCharEst::KernelPortable,
+	    SWCharEst::KernelAVX2, SWCharEst::KernelAVX512 };
+	for ( int i = 0; i < 4; ++i )
+	{
+	    if ( std::strcmp( name, SWCharEst::KernelName( kernels[i] ) ) != 0 )
+		continue;
+	    if ( kernels[i] == SWCharEst::KernelAuto )
+		return FastestKernel();
+	    if ( SWCharEst::IsKernelSupported( kernels[i] ) )
+		return kernels[i];
+	    break;
+	}
+	std::cerr << "SWCharEst: SWCHAREST_KERNEL=" << name
+		  << " is unknown or not supported by this CPU; using "
+		  << SWCharEst::KernelName( FastestKernel() ) << endl;
+	return FastestKernel();
+    }
+
+    // The kernel used by SWCharEst::GetBatch.
+    // Selected once, on first use.
+    std::atomic<int> & BatchKernelInUse ()
+    {
+	static std::atomic<int> kernel ( StartupKernel() );
+	return kernel;
+    }
+
+    // The compaction threshold of SWCharEst::GetBatch.
+    std::atomic<float> & CompactionThreshold ()
+    {
+	static std::atomic<float> threshold ( SWCharEst::defaultCompactionThreshold );
+	return threshold;
+    }
+
+} // namespace
+
+
+constexpr float SWCharEst::defaultCompactionThreshold;
+
 void SWCharEst::Usage ()
 {
     char const NL = '\n';
@@ -36,6 +377,8 @@ void SWCharEst::Usage ()
 	 << "  teh::SWCharEst::Usage();" << NL
 	 << "  teh::SWCharEst swc();" << NL
 	 << "  std::vector<float> results = swc.Get( sand-fraction, clay-fraction, SOM-percent );" << NL
+	 << "or, without an object:" << NL
+	 << "  teh::SWCharEst::Results results = teh::SWCharEst::Evaluate( sand-fraction, clay-fraction, SOM-percent );" << NL
 	 << "Arguments:" << NL
 	 << "  sand-fraction = sand weight fraction (0-1)" << NL
 	 << "  clay-fraction = clay weight fraction (0-1)" << NL
@@ -48,21 +391,23 @@ void SWCharEst::Usage ()
 	 << endl;
 }
 
+template
+<
+    typename T		// floating-point type
+>
 bool SWCharEst::CheckArgs (
-    float const sand,				// sand fraction (0-1)
-    float const clay,				// clay fraction (0-1)
-    float const ompc)				// organic matter wt %
+    T const sand,				// sand fraction (0-1)
+    T const clay,				// clay fraction (0-1)
+    T const ompc)				// organic matter wt %
+    noexcept
 {
-    bool ok = true;
-    if ( sand < 0.0f || sand > 1.0f )
-	ok = false;
-    if ( clay < 0.0f || clay > 1.0f )
-	ok = false;
-    if ( ompc < 0.0f || ompc > 70.0f )
-	ok = false;
-    if ( sand + clay > 1.0f )
-	ok = false;
-    return ok;
+    // bitwise operators, so there are no branches
+    bool const bad =
+	( sand < T(0) ) | ( sand > T(1) ) |
+	( clay < T(0) ) | ( clay > T(1) ) |
+	( ompc < T(0) ) | ( ompc > T(70) ) |
+	( sand + clay > T(1) );
+    return !bad;
 }
 
 std::vector<float> & SWCharEst::Get (	// returns WP, FC, thetaS, Ks
@@ -70,53 +415,92 @@ std::vector<float> & SWCharEst::Get (	// returns WP, FC, thetaS, Ks
     float const clay,			// clay fraction (0-1)
     float const ompc)			// organic matter wt %
 {
+    Results const r = Evaluate( sand, clay, ompc );
     results.resize(4);
-    results.assign( 4, 0.0f );
+    results[0] = r.WP;
+    results[1] = r.FC;
+    results[2] = r.thetaS;
+    results[3] = r.Ks;
+    return results;
+}
+
+// The constants are written as T(literal) rather than as float literals.
+// For T = float these round to the same values, so results are unchanged.
+template
+<
+    typename T,		// floating-point type
+    bool fastMath	// use FastLog, FastExp
+>
+SWCharEst::TResults<T> SWCharEst::Estimate (	// returns WP, FC, thetaS, Ks
+    T const sand,			// sand fraction (0-1)
+    T const clay,			// clay fraction (0-1)
+    T const ompc)			// organic matter wt %
+    noexcept
+{
+    TResults<T> props = { T(0), T(0), T(0), T(0) };
 
-    float const om = std::min ( 70.0f, ompc );		// upper limit OM%
+    T const om = std::min ( T(70), ompc );		// upper limit OM%
     if ( !CheckArgs(sand, clay, om) )
-	return results;
+	return props;
 
-    float const theta1500t =
-		-0.024f * sand + 0.487f * clay + 0.006f * om
-		+ 0.005f * sand * om
-		- 0.013f * clay * om
-		+ 0.068f * sand * clay
-		+ 0.031f;
+    T const theta1500t =
+		-T(0.024) * sand + T(0.487) * clay + T(0.006) * om
+		+ T(0.005) * sand * om
+		- T(0.013) * clay * om
+		+ T(0.068) * sand * clay
+		+ T(0.031);
 
-    float theta1500 = std::max(
-		0.01f,	// constrain
-		theta1500t + 0.14f * theta1500t - 0.02f );
+    T theta1500 = std::max(
+		T(0.01),	// constrain
+		theta1500t + T(0.14) * theta1500t - T(0.02) );
 
-    float const theta33t =
-		-0.251f * sand + 0.195f * clay + 0.011f * om
-		+ 0.006f * sand * om
-		- 0.027f * clay * om
-		+ 0.452f * sand * clay
-		+ 0.299f;
+    T const theta33t =
+		-T(0.251) * sand + T(0.195) * clay + T(0.011) * om
+		+ T(0.006) * sand * om
+		- T(0.027) * clay * om
+		+ T(0.452) * sand * clay
+		+ T(0.299);
 
-    float const theta33 = std::min(
-		0.80f,	// constrain
-		theta33t + 1.283f * theta33t * theta33t - 0.374f * theta33t - 0.015f);
+    T const theta33 = std::min(
+		T(0.80),	// constrain
+		theta33t + T(1.283) * theta33t * theta33t - T(0.374) * theta33t - T(0.015));
 
-    theta1500 = std::min( theta1500, 0.80f * theta33 );		// constrain
+    theta1500 = std::min( theta1500, T(0.80) * theta33 );		// constrain
 
-    float const thetaS33t =
-		0.278f * sand + 0.034f * clay + 0.022f * om
-		- 0.018f * sand * om
-		- 0.027f * clay * om
-		- 0.584f * sand * clay
-		+ 0.078f;
+    T const thetaS33t =
+		T(0.278) * sand + T(0.034) * clay + T(0.022) * om
+		- T(0.018) * sand * om
+		- T(0.027) * clay * om
+		- T(0.584) * sand * clay
+		+ T(0.078);
 
-    float const thetaS33 = thetaS33t + 0.636f * thetaS33t - 0.107f;
+    T const thetaS33 = thetaS33t + T(0.636) * thetaS33t - T(0.107);
 
-    float const thetaS = theta33 + thetaS33 - 0.097f * sand + 0.043f;
+    T const thetaS = theta33 + thetaS33 - T(0.097) * sand + T(0.043);
 
-    float const B = 3.816713f / ( std::log(theta33) - std::log(theta1500) );
+    T B, lamda, Ks;
+    if ( !fastMath )
+    {
+	B = T(3.816713) / ( std::log(theta33) - std::log(theta1500) );
 
-    float const lamda = 1.0f / B;
+	lamda = T(1.0) / B;
 
-    float const Ks = 1930.0f * std::pow( ( thetaS - theta33 ), (3.0f - lamda) ) / 36000.0;
+	// the division is done in double, as in the original float version
+	Ks = static_cast<T>(
+		T(1930.0) * std::pow( ( thetaS - theta33 ), (T(3.0) - lamda) ) / 36000.0 );
+    }
+    else
+    {
+	// one log for B; pow(x, y) = exp( y * log(x) )
+	// theta1500 <= 0 only if theta33 <= 0, when B is NaN above
+	lamda = ( theta1500 > T(0) ?
+		FastLog( theta33 / theta1500 ) * T(1.0 / 3.816713) :
+		std::numeric_limits<T>::quiet_NaN() );
+
+	B = T(1.0) / lamda;	// for DEBUG_SWCharEst only
+
+	Ks = T(1930.0 / 36000.0) * FastExp( (T(3.0) - lamda) * FastLog( thetaS - theta33 ) );
+    }
 
 #ifdef DEBUG_SWCharEst
     char const NL = '\n';
@@ -134,12 +518,168 @@ std::vector<float> & SWCharEst::Get (	// returns WP, FC, thetaS, Ks
 	 << endl;
 #endif
 
-    results[0] = theta1500;	// WP
-    results[1] = theta33;	// FC
-    results[2] = thetaS;	// thetaS
-    results[3] = Ks;		// Ks
-    return results;
+    props.WP = theta1500;
+    props.FC = theta33;
+    props.thetaS = thetaS;
+    props.Ks = Ks;
+    return props;
 }
 
+template
+<
+    typename T		// floating-point type
+>
+SWCharEst::TResults<T> SWCharEst::Evaluate (	// returns WP, FC, thetaS, Ks
+    T const sand,			// sand fraction (0-1)
+    T const clay,			// clay fraction (0-1)
+    T const ompc)			// organic matter wt %
+    noexcept
+{
+    return Estimate<T, false>( sand, clay, ompc );
+}
+
+SWCharEst::Results SWCharEst::EvaluateFast (	// returns WP, FC, thetaS, Ks
+    float const sand,			// sand fraction (0-1)
+    float const clay,			// clay fraction (0-1)
+    float const ompc)			// organic matter wt %
+    noexcept
+{
+    return Estimate<float, true>( sand, clay, ompc );
+}
+
+// explicit instantiations
+template bool SWCharEst::CheckArgs<float> ( float const, float const, float const ) noexcept;
+template bool SWCharEst::CheckArgs<double> ( double const, double const, double const ) noexcept;
+template SWCharEst::TResults<float> SWCharEst::Evaluate<float> (
+    float const, float const, float const ) noexcept;
+template SWCharEst::TResults<double> SWCharEst::Evaluate<double> (
+    double const, double const, double const ) noexcept;
+
+void SWCharEst::GetBatch (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks)			// output: sat. hydraulic conductivity
+{
+    GetBatch( n, sand, clay, ompc, wp, fc, thetaS, ks, 0 );
+}
+
+std::size_t SWCharEst::GetBatch (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks,			// output: sat. hydraulic conductivity
+    unsigned char * const status)	// output: InputStatus bits; may be null
+{
+    KernelFunction kernel = GetBatchPortable;
+    PackFunction pack = PackPortable;
+    UnpackFunction unpack = UnpackPortable;
+    switch ( BatchKernelInUse().load( std::memory_order_relaxed ) )
+    {
+#ifdef TEH_SWCHAREST_X86_KERNELS
+      case KernelAVX512:
+	kernel = SWCharEstSIMD::GetBatchAVX512;
+	pack = SWCharEstSIMD::PackAVX512;
+	unpack = SWCharEstSIMD::UnpackAVX512;
+	break;
+      case KernelAVX2:
+	kernel = SWCharEstSIMD::GetBatchAVX2;
+	pack = SWCharEstSIMD::PackAVX2;
+	unpack = SWCharEstSIMD::UnpackAVX2;
+	break;
+#endif
+      default:
+	break;
+    }
+    float const threshold = CompactionThreshold().load( std::memory_order_relaxed );
+    if ( !( threshold <= 1.0f ) )	// no compaction
+	return kernel( n, sand, clay, ompc, wp, fc, thetaS, ks, status );
+    return GetBatchCompacting( n, sand, clay, ompc, wp, fc, thetaS, ks, status,
+			       kernel, pack, unpack, threshold );
+}
+
+void SWCharEst::SetCompactionThreshold (
+    float const fraction )		// fraction of rejected soils
+{
+    CompactionThreshold().store( fraction );
+}
+
+float SWCharEst::GetCompactionThreshold ()
+{
+    return CompactionThreshold().load();
+}
+
+unsigned char SWCharEst::Status (
+    float const sand,			// sand fraction (0-1)
+    float const clay,			// clay fraction (0-1)
+    float const ompc)			// organic matter wt %
+    noexcept
+{
+    float const om = std::min ( 70.0f, ompc );
+    return static_cast<unsigned char>(
+	( !( sand >= 0.0f && sand <= 1.0f ) ? StatusSand : 0 ) |
+	( !( clay >= 0.0f && clay <= 1.0f ) ? StatusClay : 0 ) |
+	( !( om >= 0.0f ) ? StatusOM : 0 ) |
+	( !( sand + clay <= 1.0f ) ? StatusSandClay : 0 ) );
+}
+
+bool SWCharEst::SetBatchKernel (
+    BatchKernel const kernel )
+{
+    if ( kernel == KernelAuto )
+    {
+	BatchKernelInUse().store( FastestKernel() );
+	return true;
+    }
+    if ( !IsKernelSupported( kernel ) )
+	return false;
+    BatchKernelInUse().store( kernel );
+    return true;
+}
+
+SWCharEst::BatchKernel SWCharEst::GetBatchKernel ()
+{
+    return static_cast<BatchKernel>( BatchKernelInUse().load() );
+}
+
+bool SWCharEst::IsKernelSupported (
+    BatchKernel const kernel )
+{
+    switch ( kernel )
+    {
+      case KernelAuto:
+      case KernelPortable:
+	return true;
+#ifdef TEH_SWCHAREST_X86_KERNELS
+      case KernelAVX2:
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+      case KernelAVX512:
+	return __builtin_cpu_supports("avx512f");
+#endif
+      default:
+	return false;
+    }
+}
+
+char const * SWCharEst::KernelName (
+    BatchKernel const kernel )
+{
+    switch ( kernel )
+    {
+      case KernelAuto:		return "auto";
+      case KernelPortable:	return "portable";
+      case KernelAVX2:		return "avx2";
+      case KernelAVX512:	return "avx512";
+      default:			return "unknown";
+    }
+}
 
 } // namespace teh
@@ -33,6 +33,7 @@
 #define INC_teh_SWCharEst_h
 
 #include <vector>
+#include <cstddef>
 
 namespace teh {
 
@@ -41,6 +42,42 @@ namespace teh {
     {
       public:
 
+	/// Kernels which GetBatch can use.
+	enum BatchKernel
+	{
+	    KernelAuto,		///< fastest kernel the CPU supports
+	    KernelPortable,	///< portable C++
+	    KernelAVX2,		///< x86 AVX2 and FMA
+	    KernelAVX512	///< x86 AVX-512F
+	};
+
+	/// Bits of the input status of a soil in GetBatch;
+	/// zero if the inputs are valid.
+	enum InputStatus
+	{
+	    StatusOK = 0,		///< valid inputs
+	    StatusSand = 1,		///< sand is not in 0-1, or is NaN
+	    StatusClay = 2,		///< clay is not in 0-1, or is NaN
+	    StatusOM = 4,		///< OM is less than 0
+	    StatusSandClay = 8		///< sand + clay > 1, or is NaN
+	};
+
+	/// Calculated soil hydrologic properties.
+	template
+	<
+	    typename T		///< floating-point type
+	>
+	struct TResults
+	{
+	    T WP;		///< wilting point (volume fraction)
+	    T FC;		///< field capacity (volume fraction)
+	    T thetaS;		///< saturated water content (volume fraction)
+	    T Ks;		///< sat. hydraulic conductivity (cm/sec)
+	};
+
+	/// Calculated soil hydrologic properties, single precision.
+	typedef TResults<float> Results;
+
 	SWCharEst ()
 	  {
 	  }
@@ -59,16 +96,136 @@ namespace teh {
 	    return Get( soil[0], soil[1], soil[2] );
 	}
 
+	/// Returns WP, FC, thetaS, Ks; all are zero if the arguments are invalid.
+	/// Does not use an object or allocate memory, so is thread-safe.
+	/// Instantiated for float and double; the float version
+	/// gives the same results as Get.
+	template
+	<
+	    typename T				///< floating-point type
+	>
+	static TResults<T> Evaluate (
+	    T const sand,			///< sand fraction (0-1)
+	    T const clay,			///< clay fraction (0-1)
+	    T const ompc)			///< organic matter wt %
+	    noexcept;
+
+	/// Fast-math version of Evaluate.
+	/// WP, FC and thetaS are the same as Evaluate.
+	/// Ks uses one log for B, from the ratio theta33 / theta1500,
+	/// and calculates the power as exp( (3 - lamda) * log(thetaS - theta33) ),
+	/// with polynomial log and exp functions instead of the
+	/// standard library functions.
+	/// Ks relative error vs. Evaluate is less than 1e-5.
+	static Results EvaluateFast (
+	    float const sand,			///< sand fraction (0-1)
+	    float const clay,			///< clay fraction (0-1)
+	    float const ompc)			///< organic matter wt %
+	    noexcept;
+
+	/// Calculates WP, FC, thetaS, Ks for n soils.
+	/// Inputs and outputs are contiguous caller-owned arrays of length n.
+	/// Invalid inputs give zero results, as with Get.
+	/// Does not allocate memory.
+	/// Uses the kernel from GetBatchKernel.
+	static void GetBatch (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks);			///< output: sat. hydraulic conductivity
+
+	/// GetBatch, which also writes the input status of each soil,
+	/// a combination of InputStatus bits, to the status array.
+	/// Soils with a nonzero status have zero results.
+	/// Returns the number of soils with a nonzero status.
+	static std::size_t GetBatch (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks,			///< output: sat. hydraulic conductivity
+	    unsigned char * const status);	///< output: InputStatus bits; may be null
+
+	/// Default of SetCompactionThreshold.
+	static constexpr float defaultCompactionThreshold = 0.4f;
+
+	/// Sets when GetBatch evaluates only the valid soils.
+	/// GetBatch works in chunks of 512 soils. If the fraction of
+	/// soils in a chunk with a nonzero status is more than the threshold,
+	/// the soils of the next chunk are checked first, and only the valid
+	/// ones are evaluated, packed together; the results are unpacked.
+	/// Otherwise the kernel evaluates all soils in the next chunk.
+	/// This pays when invalid soils come in runs, as in rasters
+	/// with nodata.
+	/// 0 packs after every chunk with an invalid soil; more than 1 never packs.
+	/// The results are the same in either case.
+	static void SetCompactionThreshold (
+	    float const fraction );		///< fraction of rejected soils
+
+	/// Returns the threshold of SetCompactionThreshold.
+	static float GetCompactionThreshold ();
+
+	/// Returns the InputStatus bits of one soil, from the tests of GetBatch.
+	static unsigned char Status (
+	    float const sand,			///< sand fraction (0-1)
+	    float const clay,			///< clay fraction (0-1)
+	    float const ompc)			///< organic matter wt %
+	    noexcept;
+
+	/// Selects the GetBatch kernel for all threads.
+	/// KernelAuto selects the fastest kernel the CPU supports.
+	/// Returns false, and keeps the current kernel,
+	/// if the CPU does not support the kernel.
+	/// At startup the fastest kernel is selected, unless the environment
+	/// variable SWCHAREST_KERNEL is "portable", "avx2" or "avx512".
+	static bool SetBatchKernel (
+	    BatchKernel const kernel );
+
+	/// Returns the kernel that GetBatch uses; never KernelAuto.
+	static BatchKernel GetBatchKernel ();
+
+	/// Returns true if the CPU supports the kernel.
+	static bool IsKernelSupported (
+	    BatchKernel const kernel );
+
+	/// Returns the name of the kernel; the SWCHAREST_KERNEL values.
+	static char const * KernelName (
+	    BatchKernel const kernel );
+
 	static void Usage ();
 
       private:
 
 	std::vector<float> results;	// calculated WP, FC, thetaS, Ks
 
-	bool CheckArgs (
-	    float const sand,		// sand fraction (0-1)
-	    float const clay,		// clay fraction (0-1)
-	    float const ompc);		// organic matter wt %
+	template
+	<
+	    typename T			// floating-point type
+	>
+	static bool CheckArgs (
+	    T const sand,		// sand fraction (0-1)
+	    T const clay,		// clay fraction (0-1)
+	    T const ompc)		// organic matter wt %
+	    noexcept;
+
+	// Evaluate and EvaluateFast
+	template
+	<
+	    typename T,			// floating-point type
+	    bool fastMath		// use EvaluateFast's log, exp
+	>
+	static TResults<T> Estimate (
+	    T const sand,		// sand fraction (0-1)
+	    T const clay,		// clay fraction (0-1)
+	    T const ompc)		// organic matter wt %
+	    noexcept;
 
 	// not used
 	SWCharEst (SWCharEst const & rhs);
@@ -0,0 +1,145 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstAggregate.cpp
+// class	teh::SWCharEstAggregate
+// brief 	Component-weighted results of map units, in one streaming pass.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstAggregate.h"
+#include "SWCharEst.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Number of components per block in Add.
+    // The block work arrays fit in the L1 cache.
+    std::size_t const blockSize = 256;
+
+} // namespace
+
+
+SWCharEstAggregate::SWCharEstAggregate ()
+    : started ( false )
+{
+    Start( 0 );
+}
+
+void SWCharEstAggregate::Start (
+    int32_t const mukey )
+{
+    current.mukey = mukey;
+    current.numComponents = current.numValid = 0;
+    current.weight = 0.0;
+    current.wp = current.fc = current.thetaS = current.ks = 0.0;
+    current.ksWeight = 0.0;
+    current.logKsWeight = current.logKs = 0.0;
+}
+
+SWCharEstAggregate::MapUnit SWCharEstAggregate::Means () const
+{
+    MapUnit m;
+    m.mukey = current.mukey;
+    m.numComponents = current.numComponents;
+    m.numValid = current.numValid;
+    m.weight = current.weight;
+    double const w = ( current.weight > 0.0 ? 1.0 / current.weight : 0.0 );
+    m.wp = static_cast<float>( current.wp * w );
+    m.fc = static_cast<float>( current.fc * w );
+    m.thetaS = static_cast<float>( current.thetaS * w );
+    m.ks = ( current.ksWeight > 0.0
+	     ? static_cast<float>( current.ks / current.ksWeight )
+	     : 0.0f );
+    m.ksLogMean = ( current.logKsWeight > 0.0
+		    ? static_cast<float>( std::exp( current.logKs / current.logKsWeight ) )
+		    : 0.0f );
+    return m;
+}
+
+std::size_t SWCharEstAggregate::Add (
+    std::size_t const n,		// number of component rows
+    int32_t const * const mukey,	// map-unit key of each component
+    float const * const comppct,	// percent of the map unit
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    std::vector<MapUnit> & mapUnits )	// output: finished map units
+{
+    float wp[blockSize], fc[blockSize], thetaS[blockSize], ks[blockSize];
+    unsigned char status[blockSize];
+
+    std::size_t const size = mapUnits.size();
+    for ( std::size_t start = 0; start < n; start += blockSize )
+    {
+	std::size_t const m = std::min( blockSize, n - start );
+	SWCharEst::GetBatch( m, sand + start, clay + start, ompc + start,
+			     wp, fc, thetaS, ks, status );
+	for ( std::size_t j = 0; j < m; ++j )
+	{
+	    std::size_t const i = start + j;
+	    if ( !started || mukey[i] != current.mukey )
+	    {
+		if ( started )
+		    mapUnits.push_back( Means() );
+		Start( mukey[i] );
+		started = true;
+	    }
+	    ++current.numComponents;
+	    double const w = comppct[i];
+	    if ( status[j] != 0 || !( w > 0.0 ) )
+		continue;
+	    ++current.numValid;
+	    current.weight += w;
+	    current.wp += w * wp[j];
+	    current.fc += w * fc[j];
+	    current.thetaS += w * thetaS[j];
+	    if ( std::isfinite( ks[j] ) )
+	    {
+		current.ksWeight += w;
+		current.ks += w * ks[j];
+	    }
+	    if ( ks[j] > 0.0f )
+	    {
+		current.logKsWeight += w;
+		current.logKs += w * std::log( static_cast<double>( ks[j] ) );
+	    }
+	}
+    }
+    return mapUnits.size() - size;
+}
+
+std::size_t SWCharEstAggregate::Finish (
+    std::vector<MapUnit> & mapUnits )	// output: finished map units
+{
+    if ( !started )
+	return 0;
+    mapUnits.push_back( Means() );
+    Start( 0 );
+    started = false;
+    return 1;
+}
+
+std::vector<SWCharEstAggregate::MapUnit> SWCharEstAggregate::Aggregate (
+    std::size_t const n,		// number of component rows
+    int32_t const * const mukey,	// map-unit key of each component
+    float const * const comppct,	// percent of the map unit
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc )		// organic matter wt %
+{
+    std::vector<MapUnit> mapUnits;
+    SWCharEstAggregate aggregate;
+    aggregate.Add( n, mukey, comppct, sand, clay, ompc, mapUnits );
+    aggregate.Finish( mapUnits );
+    return mapUnits;
+}
+
+} // namespace teh
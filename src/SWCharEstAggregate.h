@@ -0,0 +1,124 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstAggregate.h
+@class		teh::SWCharEstAggregate
+@brief 		Component-weighted results of map units, in one streaming pass.
+@details {
+		SSURGO-style map units have several components, each with
+		a percent share (comppct) of the map unit.
+		Add takes component rows (mukey, comppct, sand, clay, OM),
+		grouped by mukey, evaluates them in blocks with
+		SWCharEst::GetBatch, and accumulates the weighted sums
+		of the current map unit; when the key changes, the map
+		unit is finished and appended to the output.
+		The rows may be added in any number of calls, so a map unit
+		may span calls; Finish appends the last map unit.
+		Only the sums of the current map unit are kept.
+		The results of a map unit are the means of its valid
+		components, weighted by comppct: components with invalid
+		inputs or comppct <= 0 are left out.
+		The equations give a NaN Ks for some soils with much
+		clay and OM, such as sand 0.14, clay 0.86, OM 8%, which
+		are otherwise valid; ks is the weighted mean of Ks of the
+		valid components with a finite Ks, so that it is not NaN.
+		KsLogMean is the weighted geometric mean of Ks,
+		exp( sum( w * ln(Ks) ) / sum( w ) ), of the valid
+		components with Ks > 0.
+		A map unit with no valid components has zero results.
+		Sums are in double precision.
+}
+@example {
+	Example:
+	    teh::SWCharEstAggregate aggregate;
+	    std::vector<teh::SWCharEstAggregate::MapUnit> mapUnits;
+	    while ( ...read a chunk of component rows... )
+		aggregate.Add( n, &mukey[0], &comppct[0], &sand[0], &clay[0], &ompc[0],
+			       mapUnits );
+	    aggregate.Finish( mapUnits );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstAggregate_h
+#define INC_teh_SWCharEstAggregate_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstAggregate
+    {
+      public:
+
+	/// Component-weighted results of one map unit.
+	struct MapUnit
+	{
+	    int32_t mukey;		///< map-unit key
+	    unsigned numComponents;	///< number of component rows
+	    unsigned numValid;		///< components in the means
+	    double weight;		///< sum of comppct of the valid components
+	    float wp;			///< wilting point
+	    float fc;			///< field capacity
+	    float thetaS;		///< saturated water content
+	    float ks;			///< sat. hydraulic conductivity, arithmetic mean of finite Ks
+	    float ksLogMean;		///< sat. hydraulic conductivity, geometric mean
+	};
+
+	SWCharEstAggregate ();
+
+	/// Adds n component rows, grouped by mukey; appends the
+	/// finished map units to mapUnits, and returns their number.
+	std::size_t Add (
+	    std::size_t const n,		///< number of component rows
+	    int32_t const * const mukey,	///< map-unit key of each component
+	    float const * const comppct,	///< percent of the map unit
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    std::vector<MapUnit> & mapUnits );	///< output: finished map units
+
+	/// Appends the last map unit, if any, and starts again;
+	/// returns the number appended.
+	std::size_t Finish (
+	    std::vector<MapUnit> & mapUnits );	///< output: finished map units
+
+	/// Add and Finish for a whole table.
+	static std::vector<MapUnit> Aggregate (
+	    std::size_t const n,		///< number of component rows
+	    int32_t const * const mukey,	///< map-unit key of each component
+	    float const * const comppct,	///< percent of the map unit
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc );		///< organic matter wt %
+
+      private:
+
+	// sums of the current map unit
+	struct Sums
+	{
+	    int32_t mukey;
+	    unsigned numComponents;
+	    unsigned numValid;
+	    double weight;
+	    double wp, fc, thetaS, ks;
+	    double ksWeight;		// weight of components with a finite Ks
+	    double logKsWeight;		// weight of components with Ks > 0
+	    double logKs;
+	};
+
+	bool started;			// true if current has a map unit
+	Sums current;
+
+	void Start ( int32_t const mukey );
+	MapUnit Means () const;
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstAggregate_h
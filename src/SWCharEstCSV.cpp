@@ -0,0 +1,550 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstCSV.cpp
+// class	teh::SWCharEstCSV
+// brief 	Streams rows of sand, clay and OM from CSV text to rows of results.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstCSV.h"
+#include "SWCharEst.h"
+#include "SWCharEstText.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Bytes read at a time; the buffer grows only for a longer line.
+    std::size_t const readSize = 1 << 18;
+
+    // Bytes scanned by each call of FindSeparators.
+    std::size_t const segmentSize = 1 << 16;
+
+    // Bytes of a mapped file parsed by each task of RunFile.
+    std::size_t const chunkSize = 1 << 20;
+
+    // Chunks per worker thread held in memory at once by RunFile.
+    std::size_t const chunksPerWorker = 4;
+
+    // Rows per call of GetBatch.
+    std::size_t const batchSize = 4096;
+
+    char const * const outputNames[4] = { "wp", "fc", "thetaS", "ks" };
+
+    // Returns the end of the field starting at p: the next delimiter,
+    // outside of quotes, or the end of the line.
+    char const * FieldEnd (
+	char const * p,
+	char const * const end,
+	char const delimiter )
+    {
+	if ( p < end && *p == '"' )
+	{
+	    for ( ++p; p < end; ++p )
+	    {
+		if ( *p == '"' && ( ++p == end || *p != '"' ) )	// "" is a quote
+		    break;
+	    }
+	}
+	char const * const d = static_cast<char const *>(
+	    std::memchr( p, delimiter, end - p ) );
+	return ( d != 0 ? d : end );
+    }
+
+    inline bool IsSpace ( char const c )
+    {
+	return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Removes spaces, and a pair of quotes, from the ends of a field.
+    inline void Trim (
+	char const * & b,
+	char const * & e )
+    {
+	while ( b < e && IsSpace( *b ) )
+	    ++b;
+	while ( e > b && IsSpace( e[-1] ) )
+	    --e;
+	if ( e - b >= 2 && *b == '"' && e[-1] == '"' )
+	{
+	    ++b;
+	    --e;
+	    Trim( b, e );
+	}
+    }
+
+    // Returns the number in the field, or NaN if it is not a number.
+    inline float ParseField (
+	char const * b,
+	char const * e )
+    {
+	Trim( b, e );
+	float value;
+	if ( !SWCharEstText::ParseFloat( b, e, value ) )
+	    return std::numeric_limits<float>::quiet_NaN();
+	return value;
+    }
+
+    bool IsBlank (
+	char const * b,
+	char const * const e )
+    {
+	for ( ; b < e; ++b )
+	    if ( !IsSpace( *b ) )
+		return false;
+	return true;
+    }
+
+    // Returns the column number, from 1, or 0 if it is not a number.
+    long ColumnNumber (
+	std::string const & column )
+    {
+	if ( column.empty() || column.size() > 9 ||
+	     column.find_first_not_of( "0123456789" ) != std::string::npos )
+	    return 0;
+	return std::atol( column.c_str() );
+    }
+
+    std::string Lower (
+	std::string s )
+    {
+	for ( std::size_t i = 0; i < s.size(); ++i )
+	    s[i] = static_cast<char>( std::tolower( static_cast<unsigned char>( s[i] ) ) );
+	return s;
+    }
+
+    // Finds the first line in text[begin, end) which is not blank;
+    // returns false if there is none, or if it has no newline, unless
+    // it is the last of the text. Blank lines before it are skipped.
+    bool FindHeader (
+	char const * const text,
+	std::size_t & begin,
+	std::size_t const end,
+	bool const last,
+	std::size_t & lineEnd )
+    {
+	while ( begin < end )
+	{
+	    char const * const newline = static_cast<char const *>(
+		std::memchr( text + begin, '\n', end - begin ) );
+	    if ( newline == 0 && !last )
+		return false;
+	    lineEnd = ( newline != 0 ? newline - text : end );
+	    if ( !IsBlank( text + begin, text + lineEnd ) )
+		return true;
+	    begin = ( newline != 0 ? lineEnd + 1 : end );
+	}
+	return false;
+    }
+
+    void WriteHeader (
+	std::ostream & os,
+	char const delimiter )
+    {
+	for ( std::size_t k = 0; k < 4; ++k )
+	{
+	    os << outputNames[k];
+	    os.put( k < 3 ? delimiter : '\n' );
+	}
+    }
+
+    // Reads the rows of a range of text, and evaluates and formats
+    // them in batches. Each thread has its own.
+    class RowParser
+    {
+      public:
+
+	RowParser (
+	    int const * const inputColumns,	// index of sand, clay, om
+	    char const fieldDelimiter )
+	    : numRows ( 0 ),
+	      numInvalid ( 0 ),
+	      columns ( inputColumns ),
+	      delimiter ( fieldDelimiter ),
+	      inputs ( 3 * batchSize ),
+	      outputs ( 4 * batchSize ),
+	      status ( batchSize ),
+	      digits ( 4 * batchSize ),
+	      exponents ( 4 * batchSize ),
+	      text ( 4 * batchSize * ( SWCharEstText::maxFormatted + 1 ) ),
+	      positions ( segmentSize ),
+	      m ( 0 )
+	  {
+	  }
+
+	// Converts the complete lines of text, and the last line
+	// if last is true, appending the results to output;
+	// returns the size of the lines converted.
+	std::size_t Parse (
+	    char const * const text,
+	    std::size_t const size,
+	    bool const last,
+	    std::vector<char> & output );
+
+	std::size_t numRows;
+	std::size_t numInvalid;
+
+      private:
+
+	int const * const columns;
+	char const delimiter;
+	std::vector<float> inputs, outputs;
+	std::vector<unsigned char> status;
+	std::vector<uint32_t> digits;		// of the outputs, from FindDigits
+	std::vector<int> exponents;
+	std::vector<char> text;			// formatted batch
+	std::vector<uint32_t> positions;
+	std::size_t m;				// rows in the batch
+
+	void WriteBatch ( std::vector<char> & output );
+    };
+
+    std::size_t RowParser::Parse (
+	char const * const t,
+	std::size_t const size,
+	bool const last,
+	std::vector<char> & output )
+    {
+	float * const sand = &inputs[0];
+	float * const clay = sand + batchSize;
+	float * const ompc = clay + batchSize;
+	float const nan = std::numeric_limits<float>::quiet_NaN();
+	std::size_t begin = 0;			// start of the line
+	std::size_t fieldBegin = 0;
+	int column = 0;
+	bool quoted = false;
+	sand[m] = clay[m] = ompc[m] = nan;
+
+	// Ends the field at offset at, and the line if endOfLine.
+	auto const EndField = [&] ( std::size_t const at, bool const endOfLine )
+	{
+	    if ( column == columns[0] )
+		sand[m] = ParseField( t + fieldBegin, t + at );
+	    else if ( column == columns[1] )
+		clay[m] = ParseField( t + fieldBegin, t + at );
+	    else if ( column == columns[2] )
+		ompc[m] = ParseField( t + fieldBegin, t + at );
+	    fieldBegin = at + 1;
+	    if ( !endOfLine )
+	    {
+		++column;
+		return;
+	    }
+	    bool const blank = ( column == 0 && IsBlank( t + begin, t + at ) );
+	    begin = at + 1;
+	    column = 0;
+	    quoted = false;
+	    if ( !blank )
+	    {
+		if ( ompc[m] != ompc[m] )	// NaN OM is clamped to 70; NaN sand is invalid
+		    sand[m] = ompc[m];
+		if ( ++m == batchSize )
+		    WriteBatch( output );
+	    }
+	    sand[m] = clay[m] = ompc[m] = nan;
+	};
+
+	// rows from the positions of the separators
+	for ( std::size_t segment = 0; segment < size; segment += segmentSize )
+	{
+	    std::size_t const numPositions = SWCharEstText::FindSeparators(
+		t + segment, std::min( segmentSize, size - segment ), delimiter, &positions[0] );
+	    for ( std::size_t j = 0; j < numPositions; ++j )
+	    {
+		std::size_t const at = segment + positions[j];
+		char const c = t[at];
+		if ( c == '"' )
+		    quoted = !quoted;
+		else if ( c != delimiter || !quoted )
+		    EndField( at, c != delimiter );
+	    }
+	}
+	if ( last && begin < size )		// no newline after the last line
+	{
+	    EndField( size, true );
+	    begin = size;
+	}
+	if ( m > 0 )
+	    WriteBatch( output );
+	return begin;
+    }
+
+    // Evaluates the rows of the batch, and appends the results to output.
+    void RowParser::WriteBatch (
+	std::vector<char> & output )
+    {
+	float * const r = &outputs[0];
+	numInvalid += SWCharEst::GetBatch( m, &inputs[0], &inputs[batchSize], &inputs[2 * batchSize],
+					   r, r + batchSize, r + 2 * batchSize, r + 3 * batchSize,
+					   &status[0] );
+	numRows += m;
+	for ( std::size_t k = 0; k < 4; ++k )
+	    SWCharEstText::FindDigits( m, r + k * batchSize,
+				       &digits[k * batchSize], &exponents[k * batchSize] );
+	char * const begin = &text[0];
+	char * p = begin;
+	for ( std::size_t i = 0; i < m; ++i )
+	{
+	    for ( std::size_t k = 0; k < 4; ++k )
+	    {
+		std::size_t const j = k * batchSize + i;
+		p = SWCharEstText::FormatDigits( r[j], digits[j], exponents[j], p );
+		*p++ = ( k < 3 ? delimiter : '\n' );
+	    }
+	}
+	output.insert( output.end(), begin, p );
+	m = 0;
+    }
+
+} // namespace
+
+
+SWCharEstCSV::SWCharEstCSV (
+    std::string const & sandColumn,	// column of sand fractions (0-1)
+    std::string const & clayColumn,	// column of clay fractions (0-1)
+    std::string const & omColumn,	// column of organic matter wt %
+    char const fieldDelimiter,		// field delimiter
+    bool const hasHeader )		// true if the input has a header
+    : columnNames { sandColumn, clayColumn, omColumn },
+      delimiter ( fieldDelimiter ),
+      header ( hasHeader ),
+      numRows ( 0 ),
+      numInvalid ( 0 )
+{
+    columns[0] = columns[1] = columns[2] = -1;
+}
+
+// Finds the index of each input column, by number, or by name
+// in the header line, if line is not null.
+bool SWCharEstCSV::FindColumns (
+    char const * const line,
+    char const * const end )
+{
+    std::vector<std::string> names;
+    if ( line != 0 )
+    {
+	char const * b = line;
+	if ( end - b >= 3 && std::memcmp( b, "\xEF\xBB\xBF", 3 ) == 0 )	// UTF-8 BOM
+	    b += 3;
+	for ( ;; )
+	{
+	    char const * const fieldEnd = FieldEnd( b, end, delimiter );
+	    char const * nb = b;
+	    char const * ne = fieldEnd;
+	    Trim( nb, ne );
+	    names.push_back( Lower( std::string( nb, ne ) ) );
+	    if ( fieldEnd == end )
+		break;
+	    b = fieldEnd + 1;
+	}
+    }
+
+    for ( int k = 0; k < 3; ++k )
+    {
+	long const number = ColumnNumber( columnNames[k] );
+	if ( number > 0 )
+	{
+	    columns[k] = static_cast<int>( number - 1 );
+	    continue;
+	}
+	std::vector<std::string>::const_iterator const i =
+	    std::find( names.begin(), names.end(), Lower( columnNames[k] ) );
+	if ( i == names.end() )
+	{
+	    errorMessage = "SWCharEstCSV: column \"" + columnNames[k] + "\" " +
+			   ( line != 0 ? "is not in the header"
+				       : "must be a number from 1 without a header" );
+	    return false;
+	}
+	columns[k] = static_cast<int>( i - names.begin() );
+    }
+    return true;
+}
+
+bool SWCharEstCSV::Run (
+    std::istream & is,		// input text
+    std::ostream & os )		// output text
+{
+    numRows = numInvalid = 0;
+    errorMessage.clear();
+    bool columnsFound = !header && FindColumns( 0, 0 );
+    if ( !header && !columnsFound )
+	return false;
+
+    RowParser parser ( columns, delimiter );
+    std::vector<char> buffer ( readSize ), output;
+    std::size_t begin = 0;		// start of the unread text in buffer
+    std::size_t end = 0;		// end of the text in buffer
+    bool eof = false;
+    while ( !eof )
+    {
+	// keep the partial line, and read more
+	std::copy( buffer.begin() + begin, buffer.begin() + end, buffer.begin() );
+	end -= begin;
+	begin = 0;
+	if ( end == buffer.size() )	// a line longer than the buffer
+	    buffer.resize( 2 * buffer.size() );
+	is.read( &buffer[end], buffer.size() - end );
+	end += static_cast<std::size_t>( is.gcount() );
+	if ( is.bad() || ( !is && !is.eof() ) )
+	{
+	    errorMessage = "SWCharEstCSV: reading failed";
+	    return false;
+	}
+	eof = is.eof();
+
+	char const * const t = &buffer[0];
+	if ( !columnsFound )
+	{
+	    std::size_t lineEnd;
+	    if ( !FindHeader( t, begin, end, eof, lineEnd ) )
+		continue;
+	    if ( !FindColumns( t + begin, t + lineEnd ) )
+		return false;
+	    columnsFound = true;
+	    WriteHeader( os, delimiter );
+	    begin = std::min( lineEnd + 1, end );
+	}
+	begin += parser.Parse( t + begin, end - begin, eof, output );
+	numRows = parser.numRows;
+	numInvalid = parser.numInvalid;
+	if ( !output.empty() && !os.write( &output[0], output.size() ) )
+	    break;
+	output.clear();
+    }
+
+    if ( !os.flush() )
+    {
+	errorMessage = "SWCharEstCSV: writing failed";
+	return false;
+    }
+    return true;
+}
+
+bool SWCharEstCSV::RunFile (
+    std::string const & fileName,	// input file
+    std::ostream & os,			// output text
+    ThreadPool & pool )			// threads which parse the chunks
+{
+    numRows = numInvalid = 0;
+    errorMessage.clear();
+    MappedFile const file ( fileName );
+    if ( !file.IsOpen() )		// a pipe, perhaps
+    {
+	std::ifstream is ( fileName.c_str(), std::ios::binary );
+	if ( !is.is_open() )
+	{
+	    errorMessage = "SWCharEstCSV: cannot open " + fileName;
+	    return false;
+	}
+	return Run( is, os );
+    }
+
+    char const * const t = file.Data();
+    std::size_t const size = file.Size();
+    std::size_t begin = 0;		// start of the rows
+    if ( header )
+    {
+	std::size_t lineEnd;
+	if ( !FindHeader( t, begin, size, true, lineEnd ) )
+	    return true;		// empty
+	if ( !FindColumns( t + begin, t + lineEnd ) )
+	    return false;
+	WriteHeader( os, delimiter );
+	begin = std::min( lineEnd + 1, size );
+    }
+    else if ( !FindColumns( 0, 0 ) )
+	return false;
+
+    // chunks of whole lines
+    std::vector<std::size_t> bounds ( 1, begin );
+    while ( bounds.back() < size )
+    {
+	std::size_t b = bounds.back() + chunkSize;
+	if ( b < size )
+	{
+	    char const * const newline = static_cast<char const *>(
+		std::memchr( t + b, '\n', size - b ) );
+	    b = ( newline != 0 ? newline - t + 1 : size );
+	}
+	bounds.push_back( std::min( b, size ) );
+    }
+    std::size_t const numChunks = bounds.size() - 1;
+
+    std::vector<RowParser> parsers;
+    parsers.reserve( pool.NumThreads() );
+    for ( unsigned w = 0; w < pool.NumThreads(); ++w )
+	parsers.push_back( RowParser( columns, delimiter ) );
+
+    // The chunks are taken in order, in groups which bound the memory used.
+    // The output of a chunk is written when it and all before it are done,
+    // by one thread at a time, while the others go on parsing.
+    std::size_t const groupSize = chunksPerWorker * pool.NumThreads();
+    std::vector< std::vector<char> > outputs ( groupSize );
+    std::vector<char> done ( groupSize );
+    std::mutex mutex;
+    std::size_t next = 0;		// next output to write
+    bool writing = false;
+    bool failed = false;
+    for ( std::size_t first = 0; first < numChunks && !failed; first += groupSize )
+    {
+	std::size_t const n = std::min( groupSize, numChunks - first );
+	std::fill( done.begin(), done.end(), 0 );
+	next = 0;
+	pool.Run( n, [&] ( std::size_t const task, unsigned const worker )
+	{
+	    std::size_t const chunk = first + task;
+	    parsers[worker].Parse( t + bounds[chunk], bounds[chunk + 1] - bounds[chunk],
+				   true, outputs[task] );
+
+	    std::unique_lock<std::mutex> lock ( mutex );
+	    done[task] = 1;
+	    if ( writing )		// the writer will find this one
+		return;
+	    writing = true;
+	    while ( next < n && done[next] )
+	    {
+		std::vector<char> & output = outputs[next];
+		lock.unlock();
+		bool const ok = output.empty() ||
+				os.write( &output[0], output.size() ).good();
+		output.clear();
+		lock.lock();
+		failed = failed || !ok;
+		++next;
+	    }
+	    writing = false;
+	} );
+    }
+
+    for ( std::size_t w = 0; w < parsers.size(); ++w )
+    {
+	numRows += parsers[w].numRows;
+	numInvalid += parsers[w].numInvalid;
+    }
+    if ( failed || !os.flush() )
+    {
+	errorMessage = "SWCharEstCSV: writing failed";
+	return false;
+    }
+    return true;
+}
+
+} // namespace teh
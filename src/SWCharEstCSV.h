@@ -0,0 +1,124 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstCSV.h
+@class		teh::SWCharEstCSV
+@brief 		Streams rows of sand, clay and OM from CSV text to rows of results.
+@details {
+		Run reads delimited text from a stream, evaluates the rows
+		with SWCharEst::GetBatch in batches, and writes a row of
+		wp, fc, thetaS and ks for each input row, in the same order.
+		The memory used does not depend on the size of the input:
+		the text is read in blocks, and the rows of a batch are
+		written before the next batch is read.
+		The columns of sand, clay and OM are given by name,
+		found in the header line (case is ignored), or by
+		number, from 1; without a header, numbers must be used.
+		The defaults are the names "sand", "clay" and "om".
+		The output has a header if the input has one.
+		Fields may be quoted, and lines may end with CR LF;
+		blank lines are skipped. A field which is empty, missing
+		or not a number is NaN, and so the row is invalid,
+		with zero results, as in GetBatch.
+		The separators of each block of text are found with
+		SWCharEstText::FindSeparators, and the numbers are read and
+		written with SWCharEstText::ParseFloat and FormatFloat:
+		results have the fewest digits which read back as the
+		same floats.
+		RunFile converts a file with the threads of a ThreadPool.
+		The file is mapped into memory with MappedFile, and the
+		rows after the header are split into chunks of about
+		1 MB, each ending at a newline, which are parsed and
+		evaluated by the threads in parallel. The output of
+		each chunk is written when it and all chunks before it
+		are done, so the rows are in the same order as with Run,
+		and the text is the same. A few chunks per thread are
+		held at once, so the memory used is bounded.
+		A file which cannot be mapped, such as a pipe,
+		is read with Run.
+		Run and RunFile return false, with a message from
+		ErrorMessage, if a column is not found, or reading
+		or writing fails.
+}
+@example {
+	Example:
+	    teh::SWCharEstCSV csv;			// columns sand, clay, om
+	    if ( !csv.Run( std::cin, std::cout ) )
+		std::cerr << csv.ErrorMessage() << std::endl;
+
+	Example - a large file, with all hardware threads:
+	    teh::ThreadPool pool;
+	    if ( !csv.RunFile( "soils.csv", std::cout, pool ) )
+		std::cerr << csv.ErrorMessage() << std::endl;
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstCSV_h
+#define INC_teh_SWCharEstCSV_h
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+namespace teh {
+
+
+    class ThreadPool;
+
+    class SWCharEstCSV
+    {
+      public:
+
+	/// Columns are names in the header, or numbers from 1.
+	SWCharEstCSV (
+	    std::string const & sandColumn = "sand",	///< column of sand fractions (0-1)
+	    std::string const & clayColumn = "clay",	///< column of clay fractions (0-1)
+	    std::string const & omColumn = "om",	///< column of organic matter wt %
+	    char const delimiter = ',',			///< field delimiter
+	    bool const header = true );			///< true if the input has a header
+
+	/// Converts the rows of is, writing the results to os;
+	/// returns false if failed.
+	bool Run (
+	    std::istream & is,		///< input text
+	    std::ostream & os );	///< output text
+
+	/// Converts the rows of a file in parallel, writing the
+	/// results to os in order; returns false if failed.
+	bool RunFile (
+	    std::string const & fileName,	///< input file
+	    std::ostream & os,			///< output text
+	    ThreadPool & pool );		///< threads which parse the chunks
+
+	/// Message of the failure of the last Run or RunFile.
+	std::string const & ErrorMessage () const { return errorMessage; }
+
+	/// Number of rows of the last Run or RunFile.
+	std::size_t NumRows () const { return numRows; }
+
+	/// Number of rows with invalid inputs of the last Run or RunFile.
+	std::size_t NumInvalid () const { return numInvalid; }
+
+	char Delimiter () const { return delimiter; }
+	bool HasHeader () const { return header; }
+
+      private:
+
+	std::string const columnNames[3];	// sand, clay, om
+	char const delimiter;
+	bool const header;
+
+	int columns[3];				// index from 0 of each input
+	std::size_t numRows;
+	std::size_t numInvalid;
+	std::string errorMessage;
+
+	bool FindColumns ( char const * const line, char const * const end );
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstCSV_h
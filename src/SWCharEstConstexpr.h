@@ -0,0 +1,235 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstConstexpr.h
+@class		teh::SWCharEstConstexpr
+@brief 		Compile-time evaluation of the Saxton & Rawls equations.
+@details {
+		The functions are constexpr, so values and tables can be
+		calculated by the compiler and stored in read-only data,
+		with no initialization at run time.
+		The log, exp and pow functions are series approximations
+		calculated in double precision, accurate to a few ulp.
+		Results agree with SWCharEst::Evaluate to within
+		1e-6 (relative), but may differ in the last bit.
+		Requires C++14.
+}
+@example {
+	Example - compile-time table of USDA texture classes, OM = 2.5%:
+	    constexpr teh::SWCharEstConstexpr::TextureClassTable table =
+		teh::SWCharEstConstexpr::TextureClasses();
+	    static_assert( table[0].props.FC > 0.09f, "sand FC" );
+
+	Example - silt loam:
+	    constexpr teh::SWCharEst::Results r =
+		teh::SWCharEstConstexpr::Evaluate( 0.15f, 0.18f, 3.05f );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstConstexpr_h
+#define INC_teh_SWCharEstConstexpr_h
+
+#include "SWCharEst.h"
+#include "SWCharEstMatrix.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace teh {
+
+
+    class SWCharEstConstexpr
+    {
+      public:
+
+	/// Number of USDA soil texture classes.
+	static std::size_t const numTextureClasses = 12;
+
+	/// A USDA soil texture class and its estimated properties.
+	struct TextureClass
+	{
+	    char const * name;		///< texture class name
+	    float sand;			///< sand fraction (0-1)
+	    float clay;			///< clay fraction (0-1)
+	    float ompc;			///< organic matter wt %
+	    SWCharEst::Results props;	///< WP, FC, thetaS, Ks
+	};
+
+	/// Table of the USDA soil texture classes.
+	struct TextureClassTable
+	{
+	    TextureClass classes[numTextureClasses];
+
+	    constexpr TextureClass const & operator[] (
+		std::size_t const i ) const
+	    {
+		return classes[i];
+	    }
+	};
+
+	/// Natural log; NaN if x < 0, -inf if x = 0.
+	static constexpr double Log (
+	    double x )
+	{
+	    if ( x != x || x < 0.0 )
+		return std::numeric_limits<double>::quiet_NaN();
+	    if ( x == 0.0 )
+		return -std::numeric_limits<double>::infinity();
+	    if ( x > std::numeric_limits<double>::max() )
+		return x;
+	    // x = m * 2^e, sqrt(0.5) <= m < sqrt(2)
+	    int e = 0;
+	    while ( x >= sqrt2 )
+	    {
+		x *= 0.5;
+		++e;
+	    }
+	    while ( x < 0.5 * sqrt2 )
+	    {
+		x *= 2.0;
+		--e;
+	    }
+	    // log(m) = 2 * atanh( (m - 1) / (m + 1) ); |z| < 0.172
+	    double const z = (x - 1.0) / (x + 1.0);
+	    double const z2 = z * z;
+	    double term = z;
+	    double sum = 0.0;
+	    for ( int k = 1; k < 40; k += 2 )
+	    {
+		sum += term / k;
+		term *= z2;
+	    }
+	    return 2.0 * sum + e * ln2;
+	}
+
+	/// Exponential function; zero on underflow, inf on overflow.
+	static constexpr double Exp (
+	    double const x )
+	{
+	    if ( x != x )
+		return x;
+	    if ( x > 709.78 )
+		return std::numeric_limits<double>::infinity();
+	    if ( x < -745.2 )
+		return 0.0;
+	    // exp(x) = 2^k * exp(r), |r| <= ln2 / 2
+	    int k = static_cast<int>( x / ln2 + ( x < 0.0 ? -0.5 : 0.5 ) );
+	    double const r = x - k * ln2;
+	    double term = 1.0;
+	    double sum = 1.0;
+	    for ( int n = 1; n < 25; ++n )
+	    {
+		term *= r / n;
+		sum += term;
+	    }
+	    for ( ; k > 0; --k )
+		sum *= 2.0;
+	    for ( ; k < 0; ++k )
+		sum *= 0.5;
+	    return sum;
+	}
+
+	/// x to the power y, for x >= 0.
+	static constexpr double Pow (
+	    double const x,
+	    double const y )
+	{
+	    if ( x == 0.0 )
+		return ( y > 0.0 ? 0.0 : std::numeric_limits<double>::infinity() );
+	    return Exp( y * Log(x) );
+	}
+
+	/// Returns WP, FC, thetaS, Ks; all are zero if the arguments are invalid.
+	/// Same equations as SWCharEst::Evaluate; the regression coefficients
+	/// are the float values of SWCharEstMatrix::coefficients.
+	template
+	<
+	    typename T				///< floating-point type
+	>
+	static constexpr SWCharEst::TResults<T> Evaluate (
+	    T const sand,			///< sand fraction (0-1)
+	    T const clay,			///< clay fraction (0-1)
+	    T const ompc)			///< organic matter wt %
+	{
+	    SWCharEst::TResults<T> props = { T(0), T(0), T(0), T(0) };
+
+	    T const om = std::min ( T(70), ompc );		// upper limit OM%
+	    if ( sand < T(0) || sand > T(1) ||
+		 clay < T(0) || clay > T(1) ||
+		 om < T(0) || sand + clay > T(1) )
+		return props;
+
+	    T const theta1500t = M::Regress( M::Theta1500t, sand, clay, om );
+	    T theta1500 = std::max(
+			T(0.01),	// constrain
+			theta1500t + T(0.14) * theta1500t - T(0.02) );
+
+	    T const theta33t = M::Regress( M::Theta33t, sand, clay, om );
+	    T const theta33 = std::min(
+			T(0.80),	// constrain
+			theta33t + T(1.283) * theta33t * theta33t - T(0.374) * theta33t - T(0.015));
+
+	    theta1500 = std::min( theta1500, T(0.80) * theta33 );	// constrain
+
+	    T const thetaS33t = M::Regress( M::ThetaS33t, sand, clay, om );
+	    T const thetaS33 = thetaS33t + T(0.636) * thetaS33t - T(0.107);
+	    T const thetaS = theta33 + thetaS33 - T(0.097) * sand + T(0.043);
+
+	    T const B = T(3.816713) / (
+			static_cast<T>( Log(theta33) ) - static_cast<T>( Log(theta1500) ) );
+	    T const lamda = T(1.0) / B;
+	    T const Ks = static_cast<T>(
+			T(1930.0) * static_cast<T>( Pow( thetaS - theta33, T(3.0) - lamda ) )
+			/ 36000.0 );
+
+	    props.WP = theta1500;
+	    props.FC = theta33;
+	    props.thetaS = thetaS;
+	    props.Ks = Ks;
+	    return props;
+	}
+
+	/// Returns the 12 USDA texture classes with their estimated properties.
+	/// Sand and clay are the values in Saxton & Rawls (2006), table 3.
+	static constexpr TextureClassTable TextureClasses (
+	    float const ompc = 2.5f )		///< organic matter wt %
+	{
+	    TextureClassTable table = {{
+		{ "sand",		0.88f, 0.05f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "loamy sand",		0.80f, 0.05f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "sandy loam",		0.65f, 0.10f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "loam",		0.40f, 0.20f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "silt loam",		0.20f, 0.15f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "silt",		0.10f, 0.05f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "sandy clay loam",	0.60f, 0.25f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "clay loam",		0.30f, 0.35f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "silty clay loam",	0.10f, 0.35f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "silty clay",		0.10f, 0.45f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "sandy clay",		0.50f, 0.40f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } },
+		{ "clay",		0.25f, 0.50f, 0.0f, { 0.0f, 0.0f, 0.0f, 0.0f } } }};
+	    for ( std::size_t i = 0; i < numTextureClasses; ++i )
+	    {
+		table.classes[i].ompc = ompc;
+		table.classes[i].props = Evaluate(
+			table.classes[i].sand, table.classes[i].clay, ompc );
+	    }
+	    return table;
+	}
+
+      private:
+
+	typedef SWCharEstMatrix M;
+
+	static constexpr double ln2 = 0.693147180559945309417232121458;
+	static constexpr double sqrt2 = 1.41421356237309504880168872421;
+
+	// not used
+	SWCharEstConstexpr ();
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstConstexpr_h
@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstCube.cpp
+// class	teh::SWCharEstCube
+// brief 	Evaluates a cube of soils: pixels by standard depths.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstCube.h"
+#include "SWCharEst.h"
+#include <algorithm>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Soils per block in Evaluate.
+    // The inputs and outputs of a block, 28 bytes per soil,
+    // fit in the L2 cache.
+    std::size_t const blockSoils = 2048;
+
+} // namespace
+
+
+std::vector<float> SWCharEstCube::SoilGridsDepths ()
+{
+    float const depths[] = { 0.0f, 5.0f, 15.0f, 30.0f, 60.0f, 100.0f, 200.0f };
+    return std::vector<float>( depths, depths + 7 );
+}
+
+SWCharEstCube::SWCharEstCube (
+    std::vector<float> const & depthBounds,
+    std::vector<Interval> const & depthIntervals )
+    : numDepths ( depthBounds.size() > 1 ? depthBounds.size() - 1 : 0 ),
+      intervals ( depthIntervals ),
+      weights ( depthIntervals.size() * numDepths, 0.0f )
+{
+    for ( std::size_t i = 0; i < intervals.size(); ++i )
+	for ( std::size_t d = 0; d < numDepths; ++d )
+	{
+	    float const overlap =
+		std::min( depthBounds[d + 1], intervals[i].bottom ) -
+		std::max( depthBounds[d], intervals[i].top );
+	    weights[i * numDepths + d] = std::max( overlap, 0.0f );
+	}
+}
+
+void SWCharEstCube::Evaluate (
+    Layout const layout,		// order of the elements
+    std::size_t const numPixels,	// number of pixels
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks,			// output: sat. hydraulic conductivity
+    float * const awc) const		// output: AWC of each interval (cm)
+{
+    if ( numDepths == 0 )
+	return;
+    if ( layout == DepthMajor )
+	EvaluateDepthMajor( numPixels, sand, clay, ompc, wp, fc, thetaS, ks, awc );
+    else
+	EvaluatePixelMajor( numPixels, sand, clay, ompc, wp, fc, thetaS, ks, awc );
+}
+
+// A block is a run of pixels in each depth plane.
+// The AWC loop is over contiguous pixels.
+void SWCharEstCube::EvaluateDepthMajor (
+    std::size_t const numPixels,
+    float const * const sand, float const * const clay, float const * const ompc,
+    float * const wp, float * const fc, float * const thetaS, float * const ks,
+    float * const awc ) const
+{
+    std::size_t const N = numPixels;
+    std::size_t const numIntervals = ( awc != 0 ? intervals.size() : 0 );
+    std::size_t const blockPixels = std::max( blockSoils / numDepths, std::size_t(16) );
+    for ( std::size_t start = 0; start < N; start += blockPixels )
+    {
+	std::size_t const m = std::min( blockPixels, N - start );
+	for ( std::size_t i = 0; i < numIntervals; ++i )
+	    std::fill( awc + i * N + start, awc + i * N + start + m, 0.0f );
+	for ( std::size_t d = 0; d < numDepths; ++d )
+	{
+	    std::size_t const offset = d * N + start;
+	    SWCharEst::GetBatch( m, sand + offset, clay + offset, ompc + offset,
+				 wp + offset, fc + offset, thetaS + offset, ks + offset );
+	    float const * __restrict const w = wp + offset;
+	    float const * __restrict const f = fc + offset;
+	    for ( std::size_t i = 0; i < numIntervals; ++i )
+	    {
+		float const thickness = weights[i * numDepths + d];
+		if ( thickness == 0.0f )
+		    continue;
+		float * __restrict const a = awc + i * N + start;
+		for ( std::size_t p = 0; p < m; ++p )
+		    a[p] += ( f[p] - w[p] ) * thickness;
+	    }
+	}
+    }
+}
+
+// A block is a run of whole pixels, all depths, which is one
+// contiguous batch. The AWC loop is over the pixels, so that the sums
+// of the pixels are independent, rather than a chain of adds per pixel.
+void SWCharEstCube::EvaluatePixelMajor (
+    std::size_t const numPixels,
+    float const * const sand, float const * const clay, float const * const ompc,
+    float * const wp, float * const fc, float * const thetaS, float * const ks,
+    float * const awc ) const
+{
+    std::size_t const D = numDepths;
+    std::size_t const numIntervals = ( awc != 0 ? intervals.size() : 0 );
+    std::size_t const blockPixels = std::max( blockSoils / D, std::size_t(16) );
+    float sum[blockSoils];		// AWC of the pixels of a block
+    for ( std::size_t start = 0; start < numPixels; start += blockPixels )
+    {
+	std::size_t const m = std::min( blockPixels, numPixels - start );
+	std::size_t const offset = start * D;
+	SWCharEst::GetBatch( m * D, sand + offset, clay + offset, ompc + offset,
+			     wp + offset, fc + offset, thetaS + offset, ks + offset );
+	float const * __restrict const w = wp + offset;
+	float const * __restrict const f = fc + offset;
+	for ( std::size_t i = 0; i < numIntervals; ++i )
+	{
+	    std::fill( sum, sum + m, 0.0f );
+	    for ( std::size_t d = 0; d < D; ++d )
+	    {
+		float const thickness = weights[i * D + d];
+		if ( thickness == 0.0f )
+		    continue;
+		for ( std::size_t p = 0; p < m; ++p )
+		    sum[p] += ( f[p * D + d] - w[p * D + d] ) * thickness;
+	    }
+	    for ( std::size_t p = 0; p < m; ++p )
+		awc[( start + p ) * numIntervals + i] = sum[p];
+	}
+    }
+}
+
+} // namespace teh
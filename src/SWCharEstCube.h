@@ -0,0 +1,114 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstCube.h
+@class		teh::SWCharEstCube
+@brief 		Evaluates a cube of soils: pixels by standard depths.
+@details {
+		SoilGrids-style products give sand, clay and OM at a set of
+		standard depth layers for each pixel. The layers are given
+		by their bounds, in cm; the default is the SoilGrids layers
+		0-5, 5-15, 15-30, 30-60, 60-100 and 100-200 cm.
+		The arrays of the cube are in one of two layouts:
+		DepthMajor, element [d * numPixels + p] (a plane per depth,
+		as in a multi-band raster), or PixelMajor,
+		element [p * numDepths + d] (the depths of a pixel together).
+		The outputs are in the same layout as the inputs.
+		Evaluate visits the cube in blocks of pixels. Each block is
+		evaluated with SWCharEst::GetBatch and, if awc is given,
+		its available water capacity (AWC) is summed while the block
+		is in the cache: (FC - WP) times the thickness of each layer
+		within each depth interval, in cm of water.
+		So each input is read from memory once, in either layout.
+		The AWC is by interval for DepthMajor, element [i * numPixels + p],
+		and by pixel for PixelMajor, element [p * numIntervals + i].
+		Layers with invalid inputs have zero results,
+		and add nothing to the AWC.
+}
+@example {
+	Example:
+	    teh::SWCharEstCube const cube;	// SoilGrids depths; AWC of 0-30, 0-100 cm
+	    cube.Evaluate( teh::SWCharEstCube::DepthMajor, numPixels,
+			   &sand[0], &clay[0], &ompc[0],
+			   &wp[0], &fc[0], &thetaS[0], &ks[0], &awc[0] );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstCube_h
+#define INC_teh_SWCharEstCube_h
+
+#include "SWCharEstProfile.h"
+#include <cstddef>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstCube
+    {
+      public:
+
+	/// Order of the elements of the cube arrays.
+	enum Layout
+	{
+	    DepthMajor,		///< [d * numPixels + p]
+	    PixelMajor		///< [p * numDepths + d]
+	};
+
+	typedef SWCharEstProfile::Interval Interval;
+
+	/// Returns the bounds of the SoilGrids depth layers (cm).
+	static std::vector<float> SoilGridsDepths ();
+
+	/// depthBounds has the top of each layer, and the bottom of the last,
+	/// increasing; AWC is found for each of the intervals.
+	SWCharEstCube (
+	    std::vector<float> const & depthBounds = SoilGridsDepths(),
+	    std::vector<Interval> const & depthIntervals = SWCharEstProfile::StandardIntervals() );
+
+	/// Returns the number of depth layers.
+	std::size_t NumDepths () const { return numDepths; }
+
+	/// Returns the intervals of the AWC outputs.
+	std::vector<Interval> const & Intervals () const { return intervals; }
+
+	/// Evaluates numPixels * NumDepths() soils, and if awc is not null,
+	/// the AWC of each interval, which has numPixels * Intervals().size()
+	/// elements.
+	void Evaluate (
+	    Layout const layout,		///< order of the elements
+	    std::size_t const numPixels,	///< number of pixels
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks,			///< output: sat. hydraulic conductivity
+	    float * const awc = 0) const;	///< output: AWC of each interval (cm)
+
+      private:
+
+	std::size_t const numDepths;
+	std::vector<Interval> const intervals;
+	std::vector<float> weights;	// thickness of layer d in interval i,
+					// [i * numDepths + d]
+
+	void EvaluateDepthMajor (
+	    std::size_t const numPixels,
+	    float const * const sand, float const * const clay, float const * const ompc,
+	    float * const wp, float * const fc, float * const thetaS, float * const ks,
+	    float * const awc ) const;
+	void EvaluatePixelMajor (
+	    std::size_t const numPixels,
+	    float const * const sand, float const * const clay, float const * const ompc,
+	    float * const wp, float * const fc, float * const thetaS, float * const ks,
+	    float * const awc ) const;
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstCube_h
@@ -0,0 +1,191 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstDedup.cpp
+// class	teh::SWCharEstDedup
+// brief 	Batch evaluation which evaluates each unique input once.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstDedup.h"
+#include "SWCharEst.h"
+#include <algorithm>
+#include <cstring>
+
+
+namespace teh {
+
+
+namespace {
+
+    uint32_t const emptySlot = ~uint32_t(0);
+
+    inline uint32_t Bits ( float const x )
+    {
+	uint32_t b;
+	std::memcpy( &b, &x, sizeof(b) );
+	return b;
+    }
+
+    // Slot of a triple: multiplicative hashing of the bits;
+    // the high bits of the product are the best mixed.
+    inline std::size_t Hash (
+	uint32_t const s,
+	uint32_t const c,
+	uint32_t const om,
+	unsigned const slotBits )
+    {
+	uint64_t const h =
+	    ( ( uint64_t(s) << 32 | c ) ^ ( uint64_t(om) * 0xff51afd7ed558ccdull ) )
+	    * 0x9e3779b97f4a7c15ull;
+	return static_cast<std::size_t>( h >> ( 64 - slotBits ) );
+    }
+
+} // namespace
+
+
+SWCharEstDedup::SWCharEstDedup (
+    std::size_t const expectedUnique )	// number of unique triples
+    : numInputs ( 0 ),
+      slotBits ( 4 )
+{
+    while ( ( std::size_t(1) << slotBits ) < 2 * expectedUnique )
+	++slotBits;
+    Slot const empty = { 0, 0, 0, emptySlot };
+    slots.assign( std::size_t(1) << slotBits, empty );
+}
+
+uint32_t SWCharEstDedup::Insert (
+    float const s,
+    float const c,
+    float const om )
+{
+    uint32_t const bs = Bits( s ), bc = Bits( c ), bom = Bits( om );
+    std::size_t const mask = slots.size() - 1;
+    for ( std::size_t i = Hash( bs, bc, bom, slotBits ); ; i = ( i + 1 ) & mask )
+    {
+	Slot & slot = slots[i];
+	if ( slot.unique == emptySlot )
+	{
+	    slot.sand = bs;
+	    slot.clay = bc;
+	    slot.ompc = bom;
+	    slot.unique = static_cast<uint32_t>( sand.size() );
+	    sand.push_back( s );
+	    clay.push_back( c );
+	    ompc.push_back( om );
+	    return slot.unique;
+	}
+	if ( slot.sand == bs && slot.clay == bc && slot.ompc == bom )
+	    return slot.unique;
+    }
+}
+
+void SWCharEstDedup::Grow ()
+{
+    std::vector<Slot> old;
+    old.swap( slots );
+    ++slotBits;
+    Slot const empty = { 0, 0, 0, emptySlot };
+    slots.assign( std::size_t(1) << slotBits, empty );
+    std::size_t const mask = slots.size() - 1;
+    for ( Slot const & slot : old )
+    {
+	if ( slot.unique == emptySlot )
+	    continue;
+	std::size_t i = Hash( slot.sand, slot.clay, slot.ompc, slotBits );
+	while ( slots[i].unique != emptySlot )
+	    i = ( i + 1 ) & mask;
+	slots[i] = slot;
+    }
+}
+
+std::size_t SWCharEstDedup::Build (
+    std::size_t const n,		// number of soils
+    float const * const sandIn,		// sand fractions (0-1)
+    float const * const clayIn,		// clay fractions (0-1)
+    float const * const ompcIn,		// organic matter wt %
+    uint32_t * const index)		// output: unique triple of each soil
+{
+    numInputs = n;
+    sand.clear();
+    clay.clear();
+    ompc.clear();
+    wp.clear();
+    fc.clear();
+    thetaS.clear();
+    ks.clear();
+    Slot const empty = { 0, 0, 0, emptySlot };
+    std::fill( slots.begin(), slots.end(), empty );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	// same bits as the last soil
+	if ( i > 0 &&
+	     Bits( sandIn[i] ) == Bits( sandIn[i-1] ) &&
+	     Bits( clayIn[i] ) == Bits( clayIn[i-1] ) &&
+	     Bits( ompcIn[i] ) == Bits( ompcIn[i-1] ) )
+	{
+	    index[i] = index[i-1];
+	    continue;
+	}
+	index[i] = Insert( sandIn[i], clayIn[i], ompcIn[i] );
+	if ( 2 * sand.size() > slots.size() )	// load > 1/2
+	    Grow();
+    }
+    return sand.size();
+}
+
+void SWCharEstDedup::EvaluateUnique ()
+{
+    std::size_t const m = sand.size();
+    wp.resize( m );
+    fc.resize( m );
+    thetaS.resize( m );
+    ks.resize( m );
+    if ( m > 0 )
+	SWCharEst::GetBatch( m, &sand[0], &clay[0], &ompc[0],
+			     &wp[0], &fc[0], &thetaS[0], &ks[0] );
+}
+
+void SWCharEstDedup::Gather (
+    std::size_t const n,		// number of soils
+    uint32_t const * const index,	// unique triple of each soil, from Build
+    float * const wpOut,		// output: wilting point
+    float * const fcOut,		// output: field capacity
+    float * const thetaSOut,		// output: saturated water content
+    float * const ksOut) const		// output: sat. hydraulic conductivity
+{
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	uint32_t const u = index[i];
+	wpOut[i] = wp[u];
+	fcOut[i] = fc[u];
+	thetaSOut[i] = thetaS[u];
+	ksOut[i] = ks[u];
+    }
+}
+
+void SWCharEstDedup::Evaluate (
+    std::size_t const n,		// number of soils
+    float const * const sandIn,		// sand fractions (0-1)
+    float const * const clayIn,		// clay fractions (0-1)
+    float const * const ompcIn,		// organic matter wt %
+    float * const wpOut,		// output: wilting point
+    float * const fcOut,		// output: field capacity
+    float * const thetaSOut,		// output: saturated water content
+    float * const ksOut)		// output: sat. hydraulic conductivity
+{
+    soilIndex.resize( n );
+    Build( n, sandIn, clayIn, ompcIn, soilIndex.data() );
+    EvaluateUnique();
+    Gather( n, soilIndex.data(), wpOut, fcOut, thetaSOut, ksOut );
+}
+
+double SWCharEstDedup::DedupRatio () const
+{
+    return ( sand.empty() ? 0.0 : double(numInputs) / double(sand.size()) );
+}
+
+} // namespace teh
@@ -0,0 +1,143 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstDedup.h
+@class		teh::SWCharEstDedup
+@brief 		Batch evaluation which evaluates each unique input once.
+@details {
+		Large rasters often have few unique (sand, clay, OM)
+		triples, repeated through map units.
+		Build hashes the triples of n soils into an open-addressing
+		table (linear probing, load at most 1/2), stores each
+		unique triple once, and writes for each soil the index
+		of its unique triple. Runs of equal triples, as in
+		rasters of map units, are found without hashing.
+		EvaluateUnique evaluates the unique triples with
+		SWCharEst::GetBatch, and Gather writes the results of
+		each soil from its index.
+		Evaluate does all three.
+		Triples are equal if their bits are equal, so the results
+		are the same as SWCharEst::GetBatch, bitwise.
+		DedupRatio is the number of soils per unique triple,
+		so the kernel work is divided by this ratio.
+		Hashing and gathering cost about 4-15 ns per soil,
+		so this pays with the portable kernel (about 25 ns),
+		but the AVX-512 kernel is about as fast as the hashing.
+		Build, EvaluateUnique and Evaluate reuse the memory of
+		earlier calls. Not thread-safe; use one object per thread.
+}
+@example {
+	Example:
+	    teh::SWCharEstDedup dedup;
+	    dedup.Evaluate( n, &sand[0], &clay[0], &ompc[0],
+			    &wp[0], &fc[0], &thetaS[0], &ks[0] );
+	    std::cout << dedup.NumUnique() << " unique soils, ratio "
+		      << dedup.DedupRatio() << std::endl;
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstDedup_h
+#define INC_teh_SWCharEstDedup_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstDedup
+    {
+      public:
+
+	/// The table starts with room for this many unique triples,
+	/// and grows as needed.
+	SWCharEstDedup (
+	    std::size_t const expectedUnique = 1024 );	///< number of unique triples
+
+	/// Finds the unique triples of n soils;
+	/// index[i] is the unique triple of soil i.
+	/// Returns the number of unique triples.
+	std::size_t Build (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    uint32_t * const index);		///< output: unique triple of each soil
+
+	/// Evaluates the unique triples of the last Build.
+	void EvaluateUnique ();
+
+	/// Writes the results of n soils from their unique triples.
+	void Gather (
+	    std::size_t const n,		///< number of soils
+	    uint32_t const * const index,	///< unique triple of each soil, from Build
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks) const;		///< output: sat. hydraulic conductivity
+
+	/// Build, EvaluateUnique and Gather, as SWCharEst::GetBatch.
+	void Evaluate (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks);			///< output: sat. hydraulic conductivity
+
+	/// Number of soils in the last Build.
+	std::size_t NumInputs () const { return numInputs; }
+
+	/// Number of unique triples in the last Build.
+	std::size_t NumUnique () const { return sand.size(); }
+
+	/// Soils per unique triple in the last Build; 0 if none.
+	double DedupRatio () const;
+
+	/// The unique triples, and their results after EvaluateUnique.
+	std::vector<float> const & UniqueSand () const { return sand; }
+	std::vector<float> const & UniqueClay () const { return clay; }
+	std::vector<float> const & UniqueOM () const { return ompc; }
+	std::vector<float> const & UniqueWP () const { return wp; }
+	std::vector<float> const & UniqueFC () const { return fc; }
+	std::vector<float> const & UniqueThetaS () const { return thetaS; }
+	std::vector<float> const & UniqueKs () const { return ks; }
+
+      private:
+
+	// the bits of a triple, and its index; empty if unique == ~0
+	struct Slot
+	{
+	    uint32_t sand, clay, ompc;
+	    uint32_t unique;
+	};
+
+	std::size_t numInputs;
+	std::vector<Slot> slots;
+	unsigned slotBits;		// slots.size() == 1 << slotBits
+
+	// unique triples and their results
+	std::vector<float> sand, clay, ompc;
+	std::vector<float> wp, fc, thetaS, ks;
+
+	std::vector<uint32_t> soilIndex;	// for Evaluate
+
+	// index of a triple, added if new
+	uint32_t Insert (
+	    float const s,
+	    float const c,
+	    float const om );
+
+	// doubles the number of slots
+	void Grow ();
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstDedup_h
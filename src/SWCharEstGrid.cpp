@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstGrid.cpp
+// class	teh::SWCharEstGrid
+// brief 	Gridded trilinear surrogate for the Saxton & Rawls equations,
+//		with the maximum errors vs. the equations.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstGrid.h"
+#include "SWCharEstMatrix.h"
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Fractions of a cell at which the errors are sampled, on each axis.
+    float const sampleAt[] = { 0.25f, 0.5f, 0.75f };
+
+    // The regressions of SWCharEst::Evaluate, without the constraints
+    // and the theta33 quadratic, which are applied after interpolation.
+    // The values are sums of products of at most one each of sand,
+    // clay and OM, which trilinear interpolation reproduces exactly.
+    void Regressions (
+	float const sand,
+	float const clay,
+	float const om,
+	float & theta1500,		// unconstrained
+	float & theta33t,
+	float & thetaSminus33 )		// thetaS - theta33
+    {
+	float basis[SWCharEstMatrix::numBasisTerms];
+	float r[SWCharEstMatrix::numRegressions];
+	SWCharEstMatrix::Basis( 1, &sand, &clay, &om, basis, 1 );
+	SWCharEstMatrix::Regressions( 1, basis, 1, r, 1 );
+	float const theta1500t = r[SWCharEstMatrix::Theta1500t];
+	theta1500 = theta1500t + 0.14f * theta1500t - 0.02f;
+	theta33t = r[SWCharEstMatrix::Theta33t];
+	float const thetaS33t = r[SWCharEstMatrix::ThetaS33t];
+	thetaSminus33 = thetaS33t + 0.636f * thetaS33t - 0.107f - 0.097f * sand + 0.043f;
+    }
+
+    void UpdateErrors (
+	SWCharEstGrid::ErrorStats & stats,
+	float const exact,
+	float const approx )
+    {
+	float const absError = std::fabs( approx - exact );
+	stats.maxAbs = std::max( stats.maxAbs, absError );
+	if ( exact != 0.0f )
+	    stats.maxRel = std::max( stats.maxRel, absError / std::fabs(exact) );
+    }
+
+    void WriteStats (
+	std::ostream & os,
+	char const * const name,
+	SWCharEstGrid::ErrorStats const & stats )
+    {
+	os << "  " << name << ": max. absolute error = " << stats.maxAbs
+	   << ", max. relative error = " << stats.maxRel << '\n';
+    }
+
+} // namespace
+
+
+SWCharEstGrid::SWCharEstGrid (
+    int const numTextureNodes,		// number of sand or clay nodes, 0-1
+    int const numOMNodes,		// number of OM nodes, 0 to omMax
+    float const maxOM )			// maximum OM in the grid, wt %
+    : numTexture ( std::max( 2, numTextureNodes ) ),
+      numOM ( std::max( 2, numOMNodes ) ),
+      omMax ( std::min( 70.0f, std::max( 0.1f, maxOM ) ) ),
+      textureScale ( static_cast<float>( numTexture - 1 ) ),
+      omScale ( ( numOM - 1 ) / omMax )
+{
+    std::size_t const size = static_cast<std::size_t>(numOM) * numTexture * numTexture;
+    nodes.resize( size * numValues );
+    std::vector<unsigned char> nodeOK ( size, 0 );
+    for ( int k = 0; k < numOM; ++k )
+    {
+	float const om = ( k == numOM - 1 ? omMax : k / omScale );
+	for ( int i = 0; i < numTexture; ++i )
+	    for ( int j = 0; j < numTexture; ++j )
+	    {
+		std::size_t const n = ( static_cast<std::size_t>(k) * numTexture + i ) * numTexture + j;
+		float const sand = i / textureScale;
+		float const clay = j / textureScale;
+		float * const v = &nodes[ n * numValues ];
+		Regressions( sand, clay, om, v[0], v[1], v[2] );
+		// Ks is proportional to (thetaS - theta33)^(3 - lamda), with
+		// lamda < 1, so the cube root of Ks is nearly linear
+		SWCharEst::Results const exact = SWCharEst::Evaluate( sand, clay, om );
+		v[3] = std::cbrt( exact.Ks );
+		nodeOK[n] = ( exact.FC > 0.0f && std::isfinite( v[3] ) );
+	    }
+    }
+
+    // a cell is identified by the index of its lowest node
+    cellOK.assign( size, 0 );
+    std::size_t const dSand = numTexture;
+    std::size_t const dOM = dSand * numTexture;
+    for ( int k = 0; k < numOM - 1; ++k )
+	for ( int i = 0; i < numTexture - 1; ++i )
+	    for ( int j = 0; j < numTexture - 1 - i; ++j )
+	    {
+		std::size_t const c = k * dOM + i * dSand + j;
+		bool ok = true;
+		for ( int corner = 0; corner < 8; ++corner )
+		    ok = ok && nodeOK[ c + ( corner & 1 )
+				       + ( corner & 2 ? dSand : 0 )
+				       + ( corner & 4 ? dOM : 0 ) ];
+		cellOK[c] = ok;
+	    }
+
+    CompareToExact();
+}
+
+bool SWCharEstGrid::Interpolate (
+    float const sand,
+    float const clay,
+    float const ompc,
+    SWCharEst::Results & r ) const
+{
+    float const om = std::min ( 70.0f, ompc );	// upper limit OM%, as Evaluate
+    // also false for NaN
+    if ( !( sand >= 0.0f && sand <= 1.0f &&
+	    clay >= 0.0f && clay <= 1.0f &&
+	    om >= 0.0f && om <= omMax ) )
+	return false;
+
+    float const x = sand * textureScale;
+    float const y = clay * textureScale;
+    float const z = om * omScale;
+    int const i = std::min( static_cast<int>(x), numTexture - 2 );
+    int const j = std::min( static_cast<int>(y), numTexture - 2 );
+    int const k = std::min( static_cast<int>(z), numOM - 2 );
+    std::size_t const dSand = numTexture;
+    std::size_t const dOM = dSand * numTexture;
+    std::size_t const c = k * dOM + i * dSand + j;
+    if ( !cellOK[c] )
+	return false;
+
+    float const fx = x - i;
+    float const fy = y - j;
+    float const fz = z - k;
+    // weights of the 8 corners
+    float const w00 = ( 1.0f - fx ) * ( 1.0f - fy );
+    float const w01 = ( 1.0f - fx ) * fy;
+    float const w10 = fx * ( 1.0f - fy );
+    float const w11 = fx * fy;
+    float const w[8] = {
+	w00 * ( 1.0f - fz ), w01 * ( 1.0f - fz ), w10 * ( 1.0f - fz ), w11 * ( 1.0f - fz ),
+	w00 * fz, w01 * fz, w10 * fz, w11 * fz };
+    float const * const corner[8] = {
+	&nodes[ c * numValues ],
+	&nodes[ ( c + 1 ) * numValues ],
+	&nodes[ ( c + dSand ) * numValues ],
+	&nodes[ ( c + dSand + 1 ) * numValues ],
+	&nodes[ ( c + dOM ) * numValues ],
+	&nodes[ ( c + dOM + 1 ) * numValues ],
+	&nodes[ ( c + dOM + dSand ) * numValues ],
+	&nodes[ ( c + dOM + dSand + 1 ) * numValues ] };
+    float v[numValues] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for ( int n = 0; n < 8; ++n )
+	for ( int q = 0; q < numValues; ++q )
+	    v[q] += w[n] * corner[n][q];
+
+    // constraints, as in SWCharEst::Evaluate
+    float const theta33 = std::min( 0.80f, v[1] + 1.283f * v[1] * v[1] - 0.374f * v[1] - 0.015f );
+    r.WP = std::min( std::max( 0.01f, v[0] ), 0.80f * theta33 );
+    r.FC = theta33;
+    r.thetaS = theta33 + v[2];
+    r.Ks = v[3] * v[3] * v[3];
+    return true;
+}
+
+SWCharEst::Results SWCharEstGrid::Get (
+    float const sand,			// sand fraction (0-1)
+    float const clay,			// clay fraction (0-1)
+    float const ompc) const		// organic matter wt %
+{
+    SWCharEst::Results r;
+    if ( Interpolate( sand, clay, ompc, r ) )
+	return r;
+    return SWCharEst::Evaluate( sand, clay, ompc );
+}
+
+void SWCharEstGrid::GetBatch (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks) const		// output: sat. hydraulic conductivity
+{
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	SWCharEst::Results const r = Get( sand[i], clay[i], ompc[i] );
+	wp[i] = r.WP;
+	fc[i] = r.FC;
+	thetaS[i] = r.thetaS;
+	ks[i] = r.Ks;
+    }
+}
+
+bool SWCharEstGrid::IsInterpolated (
+    float const sand,			// sand fraction (0-1)
+    float const clay,			// clay fraction (0-1)
+    float const ompc) const		// organic matter wt %
+{
+    SWCharEst::Results r;
+    return Interpolate( sand, clay, ompc, r );
+}
+
+std::size_t SWCharEstGrid::MemorySize () const
+{
+    return nodes.size() * sizeof(float) + cellOK.size();
+}
+
+// Compares the surrogate with the equations at 3 x 3 x 3 points
+// inside each cell which is interpolated.
+// The maximum interpolation error is inside the cells, not at the nodes.
+void SWCharEstGrid::CompareToExact ()
+{
+    ErrorStats const zero = { 0.0f, 0.0f };
+    errors.WP = errors.FC = errors.thetaS = errors.Ks = zero;
+    errors.numPoints = 0;
+
+    std::size_t const dSand = numTexture;
+    std::size_t const dOM = dSand * numTexture;
+    for ( int k = 0; k < numOM - 1; ++k )
+	for ( int i = 0; i < numTexture - 1; ++i )
+	    for ( int j = 0; j < numTexture - 1 - i; ++j )
+	    {
+		if ( !cellOK[ k * dOM + i * dSand + j ] )
+		    continue;
+		for ( float const a : sampleAt )
+		    for ( float const b : sampleAt )
+			for ( float const c : sampleAt )
+			{
+			    float const sand = ( i + a ) / textureScale;
+			    float const clay = ( j + b ) / textureScale;
+			    float const om = ( k + c ) / omScale;
+			    SWCharEst::Results approx;
+			    if ( !Interpolate( sand, clay, om, approx ) )
+				continue;
+			    SWCharEst::Results const exact =
+				SWCharEst::Evaluate( sand, clay, om );
+			    if ( !std::isfinite( exact.Ks ) )
+				continue;
+			    UpdateErrors( errors.WP, exact.WP, approx.WP );
+			    UpdateErrors( errors.FC, exact.FC, approx.FC );
+			    UpdateErrors( errors.thetaS, exact.thetaS, approx.thetaS );
+			    UpdateErrors( errors.Ks, exact.Ks, approx.Ks );
+			    ++errors.numPoints;
+			}
+	    }
+}
+
+void SWCharEstGrid::WriteErrors (
+    std::ostream & os ) const
+{
+    os << "SWCharEstGrid: " << numTexture << " x " << numTexture << " x " << numOM
+       << " nodes, OM 0-" << omMax << "%, "
+       << errors.numPoints << " points compared\n";
+    WriteStats( os, "WP    ", errors.WP );
+    WriteStats( os, "FC    ", errors.FC );
+    WriteStats( os, "thetaS", errors.thetaS );
+    WriteStats( os, "Ks    ", errors.Ks );
+    os.flush();
+}
+
+} // namespace teh
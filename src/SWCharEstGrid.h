@@ -0,0 +1,148 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstGrid.h
+@class		teh::SWCharEstGrid
+@brief 		Gridded trilinear surrogate for the Saxton & Rawls equations.
+@details {
+		Approximates SWCharEst::Evaluate for continuous inputs by
+		trilinear interpolation in a grid of sand, clay and OM,
+		so that each estimate is a gather of 8 grid nodes
+		with no log or pow calls.
+		The regressions are interpolated before the constraints
+		are applied, so WP, FC and thetaS have only rounding errors.
+		Ks is interpolated as the cube root of Ks; its relative error
+		is largest where thetaS is close to FC, so Ks is near zero.
+		The grid resolution and OM range are set by the constructor.
+		Grid cells which are not entirely inside the texture
+		triangle, or which have a node with an undefined Ks,
+		use SWCharEst::Evaluate, as do inputs outside of the grid.
+		Invalid inputs give zero results.
+		The constructor compares the surrogate with SWCharEst::Evaluate
+		at points inside each interpolated cell, and saves the maximum
+		absolute and relative errors; see Errors.
+		Use these to choose a grid with an acceptable error.
+		After construction the methods are const and thread-safe.
+}
+@example {
+	Example - 1% sand and clay steps, OM 0-8% in 0.5% steps:
+	    teh::SWCharEstGrid const grid ( 101, 17, 8.0f );
+	    if ( grid.Errors().FC.maxRel > 1.0e-3f ) ...
+	    teh::SWCharEst::Results r = grid.Get( 0.153f, 0.184f, 3.05f );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstGrid_h
+#define INC_teh_SWCharEstGrid_h
+
+#include "SWCharEst.h"
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstGrid
+    {
+      public:
+
+	/// Maximum errors of one variable.
+	struct ErrorStats
+	{
+	    float maxAbs;	///< maximum absolute error
+	    float maxRel;	///< maximum relative error, where the exact value is not zero
+	};
+
+	/// Maximum errors of the surrogate vs. SWCharEst::Evaluate.
+	struct ErrorReport
+	{
+	    ErrorStats WP;		///< wilting point
+	    ErrorStats FC;		///< field capacity
+	    ErrorStats thetaS;		///< saturated water content
+	    ErrorStats Ks;		///< sat. hydraulic conductivity
+	    std::size_t numPoints;	///< number of points compared
+	};
+
+	/// Builds the grid, and the error report.
+	SWCharEstGrid (
+	    int const numTexture = 101,		///< number of sand or clay nodes, 0-1 (>= 2)
+	    int const numOM = 17,		///< number of OM nodes, 0 to omMax (>= 2)
+	    float const omMax = 8.0f );		///< maximum OM in the grid, wt % (<= 70)
+
+	/// Returns WP, FC, thetaS, Ks; all are zero if the arguments are invalid.
+	SWCharEst::Results Get (
+	    float const sand,			///< sand fraction (0-1)
+	    float const clay,			///< clay fraction (0-1)
+	    float const ompc) const;		///< organic matter wt %
+
+	/// Get for n soils, with the arguments of SWCharEst::GetBatch.
+	void GetBatch (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks) const;		///< output: sat. hydraulic conductivity
+
+	/// Returns true if Get interpolates, rather than calling SWCharEst::Evaluate.
+	bool IsInterpolated (
+	    float const sand,			///< sand fraction (0-1)
+	    float const clay,			///< clay fraction (0-1)
+	    float const ompc) const;		///< organic matter wt %
+
+	/// Maximum errors found by the constructor.
+	ErrorReport const & Errors () const
+	  {
+	    return errors;
+	  }
+
+	/// Writes the grid size and the error report.
+	void WriteErrors (
+	    std::ostream & os ) const;
+
+	int NumTexture () const { return numTexture; }
+	int NumOM () const { return numOM; }
+	float OMMax () const { return omMax; }
+
+	/// Returns the grid memory size in bytes.
+	std::size_t MemorySize () const;
+
+      private:
+
+	int const numTexture;			// sand and clay nodes
+	int const numOM;			// OM nodes
+	float const omMax;			// OM of the last node
+	float const textureScale;		// fraction to node index
+	float const omScale;			// OM to node index
+
+	// values at each node: unconstrained theta1500, theta33t,
+	// thetaS - theta33, and the cube root of Ks
+	static int const numValues = 4;
+
+	// node values; node index = (OM * numTexture + sand) * numTexture + clay
+	std::vector<float> nodes;
+
+	// 1 if the cell can be interpolated; same index as nodes
+	std::vector<unsigned char> cellOK;
+
+	ErrorReport errors;
+
+	// Returns true and the interpolated values if the cell can be used.
+	bool Interpolate (
+	    float const sand,
+	    float const clay,
+	    float const ompc,
+	    SWCharEst::Results & r ) const;
+
+	void CompareToExact ();
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstGrid_h
@@ -0,0 +1,260 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstMatrix.cpp
+// class	teh::SWCharEstMatrix
+// brief 	Matrix form of the Saxton & Rawls regressions, for batches of soils.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstMatrix.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace teh {
+
+
+constexpr double SWCharEstMatrix::coefficients[numRegressions][numBasisTerms];
+
+
+namespace {
+
+    typedef SWCharEstMatrix M;
+
+    // Number of soils per block in GetBatch.
+    // The basis, regressions and work arrays fit in the L1 cache.
+    std::size_t const blockSize = 256;
+
+    // Number of soils per micro-kernel tile. The 3 x 16 accumulators
+    // fit in the vector registers of SSE, AVX and AVX-512.
+    std::size_t const tileSize = 16;
+
+    // Regressions for a tile of W soils.
+    // Each basis row is loaded once and used by all three regressions;
+    // the accumulators stay in registers for the whole tile.
+    // Sums are in the same order as the SIMD kernels: intercept first.
+    template <std::size_t W>
+    inline void MicroKernel (
+	float const * __restrict const basis,
+	std::size_t const ldBasis,
+	float * __restrict const regressions,
+	std::size_t const ldRegressions )
+    {
+	float acc0[W], acc1[W], acc2[W];
+	for ( std::size_t j = 0; j < W; ++j )
+	{
+	    acc0[j] = static_cast<float>( M::coefficients[M::Theta1500t][M::BasisOne] );
+	    acc1[j] = static_cast<float>( M::coefficients[M::Theta33t][M::BasisOne] );
+	    acc2[j] = static_cast<float>( M::coefficients[M::ThetaS33t][M::BasisOne] );
+	}
+	for ( int k = 0; k < M::BasisOne; ++k )
+	{
+	    float const a0 = static_cast<float>( M::coefficients[M::Theta1500t][k] );
+	    float const a1 = static_cast<float>( M::coefficients[M::Theta33t][k] );
+	    float const a2 = static_cast<float>( M::coefficients[M::ThetaS33t][k] );
+	    float const * __restrict const b = basis + k * ldBasis;
+	    for ( std::size_t j = 0; j < W; ++j )
+	    {
+		acc0[j] += a0 * b[j];
+		acc1[j] += a1 * b[j];
+		acc2[j] += a2 * b[j];
+	    }
+	}
+	for ( std::size_t j = 0; j < W; ++j )
+	{
+	    regressions[M::Theta1500t * ldRegressions + j] = acc0[j];
+	    regressions[M::Theta33t * ldRegressions + j] = acc1[j];
+	    regressions[M::ThetaS33t * ldRegressions + j] = acc2[j];
+	}
+    }
+
+    // Validity of the arguments; same tests as CheckArgs.
+    // OM is already limited to 70%.
+    void Validity (
+	std::size_t const m,
+	float const * __restrict const basis,		// 7 x m, ld = blockSize
+	float * __restrict const valid)			// 1 = valid soil, 0 = invalid
+    {
+	float const * const sand = basis + M::BasisSand * blockSize;
+	float const * const clay = basis + M::BasisClay * blockSize;
+	float const * const om   = basis + M::BasisOM * blockSize;
+	for ( std::size_t i = 0; i < m; ++i )
+	{
+	    float const s = sand[i];
+	    float const c = clay[i];
+	    float ok = 1.0f;
+	    ok = ( s >= 0.0f ) ? ok : 0.0f;
+	    ok = ( s <= 1.0f ) ? ok : 0.0f;
+	    ok = ( c >= 0.0f ) ? ok : 0.0f;
+	    ok = ( c <= 1.0f ) ? ok : 0.0f;
+	    ok = ( om[i] >= 0.0f ) ? ok : 0.0f;
+	    ok = ( s + c <= 1.0f ) ? ok : 0.0f;
+	    valid[i] = ok;
+	}
+    }
+
+    // Constraints of SWCharEst::Evaluate applied to the regressions,
+    // and the arguments of Ks. Written as selects so that the
+    // compiler can vectorize the loop.
+    void Constraints (
+	std::size_t const m,
+	float const * __restrict const sand,
+	float const * __restrict const valid,
+	float const * __restrict const t1500tRow,
+	float const * __restrict const t33tRow,
+	float const * __restrict const tS33tRow,
+	float * __restrict const wp,
+	float * __restrict const fc,
+	float * __restrict const thetaS,
+	float * __restrict const theta1500,	// Ks arguments
+	float * __restrict const theta33,
+	float * __restrict const thetaSat)
+    {
+	for ( std::size_t i = 0; i < m; ++i )
+	{
+	    float const ok = valid[i];
+	    float const t1500t = t1500tRow[i];
+	    float const t33t = t33tRow[i];
+	    float const tS33t = tS33tRow[i];
+	    float t1500 = std::max( 0.01f, t1500t + 0.14f * t1500t - 0.02f );
+	    float const t33 = std::min(
+			0.80f,
+			t33t + 1.283f * t33t * t33t - 0.374f * t33t - 0.015f );
+	    t1500 = std::min( t1500, 0.80f * t33 );
+	    float const tS33 = tS33t + 0.636f * tS33t - 0.107f;
+	    float const tS = t33 + tS33 - 0.097f * sand[i] + 0.043f;
+
+	    // invalid soils get placeholder values so that the Ks loop
+	    // does not call log or pow outside of their domains
+	    theta1500[i] = ( ok != 0.0f ) ? t1500 : 0.1f;
+	    theta33[i]   = ( ok != 0.0f ) ? t33   : 0.2f;
+	    thetaSat[i]  = ( ok != 0.0f ) ? tS    : 0.3f;
+	    wp[i]        = ( ok != 0.0f ) ? t1500 : 0.0f;
+	    fc[i]        = ( ok != 0.0f ) ? t33   : 0.0f;
+	    thetaS[i]    = ( ok != 0.0f ) ? tS    : 0.0f;
+	}
+    }
+
+    // Saturated hydraulic conductivity, as SWCharEst::Evaluate.
+    void SaturatedKs (
+	std::size_t const m,
+	float const * __restrict const valid,
+	float const * __restrict const theta1500,
+	float const * __restrict const theta33,
+	float const * __restrict const thetaSat,
+	float * __restrict const ks)
+    {
+	for ( std::size_t i = 0; i < m; ++i )
+	{
+	    float const B = 3.816713f / ( std::log(theta33[i]) - std::log(theta1500[i]) );
+	    float const lamda = 1.0f / B;
+	    float const Ks = 1930.0f * std::pow( ( thetaSat[i] - theta33[i] ), (3.0f - lamda) ) / 36000.0;
+	    ks[i] = ( valid[i] != 0.0f ) ? Ks : 0.0f;
+	}
+    }
+
+} // namespace
+
+
+void SWCharEstMatrix::Basis (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const basis,		// output: 7 x n basis terms
+    std::size_t const ldBasis )		// row stride of basis
+{
+    float * __restrict const bSand     = basis + BasisSand * ldBasis;
+    float * __restrict const bClay     = basis + BasisClay * ldBasis;
+    float * __restrict const bOM       = basis + BasisOM * ldBasis;
+    float * __restrict const bSandOM   = basis + BasisSandOM * ldBasis;
+    float * __restrict const bClayOM   = basis + BasisClayOM * ldBasis;
+    float * __restrict const bSandClay = basis + BasisSandClay * ldBasis;
+    float * __restrict const bOne      = basis + BasisOne * ldBasis;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	float const s = sand[i];
+	float const c = clay[i];
+	float const om = std::min ( 70.0f, ompc[i] );	// upper limit OM%
+	bSand[i] = s;
+	bClay[i] = c;
+	bOM[i] = om;
+	bSandOM[i] = s * om;
+	bClayOM[i] = c * om;
+	bSandClay[i] = s * c;
+	bOne[i] = 1.0f;
+    }
+}
+
+void SWCharEstMatrix::Regressions (
+    std::size_t const n,		// number of soils
+    float const * const basis,		// 7 x n basis terms
+    std::size_t const ldBasis,		// row stride of basis
+    float * const regressions,		// output: 3 x n regressions
+    std::size_t const ldRegressions )	// row stride of regressions
+{
+    std::size_t j = 0;
+    for ( ; j + tileSize <= n; j += tileSize )
+	MicroKernel<tileSize>( basis + j, ldBasis, regressions + j, ldRegressions );
+    for ( ; j < n; ++j )
+	MicroKernel<1>( basis + j, ldBasis, regressions + j, ldRegressions );
+}
+
+void SWCharEstMatrix::Results (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const valid,		// 1 = valid soil, 0 = invalid
+    float const * const regressions,	// 3 x n regressions
+    std::size_t const ldRegressions,	// row stride of regressions
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks)			// output: sat. hydraulic conductivity
+{
+    float theta1500[blockSize];
+    float theta33[blockSize];
+    float thetaSat[blockSize];
+
+    for ( std::size_t start = 0; start < n; start += blockSize )
+    {
+	std::size_t const m = std::min( blockSize, n - start );
+	float const * const r = regressions + start;
+	Constraints( m, sand + start, valid + start,
+		     r + Theta1500t * ldRegressions,
+		     r + Theta33t * ldRegressions,
+		     r + ThetaS33t * ldRegressions,
+		     wp + start, fc + start, thetaS + start,
+		     theta1500, theta33, thetaSat );
+	SaturatedKs( m, valid + start, theta1500, theta33, thetaSat, ks + start );
+    }
+}
+
+void SWCharEstMatrix::GetBatch (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks)			// output: sat. hydraulic conductivity
+{
+    float basis[numBasisTerms * blockSize];
+    float regressions[numRegressions * blockSize];
+    float valid[blockSize];		// 1 = valid soil, 0 = invalid
+
+    for ( std::size_t start = 0; start < n; start += blockSize )
+    {
+	std::size_t const m = std::min( blockSize, n - start );
+	Basis( m, sand + start, clay + start, ompc + start, basis, blockSize );
+	Regressions( m, basis, blockSize, regressions, blockSize );
+	Validity( m, basis, valid );
+	Results( m, sand + start, valid, regressions, blockSize,
+		 wp + start, fc + start, thetaS + start, ks + start );
+    }
+}
+
+} // namespace teh
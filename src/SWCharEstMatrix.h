@@ -0,0 +1,162 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstMatrix.h
+@class		teh::SWCharEstMatrix
+@brief 		Matrix form of the Saxton & Rawls regressions, for batches of soils.
+@details {
+		The three regressions, theta1500t, theta33t and thetaS33t,
+		are sums over the same seven basis terms:
+		sand, clay, om, sand*om, clay*om, sand*clay, and 1.
+		The regression coefficients are stored once, as a 3 x 7 matrix,
+		and for a block of N soils the regressions are the product
+		of the matrix and the 7 x N block of basis terms.
+		The product uses a register-blocked micro-kernel
+		which the compiler vectorizes.
+		GetBatch has the same arguments and results as
+		SWCharEst::GetBatch. Results agree with SWCharEst::Evaluate
+		to within rounding of the regressions: about 1e-6 relative
+		for WP, FC and thetaS, and 1e-5 for Ks except where
+		thetaS is close to FC, so Ks is near zero.
+		The SIMD kernels, the portable SWCharEst::GetBatch and
+		SWCharEstConstexpr use the same coefficient matrix;
+		Regress sums the terms of one soil in the order of
+		SWCharEst::Evaluate. The matrix holds only the regression
+		coefficients: SWCharEst::Evaluate keeps its written-out
+		equations, and each kernel has its own form of the
+		constraints and the Ks equation, with their constants.
+}
+@example {
+	Example - regressions for n soils:
+	    std::vector<float> basis ( 7 * n ), regressions ( 3 * n );
+	    teh::SWCharEstMatrix::Basis( n, sand, clay, ompc, &basis[0], n );
+	    teh::SWCharEstMatrix::Regressions( n, &basis[0], n, &regressions[0], n );
+	    // theta33t of soil i is regressions[ SWCharEstMatrix::Theta33t * n + i ]
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstMatrix_h
+#define INC_teh_SWCharEstMatrix_h
+
+#include <cstddef>
+
+namespace teh {
+
+
+    class SWCharEstMatrix
+    {
+      public:
+
+	/// Basis terms; the columns of the coefficient matrix.
+	enum BasisTerm
+	{
+	    BasisSand,		///< sand
+	    BasisClay,		///< clay
+	    BasisOM,		///< OM, with the upper limit of 70%
+	    BasisSandOM,	///< sand * OM
+	    BasisClayOM,	///< clay * OM
+	    BasisSandClay,	///< sand * clay
+	    BasisOne,		///< 1; the intercept
+	    numBasisTerms
+	};
+
+	/// Regressions; the rows of the coefficient matrix.
+	enum Regression
+	{
+	    Theta1500t,		///< wilting point, first solution
+	    Theta33t,		///< field capacity, first solution
+	    ThetaS33t,		///< saturation - field capacity, first solution
+	    numRegressions
+	};
+
+	/// Saxton & Rawls (2006) regression coefficients, table 1.
+	/// Stored in double precision, so that double evaluations use the
+	/// published values; each rounds to the same float as its literal.
+	static constexpr double coefficients[numRegressions][numBasisTerms] = {
+	    //  sand     clay    om      sand*om  clay*om  sand*clay  1
+	    { -0.024,   0.487,  0.006,   0.005,  -0.013,   0.068,    0.031  },	// theta1500t
+	    { -0.251,   0.195,  0.011,   0.006,  -0.027,   0.452,    0.299  },	// theta33t
+	    {  0.278,   0.034,  0.022,  -0.018,  -0.027,  -0.584,    0.078  } };	// thetaS33t
+
+	/// Regression r of one soil, with the terms summed in the order
+	/// of SWCharEst::Evaluate, sand first and the intercept last,
+	/// so that the result is the same as Evaluate's.
+	/// Evaluate keeps its written-out form of the published equations.
+	template
+	<
+	    typename T				///< floating-point type
+	>
+	static constexpr T Regress (
+	    Regression const r,			///< which regression
+	    T const sand,			///< sand fraction (0-1)
+	    T const clay,			///< clay fraction (0-1)
+	    T const om)				///< organic matter wt %, at most 70
+	{
+	    return T( coefficients[r][BasisSand] ) * sand
+		 + T( coefficients[r][BasisClay] ) * clay
+		 + T( coefficients[r][BasisOM] ) * om
+		 + T( coefficients[r][BasisSandOM] ) * sand * om
+		 + T( coefficients[r][BasisClayOM] ) * clay * om
+		 + T( coefficients[r][BasisSandClay] ) * sand * clay
+		 + T( coefficients[r][BasisOne] );
+	}
+
+	/// Builds the 7 x n block of basis terms.
+	/// Row k, soil i is basis[ k * ldBasis + i ].
+	static void Basis (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const basis,		///< output: 7 x n basis terms
+	    std::size_t const ldBasis );	///< row stride of basis (>= n)
+
+	/// Calculates the 3 x n regressions = coefficients x basis.
+	/// Row r, soil i is regressions[ r * ldRegressions + i ].
+	static void Regressions (
+	    std::size_t const n,		///< number of soils
+	    float const * const basis,		///< 7 x n basis terms
+	    std::size_t const ldBasis,		///< row stride of basis (>= n)
+	    float * const regressions,		///< output: 3 x n regressions
+	    std::size_t const ldRegressions );	///< row stride of regressions (>= n)
+
+	/// Applies the constraints of SWCharEst::Evaluate to the regressions,
+	/// and calculates Ks. Soils with valid = 0 get zero results.
+	/// This is also the last stage of the portable SWCharEst::GetBatch.
+	/// Does not allocate memory.
+	static void Results (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const valid,		///< 1 = valid soil, 0 = invalid
+	    float const * const regressions,	///< 3 x n regressions
+	    std::size_t const ldRegressions,	///< row stride of regressions (>= n)
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks);			///< output: sat. hydraulic conductivity
+
+	/// SWCharEst::GetBatch using the matrix form of the regressions.
+	/// Invalid inputs give zero results.
+	/// Does not allocate memory.
+	static void GetBatch (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks);			///< output: sat. hydraulic conductivity
+
+      private:
+
+	// not used
+	SWCharEstMatrix ();
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstMatrix_h
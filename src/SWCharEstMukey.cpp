@@ -0,0 +1,260 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstMukey.cpp
+// class	teh::SWCharEstMukey
+// brief 	Join of a raster of map-unit keys to a table of soils.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstMukey.h"
+#include "SWCharEst.h"
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define TEH_SWCHAREST_STREAM
+#endif
+
+
+namespace teh {
+
+
+namespace {
+
+    uint32_t const noRow = ~uint32_t(0);
+
+    // Number of cells per block in Join.
+    // The block rows fit in the L1 cache.
+    std::size_t const blockSize = 1024;
+
+    // How far ahead to prefetch, in cells.
+    std::size_t const prefetchKeys = 32;
+    std::size_t const prefetchRows = 16;
+
+    // Keys are mapped by a direct array if their range is at most this,
+    // or 16 times the number of keys.
+    uint64_t const maxDirectRange = uint64_t(1) << 24;
+
+    inline void Prefetch ( void const * const p )
+    {
+#if defined(__GNUC__)
+	__builtin_prefetch( p );
+#else
+	(void) p;
+#endif
+    }
+
+    inline std::size_t Hash (
+	int32_t const key,
+	unsigned const slotBits )
+    {
+	return static_cast<std::size_t>(
+	    ( static_cast<uint64_t>( static_cast<uint32_t>( key ) ) * 0x9e3779b97f4a7c15ull )
+	    >> ( 64 - slotBits ) );
+    }
+
+} // namespace
+
+
+SWCharEstMukey::SWCharEstMukey (
+    std::size_t const n,		// number of map units
+    int32_t const * const keys,		// map-unit keys
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float const nodataValue )		// output of cells with unknown keys
+    : numKeys ( n ),
+      nodata ( nodataValue ),
+      streaming ( true ),
+      rows ( n + 1 ),
+      minKey ( 0 ),
+      slotBits ( 0 )
+{
+    std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+    if ( n > 0 )
+	SWCharEst::GetBatch( n, sand, clay, ompc, &wp[0], &fc[0], &thetaS[0], &ks[0] );
+    for ( std::size_t r = 0; r < n; ++r )
+    {
+	Row const row = { wp[r], fc[r], thetaS[r], ks[r] };
+	rows[r] = row;
+    }
+    Row const missing = { nodata, nodata, nodata, nodata };
+    rows[n] = missing;
+    if ( n == 0 )
+	return;
+
+    int32_t const maxKey = *std::max_element( keys, keys + n );
+    minKey = *std::min_element( keys, keys + n );
+    uint64_t const range = uint64_t( int64_t(maxKey) - int64_t(minKey) ) + 1;
+    if ( range <= std::max( maxDirectRange, uint64_t(16) * n ) )
+    {
+	direct.assign( range, static_cast<uint32_t>( n ) );
+	for ( std::size_t r = n; r-- > 0; )	// the first row of a key wins
+	    direct[ uint32_t(keys[r]) - uint32_t(minKey) ] = static_cast<uint32_t>( r );
+    }
+    else
+    {
+	slotBits = 4;
+	while ( ( std::size_t(1) << slotBits ) < 2 * n )	// load <= 1/2
+	    ++slotBits;
+	Slot const empty = { 0, noRow };
+	slots.assign( std::size_t(1) << slotBits, empty );
+	std::size_t const mask = slots.size() - 1;
+	for ( std::size_t r = 0; r < n; ++r )
+	{
+	    std::size_t i = Hash( keys[r], slotBits );
+	    while ( slots[i].row != noRow && slots[i].key != keys[r] )
+		i = ( i + 1 ) & mask;
+	    if ( slots[i].row == noRow )
+	    {
+		slots[i].key = keys[r];
+		slots[i].row = static_cast<uint32_t>( r );
+	    }
+	}
+    }
+}
+
+std::size_t SWCharEstMukey::Find (
+    int32_t const key ) const
+{
+    if ( !direct.empty() )
+    {
+	uint32_t const offset = uint32_t(key) - uint32_t(minKey);
+	return ( offset < direct.size() ? direct[offset] : numKeys );
+    }
+    if ( slots.empty() )
+	return numKeys;
+    std::size_t const mask = slots.size() - 1;
+    for ( std::size_t i = Hash( key, slotBits ); ; i = ( i + 1 ) & mask )
+    {
+	if ( slots[i].row == noRow )
+	    return numKeys;
+	if ( slots[i].key == key )
+	    return slots[i].row;
+    }
+}
+
+std::size_t SWCharEstMukey::FindRows (
+    std::size_t const m,		// number of cells
+    int32_t const * const cellKeys,	// map-unit key of each cell
+    uint32_t * const cellRows ) const	// output: table row of each cell
+{
+    std::size_t found = 0;
+    if ( !direct.empty() )
+    {
+	uint32_t const * const map = &direct[0];
+	uint32_t const size = static_cast<uint32_t>( direct.size() );
+	for ( std::size_t i = 0; i < m; ++i )
+	{
+	    if ( i + prefetchKeys < m )
+	    {
+		uint32_t const ahead = uint32_t( cellKeys[i + prefetchKeys] ) - uint32_t( minKey );
+		if ( ahead < size )
+		    Prefetch( map + ahead );
+	    }
+	    uint32_t const offset = uint32_t( cellKeys[i] ) - uint32_t( minKey );
+	    uint32_t const r = ( offset < size ? map[offset] : uint32_t(numKeys) );
+	    cellRows[i] = r;
+	    found += ( r != numKeys );
+	}
+    }
+    else
+    {
+	for ( std::size_t i = 0; i < m; ++i )
+	{
+	    if ( i + prefetchKeys < m && !slots.empty() )
+		Prefetch( &slots[ Hash( cellKeys[i + prefetchKeys], slotBits ) ] );
+	    // runs of one key are common in rasters
+	    std::size_t const r = ( i > 0 && cellKeys[i] == cellKeys[i - 1]
+				    ? cellRows[i - 1] : Find( cellKeys[i] ) );
+	    cellRows[i] = static_cast<uint32_t>( r );
+	    found += ( r != numKeys );
+	}
+    }
+    return found;
+}
+
+std::size_t SWCharEstMukey::Join (
+    std::size_t const n,		// number of cells
+    int32_t const * const cellKeys,	// map-unit key of each cell
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks) const		// output: sat. hydraulic conductivity
+{
+    uint32_t cellRows[blockSize];
+    Row const * const table = &rows[0];
+    std::size_t found = 0;
+
+#ifdef TEH_SWCHAREST_STREAM
+    // streaming stores need 16-byte aligned outputs, at the same offset
+    std::size_t const misalign = reinterpret_cast<uintptr_t>( wp ) % 16;
+    bool const stream = streaming &&
+	misalign % sizeof(float) == 0 &&
+	reinterpret_cast<uintptr_t>( fc ) % 16 == misalign &&
+	reinterpret_cast<uintptr_t>( thetaS ) % 16 == misalign &&
+	reinterpret_cast<uintptr_t>( ks ) % 16 == misalign;
+    // cells before the first aligned cell
+    std::size_t const head = ( misalign == 0 ? 0 : ( 16 - misalign ) / sizeof(float) );
+#endif
+
+    for ( std::size_t start = 0; start < n; start += blockSize )
+    {
+	std::size_t const m = std::min( blockSize, n - start );
+	found += FindRows( m, cellKeys + start, cellRows );
+
+	std::size_t j = 0;
+#ifdef TEH_SWCHAREST_STREAM
+	if ( stream )
+	{
+	    // scalar until the first aligned cell of the block
+	    std::size_t const first = ( start >= head ? ( 4 - ( start - head ) % 4 ) % 4
+						      : head - start );
+	    for ( ; j < m && j < first; ++j )
+	    {
+		Row const & row = table[ cellRows[j] ];
+		wp[start + j] = row.wp;
+		fc[start + j] = row.fc;
+		thetaS[start + j] = row.thetaS;
+		ks[start + j] = row.ks;
+	    }
+	    // 4 cells: 4 rows, transposed to 4 outputs
+	    for ( ; j + 4 <= m; j += 4 )
+	    {
+		if ( j + prefetchRows + 4 <= m )
+		    for ( std::size_t q = j + prefetchRows; q < j + prefetchRows + 4; ++q )
+			Prefetch( table + cellRows[q] );
+		__m128 r0 = _mm_loadu_ps( &table[ cellRows[j] ].wp );
+		__m128 r1 = _mm_loadu_ps( &table[ cellRows[j + 1] ].wp );
+		__m128 r2 = _mm_loadu_ps( &table[ cellRows[j + 2] ].wp );
+		__m128 r3 = _mm_loadu_ps( &table[ cellRows[j + 3] ].wp );
+		_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+		std::size_t const i = start + j;
+		_mm_stream_ps( wp + i, r0 );
+		_mm_stream_ps( fc + i, r1 );
+		_mm_stream_ps( thetaS + i, r2 );
+		_mm_stream_ps( ks + i, r3 );
+	    }
+	}
+#endif
+	for ( ; j < m; ++j )
+	{
+	    if ( j + prefetchRows < m )
+		Prefetch( table + cellRows[j + prefetchRows] );
+	    Row const & row = table[ cellRows[j] ];
+	    wp[start + j] = row.wp;
+	    fc[start + j] = row.fc;
+	    thetaS[start + j] = row.thetaS;
+	    ks[start + j] = row.ks;
+	}
+    }
+#ifdef TEH_SWCHAREST_STREAM
+    if ( stream )
+	_mm_sfence();	// order the streaming stores before later stores
+#endif
+    return found;
+}
+
+} // namespace teh
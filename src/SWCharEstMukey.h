@@ -0,0 +1,123 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstMukey.h
+@class		teh::SWCharEstMukey
+@brief 		Join of a raster of map-unit keys to a table of soils.
+@details {
+		For a raster of integer map-unit keys (mukeys) and a table
+		of sand, clay and OM for each key, the constructor evaluates
+		the table once with SWCharEst::GetBatch, and Join gathers
+		the results of each cell into the output rasters.
+		Cells with a key not in the table get the nodata value.
+		The keys are mapped to table rows by a direct array when
+		their range is small enough, else by a hash table.
+		Join works in blocks of cells: it finds the row of each
+		cell, prefetching the key map ahead, then gathers the rows,
+		prefetching them ahead, and writes the outputs with
+		non-temporal (streaming) stores, which bypass the cache,
+		so that a raster larger than the cache does not evict
+		the table. Use SetStreaming(false) if the outputs are
+		used at once, while they are still in the cache.
+		Table keys should be unique; for a repeated key the
+		first row is used.
+		After construction Join is const and thread-safe,
+		so threads may join parts of a raster.
+}
+@example {
+	Example:
+	    teh::SWCharEstMukey const table ( numKeys, &keys[0],
+					      &sand[0], &clay[0], &ompc[0] );
+	    table.Join( rows * cols, &cellKeys[0],
+			&wp[0], &fc[0], &thetaS[0], &ks[0] );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstMukey_h
+#define INC_teh_SWCharEstMukey_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstMukey
+    {
+      public:
+
+	/// Evaluates the soils of a table of numKeys map units.
+	SWCharEstMukey (
+	    std::size_t const numKeys,		///< number of map units
+	    int32_t const * const keys,		///< map-unit keys
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float const nodata = -9999.0f );	///< output of cells with unknown keys
+
+	/// Returns the number of map units in the table.
+	std::size_t NumKeys () const { return numKeys; }
+
+	/// Returns the table row of a key, or NumKeys() if not found.
+	std::size_t Find (
+	    int32_t const key ) const;
+
+	/// Gathers the results of n cells from their keys.
+	/// Returns the number of cells with a key in the table.
+	std::size_t Join (
+	    std::size_t const n,		///< number of cells
+	    int32_t const * const cellKeys,	///< map-unit key of each cell
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks) const;		///< output: sat. hydraulic conductivity
+
+	/// Use streaming stores in Join (default true).
+	void SetStreaming ( bool const stream ) { streaming = stream; }
+	bool Streaming () const { return streaming; }
+
+	float Nodata () const { return nodata; }
+
+	/// True if the keys are mapped by a direct array.
+	bool IsDirect () const { return !direct.empty(); }
+
+      private:
+
+	// results of one map unit, so that a gather reads one 16-byte row
+	struct Row
+	{
+	    float wp, fc, thetaS, ks;
+	};
+
+	// a hash table slot; empty if row == ~0
+	struct Slot
+	{
+	    int32_t key;
+	    uint32_t row;
+	};
+
+	std::size_t const numKeys;
+	float const nodata;
+	bool streaming;
+	std::vector<Row> rows;		// numKeys + 1; the last is nodata
+
+	// key to row: direct array from minKey, or hash table
+	int32_t minKey;
+	std::vector<uint32_t> direct;
+	std::vector<Slot> slots;
+	unsigned slotBits;		// slots.size() == 1 << slotBits
+
+	// rows of m cells, m <= block size
+	std::size_t FindRows (
+	    std::size_t const m,
+	    int32_t const * const cellKeys,
+	    uint32_t * const cellRows ) const;
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstMukey_h
@@ -0,0 +1,496 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstNpy.cpp
+// class	teh::SWCharEstNpy
+// brief 	Evaluates arrays of sand, clay and OM in NumPy .npy and .npz files.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstNpy.h"
+#include "SWCharEst.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Elements per call of GetBatch.
+    std::size_t const blockSize = 1 << 16;
+
+    char const * const outputNames[4] = { "wp", "fc", "thetaS", "ks" };
+    char const * const inputNames[3] = { "sand", "clay", "om" };
+
+    bool LittleEndian ()
+    {
+	uint16_t const one = 1;
+	unsigned char first;
+	std::memcpy( &first, &one, 1 );
+	return first == 1;
+    }
+
+    // little-endian integers, as in the .npy and zip headers
+    uint64_t ReadLE (
+	char const * const p,
+	std::size_t const numBytes )
+    {
+	uint64_t value = 0;
+	for ( std::size_t i = numBytes; i-- > 0; )
+	    value = ( value << 8 ) | static_cast<unsigned char>( p[i] );
+	return value;
+    }
+
+    uint32_t Swap32 ( uint32_t const u )
+    {
+	return ( u >> 24 ) | ( ( u >> 8 ) & 0xFF00u ) | ( ( u << 8 ) & 0xFF0000u ) | ( u << 24 );
+    }
+
+    uint64_t Swap64 ( uint64_t const u )
+    {
+	return ( uint64_t( Swap32( uint32_t( u ) ) ) << 32 ) | Swap32( uint32_t( u >> 32 ) );
+    }
+
+    // Returns the offset of the value of 'key' in the header dictionary,
+    // or npos if it is not there.
+    std::size_t FindKey (
+	std::string const & header,
+	char const * const key )
+    {
+	std::string const quoted = std::string( "'" ) + key + "'";
+	std::size_t at = header.find( quoted );
+	if ( at == std::string::npos )
+	    at = header.find( std::string( "\"" ) + key + "\"" );
+	if ( at == std::string::npos )
+	    return at;
+	at = header.find_first_not_of( " ", at + quoted.size() );
+	if ( at == std::string::npos || header[at] != ':' )
+	    return std::string::npos;
+	return header.find_first_not_of( " ", at + 1 );
+    }
+
+    // Copies n elements of the array, from first, to floats.
+    void Convert (
+	SWCharEstNpy::Array const & array,
+	std::size_t const first,
+	std::size_t const n,
+	float * const out )
+    {
+	char const * const p = array.data + first * array.itemSize;
+	if ( array.itemSize == 4 )
+	{
+	    for ( std::size_t i = 0; i < n; ++i )
+	    {
+		uint32_t u;
+		std::memcpy( &u, p + 4 * i, 4 );
+		if ( array.swap )
+		    u = Swap32( u );
+		std::memcpy( out + i, &u, 4 );
+	    }
+	}
+	else
+	{
+	    for ( std::size_t i = 0; i < n; ++i )
+	    {
+		uint64_t u;
+		std::memcpy( &u, p + 8 * i, 8 );
+		if ( array.swap )
+		    u = Swap64( u );
+		double d;
+		std::memcpy( &d, &u, 8 );
+		out[i] = static_cast<float>( d );
+	    }
+	}
+    }
+
+    // Writes the .npy header for an array of descr, with 64-byte alignment.
+    void WriteHeader (
+	std::ostream & os,
+	std::string const & descr,
+	SWCharEstNpy::Array const & shape )
+    {
+	std::string text = "{'descr': " + descr + ", 'fortran_order': " +
+			   ( shape.fortranOrder ? "True" : "False" ) + ", 'shape': (";
+	for ( std::size_t d = 0; d < shape.shape.size(); ++d )
+	{
+	    text += ( d > 0 ? ", " : "" ) + std::to_string( shape.shape[d] );
+	    if ( shape.shape.size() == 1 )
+		text += ",";
+	}
+	text += "), }";
+	std::size_t lengthSize = 2;		// version 1.0
+	if ( 10 + text.size() + 1 > 65535 )
+	    lengthSize = 4;			// version 2.0
+	std::size_t const total = ( 8 + lengthSize + text.size() + 1 + 63 ) / 64 * 64;
+	text.append( total - 8 - lengthSize - text.size() - 1, ' ' );
+	text += '\n';
+	os.write( "\x93NUMPY", 6 );
+	os.put( lengthSize == 2 ? 1 : 2 );
+	os.put( 0 );
+	for ( std::size_t i = 0; i < lengthSize; ++i )
+	    os.put( static_cast<char>( ( text.size() >> ( 8 * i ) ) & 0xFF ) );
+	os.write( text.data(), text.size() );
+    }
+
+    // Finds the contents of a member of a zip file, which must be stored,
+    // not compressed; returns false, with a message, if it is not found.
+    bool FindMember (
+	char const * const zip,
+	std::size_t const size,
+	std::string const & name,
+	char const * & member,
+	std::size_t & memberSize,
+	std::string & message )
+    {
+	// end of the central directory, before a comment
+	std::size_t end = ( size >= 22 ? size - 22 : 0 );
+	while ( size >= 22 && ReadLE( zip + end, 4 ) != 0x06054b50 )
+	{
+	    if ( end == 0 || size - end > 22 + 65535 )
+		break;
+	    --end;
+	}
+	if ( size < 22 || ReadLE( zip + end, 4 ) != 0x06054b50 )
+	{
+	    message = "not a .npz (zip) file";
+	    return false;
+	}
+	uint64_t count = ReadLE( zip + end + 10, 2 );
+	uint64_t offset = ReadLE( zip + end + 16, 4 );
+	if ( count == 0xFFFF || offset == 0xFFFFFFFF )	// zip64
+	{
+	    uint64_t const end64 = ( end >= 20 && ReadLE( zip + end - 20, 4 ) == 0x07064b50 ?
+				     ReadLE( zip + end - 12, 8 ) : size );
+	    if ( size < 56 || end64 > size - 56 || ReadLE( zip + end64, 4 ) != 0x06064b50 )
+	    {
+		message = "the zip64 directory is not found";
+		return false;
+	    }
+	    count = ReadLE( zip + end64 + 32, 8 );
+	    offset = ReadLE( zip + end64 + 48, 8 );
+	}
+
+	for ( uint64_t i = 0; i < count; ++i )
+	{
+	    if ( offset > size || size - offset < 46 || ReadLE( zip + offset, 4 ) != 0x02014b50 )
+		break;
+	    char const * const entry = zip + offset;
+	    std::size_t const nameSize = ReadLE( entry + 28, 2 );
+	    std::size_t const extraSize = ReadLE( entry + 30, 2 );
+	    offset += 46 + nameSize + extraSize + ReadLE( entry + 32, 2 );
+	    if ( offset > size || std::string( entry + 46, nameSize ) != name )
+		continue;
+
+	    uint64_t const method = ReadLE( entry + 10, 2 );
+	    uint64_t sizes[3] = { ReadLE( entry + 24, 4 ),	// uncompressed
+				  ReadLE( entry + 20, 4 ),	// compressed
+				  ReadLE( entry + 42, 4 ) };	// local header
+	    for ( char const * extra = entry + 46 + nameSize;
+		  extra + 4 <= entry + 46 + nameSize + extraSize; )
+	    {
+		std::size_t const fieldSize = ReadLE( extra + 2, 2 );
+		if ( ReadLE( extra, 2 ) == 1 )			// zip64 sizes
+		{
+		    char const * value = extra + 4;
+		    for ( int k = 0; k < 3; ++k )
+			if ( sizes[k] == 0xFFFFFFFF && value + 8 <= extra + 4 + fieldSize )
+			{
+			    sizes[k] = ReadLE( value, 8 );
+			    value += 8;
+			}
+		}
+		extra += 4 + fieldSize;
+	    }
+	    if ( method != 0 )
+	    {
+		message = name + " is compressed; write it with numpy.savez";
+		return false;
+	    }
+	    uint64_t const local = sizes[2];
+	    if ( local > size || size - local < 30 || ReadLE( zip + local, 4 ) != 0x04034b50 )
+		break;
+	    uint64_t const begin = local + 30 + ReadLE( zip + local + 26, 2 ) + ReadLE( zip + local + 28, 2 );
+	    if ( begin > size || size - begin < sizes[0] )
+		break;
+	    member = zip + begin;
+	    memberSize = static_cast<std::size_t>( sizes[0] );
+	    return true;
+	}
+	message = "no " + name + " in the file, or the file is damaged";
+	return false;
+    }
+
+} // namespace
+
+
+SWCharEstNpy::SWCharEstNpy (
+    Layout const outputLayout )		// output files
+    : layout ( outputLayout ),
+      numElements ( 0 ),
+      numInvalid ( 0 ),
+      zeroCopy ( false )
+{
+}
+
+bool SWCharEstNpy::ReadArray (
+    char const * const data,		// contents of the file
+    std::size_t const size,		// bytes in data
+    Array & array,			// output: the array
+    std::string & message )		// output: why it cannot be used
+{
+    if ( size < 10 || std::memcmp( data, "\x93NUMPY", 6 ) != 0 )
+    {
+	message = "not a .npy file";
+	return false;
+    }
+    int const version = data[6];
+    std::size_t const lengthSize = ( version == 1 ? 2 : 4 );
+    if ( version < 1 || version > 3 || size < 8 + lengthSize )
+    {
+	message = "unknown .npy version";
+	return false;
+    }
+    std::size_t const length = ReadLE( data + 8, lengthSize );
+    std::size_t const dataOffset = 8 + lengthSize + length;
+    if ( dataOffset > size )
+    {
+	message = "the .npy header is truncated";
+	return false;
+    }
+    std::string const header ( data + 8 + lengthSize, length );
+
+    // dtype: a string such as '<f4'; a list is a structured dtype
+    std::size_t at = FindKey( header, "descr" );
+    std::string descr;
+    if ( at != std::string::npos && ( header[at] == '\'' || header[at] == '"' ) )
+    {
+	std::size_t const close = header.find( header[at], at + 1 );
+	if ( close != std::string::npos )
+	    descr = header.substr( at + 1, close - at - 1 );
+    }
+    std::string const orders = "<>|=";
+    std::string const type = ( !descr.empty() && orders.find( descr[0] ) != std::string::npos ?
+			       descr.substr( 1 ) : descr );
+    if ( type != "f4" && type != "f8" )
+    {
+	message = "the dtype is not float32 or float64: " +
+		  ( at != std::string::npos ? header.substr( at, header.find_first_of( ",}", at ) - at ) : header );
+	return false;
+    }
+    array.itemSize = ( type == "f4" ? 4 : 8 );
+    array.swap = ( descr[0] == '<' && !LittleEndian() ) || ( descr[0] == '>' && LittleEndian() );
+
+    at = FindKey( header, "fortran_order" );
+    array.fortranOrder = ( at != std::string::npos && header.compare( at, 4, "True" ) == 0 );
+
+    // shape: a tuple of integers
+    at = FindKey( header, "shape" );
+    if ( at == std::string::npos || header[at] != '(' )
+    {
+	message = "the .npy header has no shape";
+	return false;
+    }
+    array.shape.clear();
+    array.numElements = 1;
+    std::size_t const maxElements = ( size - dataOffset ) / array.itemSize;
+    for ( ++at; at < header.size() && header[at] != ')'; )
+    {
+	char const c = header[at];
+	if ( c == ' ' || c == ',' )
+	{
+	    ++at;
+	    continue;
+	}
+	char * end;
+	unsigned long long const n = std::strtoull( header.c_str() + at, &end, 10 );
+	if ( end == header.c_str() + at )
+	    break;
+	array.shape.push_back( static_cast<std::size_t>( n ) );
+	array.numElements = ( n == 0 || array.numElements <= maxElements / n ?
+			      array.numElements * n : maxElements + 1 );
+	at = end - header.c_str();
+    }
+    if ( at >= header.size() || header[at] != ')' )
+    {
+	message = "the .npy shape is not read";
+	return false;
+    }
+    if ( array.numElements > maxElements )
+    {
+	message = "the .npy data is truncated";
+	return false;
+    }
+    array.data = data + dataOffset;
+    return true;
+}
+
+bool SWCharEstNpy::Run (
+    std::string const & sandFile,	// sand fractions (0-1)
+    std::string const & clayFile,	// clay fractions (0-1)
+    std::string const & omFile,		// organic matter wt %
+    std::string const & output )	// .npy file, or prefix if Separate
+{
+    numElements = numInvalid = 0;
+    zeroCopy = false;
+    errorMessage.clear();
+    std::string const * const fileNames[3] = { &sandFile, &clayFile, &omFile };
+    MappedFile const sand ( sandFile ), clay ( clayFile ), om ( omFile );
+    MappedFile const * const files[3] = { &sand, &clay, &om };
+    Array inputs[3];
+    for ( int k = 0; k < 3; ++k )
+    {
+	std::string message;
+	if ( !files[k]->IsOpen() )
+	    message = files[k]->ErrorMessage();
+	else if ( !ReadArray( files[k]->Data(), files[k]->Size(), inputs[k], message ) )
+	    message = *fileNames[k] + ": " + message;
+	if ( !message.empty() )
+	{
+	    errorMessage = "SWCharEstNpy: " + message;
+	    return false;
+	}
+    }
+    return Evaluate( inputs, output );
+}
+
+bool SWCharEstNpy::RunNpz (
+    std::string const & npzFile,	// input arrays
+    std::string const & output )	// .npy file, or prefix if Separate
+{
+    numElements = numInvalid = 0;
+    zeroCopy = false;
+    errorMessage.clear();
+    MappedFile const file ( npzFile );
+    if ( !file.IsOpen() )
+    {
+	errorMessage = "SWCharEstNpy: " + file.ErrorMessage();
+	return false;
+    }
+    Array inputs[3];
+    for ( int k = 0; k < 3; ++k )
+    {
+	std::string const name = std::string( inputNames[k] ) + ".npy";
+	char const * member = 0;
+	std::size_t memberSize = 0;
+	std::string message;
+	if ( !FindMember( file.Data(), file.Size(), name, member, memberSize, message ) ||
+	     !ReadArray( member, memberSize, inputs[k], message ) )
+	{
+	    errorMessage = "SWCharEstNpy: " + npzFile + ": " +
+			   ( member != 0 ? name + ": " : "" ) + message;
+	    return false;
+	}
+    }
+    return Evaluate( inputs, output );
+}
+
+// Evaluates the input arrays in blocks, and writes the results.
+bool SWCharEstNpy::Evaluate (
+    Array const (&inputs)[3],
+    std::string const & output )
+{
+    for ( int k = 1; k < 3; ++k )
+    {
+	if ( inputs[k].shape != inputs[0].shape ||
+	     ( inputs[k].fortranOrder != inputs[0].fortranOrder && inputs[0].shape.size() > 1 ) )
+	{
+	    errorMessage = "SWCharEstNpy: the arrays differ in shape or order";
+	    return false;
+	}
+    }
+
+    // in place if float32, in this byte order, and aligned
+    bool inPlace[3];
+    zeroCopy = true;
+    for ( int k = 0; k < 3; ++k )
+    {
+	inPlace[k] = inputs[k].itemSize == 4 && !inputs[k].swap &&
+		     reinterpret_cast<uintptr_t>( inputs[k].data ) % alignof(float) == 0;
+	zeroCopy = zeroCopy && inPlace[k];
+    }
+
+    std::string const order = ( LittleEndian() ? "'<f4'" : "'>f4'" );
+    std::size_t const numFiles = ( layout == Structured ? 1 : 4 );
+    std::ofstream files[4];
+    for ( std::size_t f = 0; f < numFiles; ++f )
+    {
+	std::string const fileName = ( layout == Structured ? output :
+				       output + outputNames[f] + ".npy" );
+	files[f].open( fileName.c_str(), std::ios::binary | std::ios::trunc );
+	if ( !files[f].is_open() )
+	{
+	    errorMessage = "SWCharEstNpy: cannot create " + fileName;
+	    return false;
+	}
+	if ( layout == Structured )
+	{
+	    std::string descr = "[";
+	    for ( std::size_t k = 0; k < 4; ++k )
+		descr += ( k > 0 ? ", ('" : "('" ) + std::string( outputNames[k] ) + "', " + order + ")";
+	    WriteHeader( files[f], descr + "]", inputs[0] );
+	}
+	else
+	    WriteHeader( files[f], order, inputs[0] );
+    }
+
+    std::size_t const n = inputs[0].numElements;
+    std::size_t const size = std::min( n, blockSize );
+    std::vector<float> converted ( 3 * size ), results ( 4 * size ), records;
+    if ( layout == Structured )
+	records.resize( 4 * size );
+    bool ok = true;
+    for ( std::size_t first = 0; first < n && ok; first += size )
+    {
+	std::size_t const m = std::min( size, n - first );
+	float const * in[3];
+	for ( int k = 0; k < 3; ++k )
+	{
+	    if ( inPlace[k] )
+		in[k] = reinterpret_cast<float const *>( inputs[k].data ) + first;
+	    else
+	    {
+		Convert( inputs[k], first, m, &converted[k * size] );
+		in[k] = &converted[k * size];
+	    }
+	}
+	float * const r = &results[0];
+	numInvalid += SWCharEst::GetBatch( m, in[0], in[1], in[2],
+					   r, r + size, r + 2 * size, r + 3 * size, 0 );
+	if ( layout == Structured )
+	{
+	    for ( std::size_t i = 0; i < m; ++i )
+		for ( std::size_t k = 0; k < 4; ++k )
+		    records[4 * i + k] = r[k * size + i];
+	    files[0].write( reinterpret_cast<char const *>( &records[0] ), 4 * m * sizeof(float) );
+	}
+	else
+	{
+	    for ( std::size_t k = 0; k < 4; ++k )
+		files[k].write( reinterpret_cast<char const *>( r + k * size ), m * sizeof(float) );
+	}
+	for ( std::size_t f = 0; f < numFiles; ++f )
+	    ok = ok && files[f].good();
+    }
+    for ( std::size_t f = 0; f < numFiles; ++f )
+    {
+	files[f].close();
+	ok = ok && !files[f].fail();
+    }
+    if ( !ok )
+    {
+	errorMessage = "SWCharEstNpy: writing failed";
+	return false;
+    }
+    numElements = n;
+    return true;
+}
+
+} // namespace teh
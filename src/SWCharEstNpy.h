@@ -0,0 +1,132 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstNpy.h
+@class		teh::SWCharEstNpy
+@brief 		Evaluates arrays of sand, clay and OM in NumPy .npy and .npz files.
+@details {
+		Run reads three .npy files, of sand fractions (0-1),
+		clay fractions (0-1) and organic matter wt %, and RunNpz
+		reads the arrays "sand", "clay" and "om" of a .npz file,
+		as written by numpy.savez. The arrays must have the
+		same shape and order, and a dtype of float32 or float64,
+		in either byte order.
+		The input files are mapped into memory with MappedFile,
+		and are evaluated with SWCharEst::GetBatch in blocks.
+		Float32 arrays in the byte order of this computer, with
+		aligned data, are used in place, with no copy (as in a
+		.npy file, which aligns its data to 64 bytes); others are
+		converted one block at a time. ZeroCopy tells which was done.
+		The results are written as they are found, so the memory
+		used does not depend on the size of the arrays:
+		either one .npy file of a structured array, with the
+		float32 fields wp, fc, thetaS and ks, or four .npy files of
+		float32 arrays, named by the output prefix and the fields,
+		such as "results_wp.npy". The results have the shape
+		and order of the inputs, and elements with invalid inputs
+		have zero results, as in GetBatch.
+		Compressed .npz files (numpy.savez_compressed), structured
+		inputs, and other dtypes are not read.
+		Run and RunNpz return false, with a message from
+		ErrorMessage, if a file cannot be read or written, or an
+		array cannot be used.
+}
+@example {
+	Example:
+	    teh::SWCharEstNpy npy ( teh::SWCharEstNpy::Separate );
+	    if ( !npy.Run( "sand.npy", "clay.npy", "om.npy", "results_" ) )
+		std::cerr << npy.ErrorMessage() << std::endl;
+
+	In Python:
+	    r = numpy.load( "results.npy", mmap_mode="r" )	# structured
+	    wp = r["wp"]
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstNpy_h
+#define INC_teh_SWCharEstNpy_h
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstNpy
+    {
+      public:
+
+	/// Output files.
+	enum Layout
+	{
+	    Structured,		///< one .npy of records of wp, fc, thetaS, ks
+	    Separate		///< four .npy of float32: prefix + "wp.npy", ...
+	};
+
+	/// An array in a .npy file.
+	struct Array
+	{
+	    char const * data;			///< first element
+	    std::size_t itemSize;		///< bytes per element: 4 or 8
+	    bool swap;				///< bytes are in the other order
+	    bool fortranOrder;			///< column-major
+	    std::vector<std::size_t> shape;	///< dimensions
+	    std::size_t numElements;		///< product of shape
+	};
+
+	explicit SWCharEstNpy (
+	    Layout const layout = Structured );	///< output files
+
+	/// Evaluates the arrays of three .npy files; returns false if failed.
+	bool Run (
+	    std::string const & sandFile,	///< sand fractions (0-1)
+	    std::string const & clayFile,	///< clay fractions (0-1)
+	    std::string const & omFile,		///< organic matter wt %
+	    std::string const & output );	///< .npy file, or prefix if Separate
+
+	/// Evaluates the arrays "sand", "clay" and "om" of a .npz file;
+	/// returns false if failed.
+	bool RunNpz (
+	    std::string const & npzFile,	///< input arrays
+	    std::string const & output );	///< .npy file, or prefix if Separate
+
+	/// Finds the array in the contents of a .npy file;
+	/// returns false, with a message, if it cannot be used.
+	static bool ReadArray (
+	    char const * const data,		///< contents of the file
+	    std::size_t const size,		///< bytes in data
+	    Array & array,			///< output: the array
+	    std::string & message );		///< output: why it cannot be used
+
+	/// Message of the failure of the last Run or RunNpz.
+	std::string const & ErrorMessage () const { return errorMessage; }
+
+	/// Number of elements of the last Run or RunNpz.
+	std::size_t NumElements () const { return numElements; }
+
+	/// Number of elements with invalid inputs of the last Run or RunNpz.
+	std::size_t NumInvalid () const { return numInvalid; }
+
+	/// True if the inputs of the last Run or RunNpz were used in place.
+	bool ZeroCopy () const { return zeroCopy; }
+
+	Layout GetLayout () const { return layout; }
+
+      private:
+
+	Layout const layout;
+	std::size_t numElements;
+	std::size_t numInvalid;
+	bool zeroCopy;
+	std::string errorMessage;
+
+	bool Evaluate ( Array const (&inputs)[3], std::string const & output );
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstNpy_h
@@ -0,0 +1,76 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstParallel.cpp
+// class	teh::SWCharEstParallel
+// brief 	Multithreaded batch evaluation of the Saxton & Rawls equations.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstParallel.h"
+#include <algorithm>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Chunks are a multiple of this many soils: 64 bytes of floats,
+    // the cache line size, so that the chunks of 64-byte aligned
+    // outputs start on a cache line.
+    std::size_t const chunkMultiple = 16;
+
+} // namespace
+
+
+std::size_t const SWCharEstParallel::defaultChunkSize;
+
+SWCharEstParallel::SWCharEstParallel (
+    unsigned const numThreads,		// 0 = number of hardware threads
+    std::size_t const size )		// soils per chunk
+    : pool ( numThreads ),
+      chunkSize ( defaultChunkSize )
+{
+    SetChunkSize( size );
+}
+
+void SWCharEstParallel::SetChunkSize (
+    std::size_t const size )
+{
+    std::size_t const n = std::max( size, std::size_t(1) );
+    std::lock_guard<std::mutex> lock ( mutex );
+    chunkSize = ( n + chunkMultiple - 1 ) / chunkMultiple * chunkMultiple;
+}
+
+std::size_t SWCharEstParallel::ChunkSize () const
+{
+    std::lock_guard<std::mutex> lock ( mutex );
+    return chunkSize;
+}
+
+void SWCharEstParallel::GetBatch (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks,			// output: sat. hydraulic conductivity
+    BatchFunction const function )	// evaluates one chunk
+{
+    std::size_t const size = ChunkSize();
+    std::size_t const numChunks = ( n + size - 1 ) / size;
+    pool.Run( numChunks, [=] ( std::size_t const chunk, unsigned )
+    {
+	std::size_t const start = chunk * size;
+	std::size_t const m = std::min( size, n - start );
+	function( m, sand + start, clay + start, ompc + start,
+		  wp + start, fc + start, thetaS + start, ks + start );
+    } );
+}
+
+} // namespace teh
@@ -0,0 +1,99 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstParallel.h
+@class		teh::SWCharEstParallel
+@brief 		Multithreaded batch evaluation of the Saxton & Rawls equations.
+@details {
+		GetBatch splits the input arrays into chunks,
+		and evaluates the chunks in parallel with a persistent
+		ThreadPool, using SWCharEst::GetBatch or another
+		function with the same arguments, such as
+		SWCharEstMatrix::GetBatch.
+		The default chunk of 8192 soils has 224 KB of inputs
+		and outputs, which fits in the L2 cache of most CPUs.
+		Chunks are multiples of 16 soils, 64 bytes of each output,
+		so that threads do not write to the same cache line at the
+		chunk boundaries if the outputs are 64-byte aligned; if not,
+		the results are the same, but the threads of neighbouring
+		chunks may share a line at each boundary.
+		The results are the same as SWCharEst::GetBatch,
+		for any number of threads and chunk size.
+		One instance can be shared; calls of GetBatch from several
+		threads are run one at a time, and SetChunkSize applies to
+		the calls which start after it.
+}
+@example {
+	Example - all hardware threads:
+	    teh::SWCharEstParallel parallel;
+	    parallel.GetBatch( n, &sand[0], &clay[0], &ompc[0],
+			       &wp[0], &fc[0], &thetaS[0], &ks[0] );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstParallel_h
+#define INC_teh_SWCharEstParallel_h
+
+#include "SWCharEst.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <mutex>
+
+namespace teh {
+
+
+    class SWCharEstParallel
+    {
+      public:
+
+	/// A batch function with the arguments of SWCharEst::GetBatch.
+	typedef void (*BatchFunction) (
+	    std::size_t const, float const * const, float const * const, float const * const,
+	    float * const, float * const, float * const, float * const );
+
+	/// Default number of soils per chunk.
+	static std::size_t const defaultChunkSize = 8192;
+
+	/// Starts the thread pool.
+	explicit SWCharEstParallel (
+	    unsigned const numThreads = 0,	///< 0 = number of hardware threads
+	    std::size_t const chunkSize = defaultChunkSize );	///< soils per chunk
+
+	/// SWCharEst::GetBatch for n soils, in parallel.
+	void GetBatch (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks,			///< output: sat. hydraulic conductivity
+	    BatchFunction const function = SWCharEst::GetBatch );	///< evaluates one chunk
+
+	/// Returns the number of threads, including the calling thread.
+	unsigned NumThreads () const { return pool.NumThreads(); }
+
+	/// Returns the number of soils per chunk.
+	std::size_t ChunkSize () const;
+
+	/// Sets the number of soils per chunk; rounded up to a multiple of 16.
+	void SetChunkSize (
+	    std::size_t const size );
+
+	/// Returns the thread pool, for other parallel work.
+	ThreadPool & Pool () { return pool; }
+
+      private:
+
+	ThreadPool pool;
+	mutable std::mutex mutex;		// guards chunkSize
+	std::size_t chunkSize;
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstParallel_h
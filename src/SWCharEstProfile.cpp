@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstProfile.cpp
+// class	teh::SWCharEstProfile
+// brief 	Layered soil profiles, with depth-weighted available water.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstProfile.h"
+#include "SWCharEst.h"
+#include <algorithm>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Number of profiles per block in Evaluate.
+    // The horizon results of a block are still in the cache
+    // when the AWC is summed.
+    std::size_t const blockSize = 512;
+
+    // Adds (FC - WP) times the thickness of each horizon within
+    // top to bottom; for m profiles.
+    void AddAWC (
+	std::size_t const m,
+	float const * __restrict const horizonTop,
+	float const * __restrict const horizonBottom,
+	float const * __restrict const wp,
+	float const * __restrict const fc,
+	float const top,
+	float const bottom,
+	float * __restrict const awc )
+    {
+	for ( std::size_t p = 0; p < m; ++p )
+	{
+	    float const overlap = std::min( horizonBottom[p], bottom ) - std::max( horizonTop[p], top );
+	    awc[p] += ( fc[p] - wp[p] ) * std::max( overlap, 0.0f );
+	}
+    }
+
+} // namespace
+
+
+std::vector<SWCharEstProfile::Interval> SWCharEstProfile::StandardIntervals ()
+{
+    Interval const standard[] = { { 0.0f, 30.0f }, { 0.0f, 100.0f } };
+    return std::vector<Interval>( standard, standard + 2 );
+}
+
+SWCharEstProfile::SWCharEstProfile (
+    std::vector<Interval> const & depthIntervals )
+    : intervals ( depthIntervals )
+{
+}
+
+void SWCharEstProfile::Evaluate (
+    std::size_t const numProfiles,	// number of profiles
+    std::size_t const numHorizons,	// horizons per profile
+    float const * const thickness,	// horizon thickness (cm)
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks,			// output: sat. hydraulic conductivity
+    float * const awc,			// output: AWC of each interval (cm)
+    float const * const rootDepth,	// root zone depth of each profile (cm)
+    float * const rootAWC) const	// output: AWC of each root zone (cm)
+{
+    std::size_t const P = numProfiles;
+    std::size_t const numIntervals = intervals.size();
+    bool const rootZone = ( rootDepth != 0 && rootAWC != 0 );
+
+    float top[blockSize];		// depths of the horizon in each profile
+    float bottom[blockSize];
+    for ( std::size_t start = 0; start < P; start += blockSize )
+    {
+	std::size_t const m = std::min( blockSize, P - start );
+	std::fill( top, top + m, 0.0f );
+	for ( std::size_t i = 0; i < numIntervals; ++i )
+	    std::fill( awc + i * P + start, awc + i * P + start + m, 0.0f );
+	if ( rootZone )
+	    std::fill( rootAWC + start, rootAWC + start + m, 0.0f );
+
+	for ( std::size_t h = 0; h < numHorizons; ++h )
+	{
+	    std::size_t const offset = h * P + start;
+	    SWCharEst::GetBatch( m, sand + offset, clay + offset, ompc + offset,
+				 wp + offset, fc + offset, thetaS + offset, ks + offset );
+	    float const * __restrict const thk = thickness + offset;
+	    for ( std::size_t p = 0; p < m; ++p )
+		bottom[p] = top[p] + ( thk[p] > 0.0f ? thk[p] : 0.0f );	// NaN is absent
+
+	    for ( std::size_t i = 0; i < numIntervals; ++i )
+		AddAWC( m, top, bottom, wp + offset, fc + offset,
+			intervals[i].top, intervals[i].bottom, awc + i * P + start );
+	    if ( rootZone )
+	    {
+		float * __restrict const r = rootAWC + start;
+		float const * __restrict const depth = rootDepth + start;
+		float const * __restrict const w = wp + offset;
+		float const * __restrict const f = fc + offset;
+		for ( std::size_t p = 0; p < m; ++p )
+		{
+		    float const overlap = std::min( bottom[p], depth[p] ) - top[p];
+		    r[p] += ( f[p] - w[p] ) * std::max( overlap, 0.0f );
+		}
+	    }
+	    std::copy( bottom, bottom + m, top );
+	}
+    }
+}
+
+} // namespace teh
@@ -0,0 +1,99 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstProfile.h
+@class		teh::SWCharEstProfile
+@brief 		Layered soil profiles, with depth-weighted available water.
+@details {
+		Evaluates many profiles at once, each with up to
+		numHorizons horizons, from the surface down.
+		Arrays of horizon values are by horizon:
+		element [h * numProfiles + p] is horizon h of profile p,
+		so that each horizon is a batch across the profiles,
+		evaluated by SWCharEst::GetBatch, and the depth loop
+		is over contiguous profiles, which the compiler vectorizes
+		(g++ -O3).
+		A horizon with thickness <= 0 (or NaN) is absent.
+		Besides the results of each horizon, Evaluate finds the
+		available water capacity (AWC) of depth intervals:
+		the sum over horizons of (FC - WP) times the thickness
+		of the horizon within the interval, in cm of water.
+		The intervals are set in the constructor; the default
+		is 0-30 cm and 0-100 cm. A root zone, 0 to a depth
+		for each profile, may also be given.
+		Horizons with invalid inputs have zero results,
+		and add nothing to the AWC.
+		Depths and thicknesses are in cm.
+}
+@example {
+	Example:
+	    teh::SWCharEstProfile const profile;	// 0-30, 0-100 cm
+	    profile.Evaluate( numProfiles, numHorizons,
+			      &thickness[0], &sand[0], &clay[0], &ompc[0],
+			      &wp[0], &fc[0], &thetaS[0], &ks[0],
+			      &awc[0] );
+	    // AWC of profile p: awc[p] for 0-30 cm, awc[numProfiles + p] for 0-100 cm
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstProfile_h
+#define INC_teh_SWCharEstProfile_h
+
+#include <cstddef>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstProfile
+    {
+      public:
+
+	/// A depth interval, in cm from the surface.
+	struct Interval
+	{
+	    float top;		///< upper depth
+	    float bottom;	///< lower depth
+	};
+
+	/// Returns the intervals 0-30 cm and 0-100 cm.
+	static std::vector<Interval> StandardIntervals ();
+
+	/// AWC is found for each of the intervals.
+	SWCharEstProfile (
+	    std::vector<Interval> const & depthIntervals = StandardIntervals() );
+
+	/// Returns the intervals of the AWC outputs.
+	std::vector<Interval> const & Intervals () const { return intervals; }
+
+	/// Evaluates the horizons of numProfiles profiles,
+	/// and the AWC of each interval.
+	/// Horizon arrays have numHorizons * numProfiles elements,
+	/// by horizon; awc has Intervals().size() * numProfiles,
+	/// by interval.
+	void Evaluate (
+	    std::size_t const numProfiles,	///< number of profiles
+	    std::size_t const numHorizons,	///< horizons per profile
+	    float const * const thickness,	///< horizon thickness (cm)
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks,			///< output: sat. hydraulic conductivity
+	    float * const awc,			///< output: AWC of each interval (cm)
+	    float const * const rootDepth = 0,	///< root zone depth of each profile (cm)
+	    float * const rootAWC = 0) const;	///< output: AWC of each root zone (cm)
+
+      private:
+
+	std::vector<Interval> const intervals;
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstProfile_h
@@ -0,0 +1,338 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstRaster.cpp
+// class	teh::SWCharEstRaster
+// brief 	Parallel evaluation of rasters with nodata cells, by tiles,
+//		with a work-stealing scheduler.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstRaster.h"
+#include "SWCharEst.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+
+namespace teh {
+
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    // Cost of a valid cell relative to a nodata cell, which is only filled.
+    std::size_t const validCost = 32;
+
+    // The raster arguments of Evaluate, and the tile geometry.
+    struct Raster
+    {
+	std::size_t rows, cols;
+	std::size_t tileRows, tileCols;
+	std::size_t tilesAcross;
+	float const * sand;
+	float const * clay;
+	float const * ompc;
+	float inputNodata;
+	float nodata;
+	float * wp;
+	float * fc;
+	float * thetaS;
+	float * ks;
+
+	// first and last + 1 row and column of a tile
+	void Bounds (
+	    std::size_t const tile,
+	    std::size_t & r0, std::size_t & r1,
+	    std::size_t & c0, std::size_t & c1 ) const
+	{
+	    r0 = ( tile / tilesAcross ) * tileRows;
+	    c0 = ( tile % tilesAcross ) * tileCols;
+	    r1 = std::min( rows, r0 + tileRows );
+	    c1 = std::min( cols, c0 + tileCols );
+	}
+    };
+
+    // false if any input is nodata or NaN
+    inline bool IsData (
+	float const sand,
+	float const clay,
+	float const ompc,
+	float const nodata )
+    {
+	return sand == sand && clay == clay && ompc == ompc &&
+	       sand != nodata && clay != nodata && ompc != nodata;
+    }
+
+    std::size_t CountValid (
+	Raster const & raster,
+	std::size_t const tile )
+    {
+	std::size_t r0, r1, c0, c1;
+	raster.Bounds( tile, r0, r1, c0, c1 );
+	std::size_t count = 0;
+	for ( std::size_t r = r0; r < r1; ++r )
+	    for ( std::size_t i = r * raster.cols + c0; i < r * raster.cols + c1; ++i )
+		count += IsData( raster.sand[i], raster.clay[i], raster.ompc[i], raster.inputNodata );
+	return count;
+    }
+
+    // Gathers the valid cells of a tile, evaluates them, and scatters
+    // the results; nodata cells get nodata.
+    // Work arrays have the number of cells in a tile.
+    // Returns the number of valid cells.
+    std::size_t EvaluateTile (
+	Raster const & raster,
+	std::size_t const tile,
+	float * const work,		// 7 arrays
+	std::size_t * const index )	// raster index of each valid cell
+    {
+	std::size_t const size = raster.tileRows * raster.tileCols;
+	float * const sand = work;
+	float * const clay = work + size;
+	float * const ompc = work + 2 * size;
+	float * const wp = work + 3 * size;
+	float * const fc = work + 4 * size;
+	float * const thetaS = work + 5 * size;
+	float * const ks = work + 6 * size;
+
+	std::size_t r0, r1, c0, c1;
+	raster.Bounds( tile, r0, r1, c0, c1 );
+	std::size_t n = 0;
+	for ( std::size_t r = r0; r < r1; ++r )
+	    for ( std::size_t i = r * raster.cols + c0; i < r * raster.cols + c1; ++i )
+	    {
+		if ( IsData( raster.sand[i], raster.clay[i], raster.ompc[i], raster.inputNodata ) )
+		{
+		    sand[n] = raster.sand[i];
+		    clay[n] = raster.clay[i];
+		    ompc[n] = raster.ompc[i];
+		    index[n] = i;
+		    ++n;
+		}
+		else
+		{
+		    raster.wp[i] = raster.fc[i] = raster.thetaS[i] = raster.ks[i] = raster.nodata;
+		}
+	    }
+
+	SWCharEst::GetBatch( n, sand, clay, ompc, wp, fc, thetaS, ks );
+	for ( std::size_t k = 0; k < n; ++k )
+	{
+	    std::size_t const i = index[k];
+	    raster.wp[i] = wp[k];
+	    raster.fc[i] = fc[k];
+	    raster.thetaS[i] = thetaS[k];
+	    raster.ks[i] = ks[k];
+	}
+	return n;
+    }
+
+    // Tiles waiting for one worker, begin to end - 1.
+    // The worker takes tiles from the front, others steal from the back.
+    struct TileQueue
+    {
+	std::mutex mutex;
+	std::size_t begin;
+	std::size_t end;
+
+	bool PopFront ( std::size_t & tile )
+	{
+	    std::lock_guard<std::mutex> lock ( mutex );
+	    if ( begin == end )
+		return false;
+	    tile = begin++;
+	    return true;
+	}
+
+	bool PopBack ( std::size_t & tile )
+	{
+	    std::lock_guard<std::mutex> lock ( mutex );
+	    if ( begin == end )
+		return false;
+	    tile = --end;
+	    return true;
+	}
+    };
+
+    double Seconds ( Clock::duration const d )
+    {
+	return std::chrono::duration<double>( d ).count();
+    }
+
+} // namespace
+
+
+SWCharEstRaster::SWCharEstRaster (
+    ThreadPool & threadPool,		// threads which evaluate the tiles
+    int const rowsPerTile,		// rows per tile
+    int const colsPerTile,		// columns per tile
+    Schedule const tileSchedule )
+    : pool ( threadPool ),
+      tileRows ( std::max( 1, rowsPerTile ) ),
+      tileCols ( std::max( 1, colsPerTile ) ),
+      schedule ( tileSchedule )
+{
+    report.numTiles = report.validCells = 0;
+    report.seconds = 0.0;
+}
+
+void SWCharEstRaster::Evaluate (
+    std::size_t const rows,		// number of rows
+    std::size_t const cols,		// number of columns
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float const nodata,			// nodata value of inputs and outputs
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks)			// output: sat. hydraulic conductivity
+{
+    Evaluate( rows, cols, sand, clay, ompc, nodata, nodata, wp, fc, thetaS, ks );
+}
+
+void SWCharEstRaster::Evaluate (
+    std::size_t const rows,		// number of rows
+    std::size_t const cols,		// number of columns
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float const inputNodata,		// nodata value of the inputs
+    float const nodata,			// nodata value of the outputs
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks)			// output: sat. hydraulic conductivity
+{
+    Raster raster;
+    raster.rows = rows;
+    raster.cols = cols;
+    raster.tileRows = tileRows;
+    raster.tileCols = tileCols;
+    raster.tilesAcross = ( cols + tileCols - 1 ) / tileCols;
+    raster.sand = sand;
+    raster.clay = clay;
+    raster.ompc = ompc;
+    raster.inputNodata = inputNodata;
+    raster.nodata = nodata;
+    raster.wp = wp;
+    raster.fc = fc;
+    raster.thetaS = thetaS;
+    raster.ks = ks;
+    std::size_t const numTiles = raster.tilesAcross * ( ( rows + tileRows - 1 ) / tileRows );
+    std::size_t const numWorkers = std::max( std::size_t(1),
+				   std::min<std::size_t>( pool.NumThreads(), numTiles ) );
+
+    WorkerStats const zero = { 0, 0, 0, 0.0, 0.0 };
+    report.workers.assign( pool.NumThreads(), zero );
+    report.numTiles = numTiles;
+    report.validCells = 0;
+    report.seconds = 0.0;
+    if ( numTiles == 0 )
+	return;
+
+    // first tile of each worker's range
+    std::vector<std::size_t> first ( numWorkers + 1 );
+    if ( schedule == ScheduleBalanced )
+    {
+	// prefix sums of the tile costs
+	std::vector<std::size_t> cost ( numTiles + 1, 0 );
+	pool.Run( numTiles, [&raster, &cost] ( std::size_t const tile, unsigned )
+	{
+	    std::size_t r0, r1, c0, c1;
+	    raster.Bounds( tile, r0, r1, c0, c1 );
+	    std::size_t const valid = CountValid( raster, tile );
+	    cost[tile + 1] = validCost * valid + ( r1 - r0 ) * ( c1 - c0 ) - valid;
+	} );
+	for ( std::size_t t = 0; t < numTiles; ++t )
+	    cost[t + 1] += cost[t];
+	for ( std::size_t q = 0; q < numWorkers; ++q )
+	{
+	    std::size_t const target = cost[numTiles] / numWorkers * q;
+	    first[q] = std::lower_bound( cost.begin(), cost.end() - 1, target ) - cost.begin();
+	}
+    }
+    else
+    {
+	for ( std::size_t q = 0; q < numWorkers; ++q )
+	    first[q] = numTiles * q / numWorkers;
+    }
+    first[numWorkers] = numTiles;
+
+    std::unique_ptr<TileQueue[]> queues ( new TileQueue [numWorkers] );
+    for ( std::size_t q = 0; q < numWorkers; ++q )
+    {
+	queues[q].begin = first[q];
+	queues[q].end = std::max( first[q], first[q + 1] );
+    }
+
+    bool const steal = ( schedule == ScheduleBalanced );
+    std::size_t const tileSize = raster.tileRows * raster.tileCols;
+    Clock::time_point const start = Clock::now();
+    pool.Run( numWorkers, [&] ( std::size_t const q, unsigned const worker )
+    {
+	// by thread: one thread may run several queues, one after another
+	WorkerStats & stats = report.workers[worker];
+	std::vector<float> work ( 7 * tileSize );
+	std::vector<std::size_t> index ( tileSize );
+	Clock::duration busy ( 0 );
+	for ( ;; )
+	{
+	    std::size_t tile;
+	    bool stolen = false;
+	    if ( !queues[q].PopFront( tile ) )
+	    {
+		if ( !steal )
+		    break;
+		for ( std::size_t k = 1; k < numWorkers && !stolen; ++k )
+		    stolen = queues[ ( q + k ) % numWorkers ].PopBack( tile );
+		if ( !stolen )
+		    break;
+	    }
+	    Clock::time_point const t0 = Clock::now();
+	    stats.validCells += EvaluateTile( raster, tile, &work[0], &index[0] );
+	    busy += Clock::now() - t0;
+	    ++stats.tiles;
+	    stats.stolen += stolen;
+	}
+	stats.busySeconds += Seconds( busy );
+    } );
+    report.seconds = Seconds( Clock::now() - start );
+
+    for ( WorkerStats & stats : report.workers )
+    {
+	report.validCells += stats.validCells;
+	stats.utilization = ( report.seconds > 0.0 ? stats.busySeconds / report.seconds : 0.0 );
+    }
+}
+
+double SWCharEstRaster::Report::MinUtilization () const
+{
+    double u = ( workers.empty() ? 0.0 : workers[0].utilization );
+    for ( WorkerStats const & stats : workers )
+	u = std::min( u, stats.utilization );
+    return u;
+}
+
+void SWCharEstRaster::Report::Write (
+    std::ostream & os ) const
+{
+    os << "SWCharEstRaster: " << numTiles << " tiles, "
+       << validCells << " valid cells, " << seconds << " seconds\n";
+    for ( std::size_t q = 0; q < workers.size(); ++q )
+    {
+	WorkerStats const & w = workers[q];
+	os << "  thread " << q << ": " << w.tiles << " tiles (" << w.stolen << " stolen), "
+	   << w.validCells << " valid cells, " << w.busySeconds << " seconds busy, "
+	   << 100.0 * w.utilization << "% utilization\n";
+    }
+    os.flush();
+}
+
+} // namespace teh
@@ -0,0 +1,151 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstRaster.h
+@class		teh::SWCharEstRaster
+@brief 		Parallel evaluation of rasters with nodata cells, by tiles.
+@details {
+		Evaluates rasters of sand, clay and OM, stored by rows,
+		in which many cells may be nodata: a cell is nodata if any
+		of its inputs equals the nodata value or is NaN.
+		Nodata cells get the nodata value in each output.
+		Evaluate may also be given one nodata value for the
+		inputs and another for the outputs.
+		The raster is divided into tiles. The valid cells of
+		a tile are gathered, evaluated with SWCharEst::GetBatch,
+		and scattered to the outputs.
+		With ScheduleBalanced, the default, the valid cells in
+		each tile are counted first, and each worker is given
+		a contiguous range of tiles with about the same number
+		of valid cells. A worker which finishes its range steals
+		tiles from the end of the ranges of other workers.
+		With ScheduleStatic, each worker is given the same number
+		of tiles, with no stealing; use this to compare.
+		After each Evaluate, LastReport has the tiles, valid cells
+		and busy time of each thread of the pool, which may have
+		evaluated several ranges, and its utilization:
+		the busy time divided by the elapsed time.
+		The results are the same as SWCharEst::GetBatch, for any
+		tile size, number of threads and schedule.
+}
+@example {
+	Example:
+	    teh::ThreadPool pool;
+	    teh::SWCharEstRaster raster ( pool );
+	    raster.Evaluate( rows, cols, &sand[0], &clay[0], &ompc[0], -9999.0f,
+			     &wp[0], &fc[0], &thetaS[0], &ks[0] );
+	    raster.LastReport().Write( std::cout );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstRaster_h
+#define INC_teh_SWCharEstRaster_h
+
+#include "ThreadPool.h"
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstRaster
+    {
+      public:
+
+	/// How tiles are assigned to workers.
+	enum Schedule
+	{
+	    ScheduleBalanced,	///< ranges with equal valid cells, and stealing
+	    ScheduleStatic	///< ranges with equal numbers of tiles
+	};
+
+	/// Work done by one thread of the pool in Evaluate, which may
+	/// have evaluated the ranges of tiles of several workers.
+	struct WorkerStats
+	{
+	    std::size_t tiles;		///< tiles evaluated
+	    std::size_t stolen;		///< tiles stolen from other ranges
+	    std::size_t validCells;	///< valid cells evaluated
+	    double busySeconds;		///< time spent on tiles
+	    double utilization;		///< busySeconds / elapsed seconds
+	};
+
+	/// Work done by Evaluate.
+	struct Report
+	{
+	    std::vector<WorkerStats> workers;	///< one for each thread of the pool
+	    std::size_t numTiles;		///< number of tiles
+	    std::size_t validCells;		///< number of valid cells
+	    double seconds;			///< elapsed time of the tiles
+
+	    /// Returns the lowest utilization of the threads.
+	    double MinUtilization () const;
+
+	    /// Writes the statistics of each thread.
+	    void Write (
+		std::ostream & os ) const;
+	};
+
+	/// Uses the threads of the pool.
+	SWCharEstRaster (
+	    ThreadPool & threadPool,		///< threads which evaluate the tiles
+	    int const tileRows = 64,		///< rows per tile
+	    int const tileCols = 64,		///< columns per tile
+	    Schedule const schedule = ScheduleBalanced );
+
+	/// Evaluates a raster; all arrays have rows x cols cells, by rows.
+	void Evaluate (
+	    std::size_t const rows,		///< number of rows
+	    std::size_t const cols,		///< number of columns
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float const nodata,			///< nodata value of inputs and outputs
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks);			///< output: sat. hydraulic conductivity
+
+	/// Evaluates a raster, with one nodata value for the inputs
+	/// and another for the outputs. If inputNodata is NaN,
+	/// only NaN inputs are nodata.
+	void Evaluate (
+	    std::size_t const rows,		///< number of rows
+	    std::size_t const cols,		///< number of columns
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float const inputNodata,		///< nodata value of the inputs
+	    float const nodata,			///< nodata value of the outputs
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks);			///< output: sat. hydraulic conductivity
+
+	/// Statistics of the last Evaluate.
+	Report const & LastReport () const
+	  {
+	    return report;
+	  }
+
+	int TileRows () const { return tileRows; }
+	int TileCols () const { return tileCols; }
+	Schedule GetSchedule () const { return schedule; }
+	void SetSchedule ( Schedule const s ) { schedule = s; }
+
+      private:
+
+	ThreadPool & pool;
+	int const tileRows;
+	int const tileCols;
+	Schedule schedule;
+	Report report;
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstRaster_h
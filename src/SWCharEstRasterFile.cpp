@@ -0,0 +1,699 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstRasterFile.cpp
+// class	teh::SWCharEstRasterFile
+// brief 	Streams rasters of sand, clay and OM in ESRI ASCII grid or ENVI
+//		files to result rasters.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstRasterFile.h"
+#include "SWCharEstText.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+
+namespace teh {
+
+
+namespace {
+
+    // Bytes of an ASCII grid read at a time.
+    std::size_t const readSize = 1 << 18;
+
+    // Nodata value of the outputs if the sand raster has none.
+    float const defaultNodata = -9999.0f;
+
+    char const * const outputNames[4] = { "wp", "fc", "thetaS", "ks" };
+
+    // ENVI header keys of map coordinates, copied to the outputs
+    char const * const enviMapKeys[3] = { "map info", "coordinate system string", "projection info" };
+
+    enum Interleave { BSQ, BIL, BIP };
+
+    // keys and values of a header, as written
+    typedef std::vector< std::pair<std::string, std::string> > Keys;
+
+    inline bool IsSpace ( char const c )
+    {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    std::string Lower (
+	std::string s )
+    {
+	for ( std::size_t i = 0; i < s.size(); ++i )
+	    s[i] = static_cast<char>( std::tolower( static_cast<unsigned char>( s[i] ) ) );
+	return s;
+    }
+
+    std::string Trim (
+	std::string const & s )
+    {
+	std::size_t b = 0, e = s.size();
+	while ( b < e && IsSpace( s[b] ) )
+	    ++b;
+	while ( e > b && IsSpace( s[e - 1] ) )
+	    --e;
+	return s.substr( b, e - b );
+    }
+
+    // Reads a whole number; returns false if it is not one.
+    bool ReadCount (
+	std::string const & text,
+	std::size_t & count )
+    {
+	if ( text.empty() || text.find_first_not_of( "0123456789" ) != std::string::npos ||
+	     text.size() > 15 )
+	    return false;
+	count = static_cast<std::size_t>( std::strtoull( text.c_str(), 0, 10 ) );
+	return true;
+    }
+
+    bool LittleEndian ()
+    {
+	uint16_t const one = 1;
+	unsigned char first;
+	std::memcpy( &first, &one, 1 );
+	return first == 1;
+    }
+
+    // Returns the extension of the file name, in lower case, as ".asc".
+    std::string Extension (
+	std::string const & fileName )
+    {
+	std::size_t const dot = fileName.find_last_of( "./\\" );
+	if ( dot == std::string::npos || fileName[dot] != '.' )
+	    return std::string();
+	return Lower( fileName.substr( dot ) );
+    }
+
+    // Copies n elements of type T, stride elements apart, to floats.
+    template <typename T>
+    void ConvertRow (
+	char const * const p,
+	std::size_t const n,
+	std::size_t const stride,
+	bool const swap,
+	float * const out )
+    {
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    char bytes[sizeof(T)];
+	    std::memcpy( bytes, p + i * stride * sizeof(T), sizeof(T) );
+	    if ( swap )
+		std::reverse( bytes, bytes + sizeof(T) );
+	    T value;
+	    std::memcpy( &value, bytes, sizeof(T) );
+	    out[i] = static_cast<float>( value );
+	}
+    }
+
+    // A raster of sand, clay or OM, read a strip of rows at a time.
+    class Input
+    {
+      public:
+
+	Input ()
+	    : ascii ( false ),
+	      rows ( 0 ),
+	      cols ( 0 ),
+	      hasNodata ( false ),
+	      nodata ( 0.0f ),
+	      begin ( 0 ),
+	      end ( 0 ),
+	      eof ( false ),
+	      offset ( 0 ),
+	      bands ( 1 ),
+	      band ( 0 ),
+	      dataType ( 0 ),
+	      itemSize ( 0 ),
+	      swap ( false ),
+	      interleave ( BSQ )
+	  {
+	  }
+
+	// Reads the header; returns false, with a message, if failed.
+	bool Open (
+	    std::string const & name,
+	    int const bandIndex,		// from 0; ENVI only
+	    std::string & message );
+
+	// Reads rows firstRow to firstRow + numRows - 1, which must
+	// follow the rows of the last Read of an ASCII grid;
+	// nodata cells are NaN.
+	bool Read (
+	    std::size_t const firstRow,
+	    std::size_t const numRows,
+	    float * const values,
+	    std::string & message );
+
+	bool ascii;			// ESRI ASCII grid, else ENVI
+	std::size_t rows, cols;
+	bool hasNodata;
+	float nodata;
+	Keys mapKeys;			// map coordinates
+
+      private:
+
+	std::string fileName;
+
+	// ASCII grid
+	std::ifstream is;
+	std::vector<char> buffer;
+	std::size_t begin, end;		// unread text in buffer
+	bool eof;
+
+	// ENVI
+	std::unique_ptr<MappedFile> file;
+	std::size_t offset, bands, band, dataType, itemSize;
+	bool swap;
+	Interleave interleave;
+
+	bool OpenAscii ( std::string & message );
+	bool OpenEnvi ( std::string & message );
+	bool NextToken ( char const * & b, char const * & e );
+    };
+
+    bool Input::Open (
+	std::string const & name,
+	int const bandIndex,
+	std::string & message )
+    {
+	fileName = name;
+	band = static_cast<std::size_t>( bandIndex );
+	ascii = ( Extension( fileName ) == ".asc" );
+	if ( !( ascii ? OpenAscii( message ) : OpenEnvi( message ) ) )
+	    return false;
+	if ( rows == 0 || cols == 0 )
+	{
+	    message = fileName + ": the header has no number of rows or columns";
+	    return false;
+	}
+	return true;
+    }
+
+    // Finds the next token of an ASCII grid; returns false at the end.
+    bool Input::NextToken (
+	char const * & b,
+	char const * & e )
+    {
+	for ( ;; )
+	{
+	    while ( begin < end && IsSpace( buffer[begin] ) )
+		++begin;
+	    std::size_t t = begin;
+	    while ( t < end && !IsSpace( buffer[t] ) )
+		++t;
+	    if ( begin < end && ( t < end || eof ) )
+	    {
+		b = &buffer[begin];
+		e = &buffer[0] + t;
+		begin = t;
+		return true;
+	    }
+	    if ( eof )
+		return false;
+
+	    // keep the partial token, and read more
+	    std::copy( buffer.begin() + begin, buffer.begin() + end, buffer.begin() );
+	    end -= begin;
+	    begin = 0;
+	    if ( end == buffer.size() )
+		buffer.resize( 2 * buffer.size() );
+	    is.read( &buffer[end], buffer.size() - end );
+	    end += static_cast<std::size_t>( is.gcount() );
+	    eof = !is;
+	}
+    }
+
+    bool Input::OpenAscii (
+	std::string & message )
+    {
+	is.open( fileName.c_str(), std::ios::binary );
+	if ( !is.is_open() )
+	{
+	    message = "cannot open " + fileName;
+	    return false;
+	}
+	buffer.resize( readSize );
+
+	// keywords and values, until the first number
+	char const * b;
+	char const * e;
+	while ( NextToken( b, e ) )
+	{
+	    float number;
+	    if ( !std::isalpha( static_cast<unsigned char>( *b ) ) ||
+		 SWCharEstText::ParseFloat( b, e, number ) )	// nan, inf
+	    {
+		begin = b - &buffer[0];
+		break;
+	    }
+	    std::string const key ( b, e );
+	    if ( !NextToken( b, e ) )
+		break;
+	    std::string const value ( b, e );
+	    std::string const lowerKey = Lower( key );
+	    bool ok = true;
+	    if ( lowerKey == "ncols" )
+		ok = ReadCount( value, cols );
+	    else if ( lowerKey == "nrows" )
+		ok = ReadCount( value, rows );
+	    else if ( lowerKey == "nodata_value" )
+		ok = hasNodata = SWCharEstText::ParseFloat( value.data(), value.data() + value.size(), nodata );
+	    else
+		mapKeys.push_back( std::make_pair( key, value ) );
+	    if ( !ok )
+	    {
+		message = fileName + ": the value of " + key + " is not read: " + value;
+		return false;
+	    }
+	}
+	return true;
+    }
+
+    bool Input::OpenEnvi (
+	std::string & message )
+    {
+	// header file: the extension replaced by .hdr, or .hdr appended
+	std::string const extension = Extension( fileName );
+	std::string headerName = fileName.substr( 0, fileName.size() - extension.size() ) + ".hdr";
+	std::ifstream header ( headerName.c_str(), std::ios::binary );
+	if ( !header.is_open() && !extension.empty() )
+	{
+	    headerName = fileName + ".hdr";
+	    header.open( headerName.c_str(), std::ios::binary );
+	}
+	if ( !header.is_open() )
+	{
+	    message = "cannot open the ENVI header of " + fileName;
+	    return false;
+	}
+	std::string const text ( ( std::istreambuf_iterator<char>( header ) ),
+				 std::istreambuf_iterator<char>() );
+	if ( Trim( text ).compare( 0, 4, "ENVI" ) != 0 )
+	{
+	    message = headerName + ": not an ENVI header";
+	    return false;
+	}
+
+	// key = value, or key = { value }, which may span lines
+	Keys keys;
+	for ( std::size_t at = 0; at < text.size(); )
+	{
+	    std::size_t lineEnd = std::min( text.find( '\n', at ), text.size() );
+	    std::size_t const equals = text.find( '=', at );
+	    if ( equals < lineEnd )
+	    {
+		std::size_t const brace = text.find_first_not_of( " \t", equals + 1 );
+		if ( brace < lineEnd && text[brace] == '{' )
+		    lineEnd = std::min( std::min( text.find( '}', brace ), text.size() - 1 ) + 1,
+					text.size() );
+		keys.push_back( std::make_pair( Lower( Trim( text.substr( at, equals - at ) ) ),
+						Trim( text.substr( equals + 1, lineEnd - equals - 1 ) ) ) );
+	    }
+	    at = lineEnd + 1;
+	}
+
+	std::size_t byteOrder = 0;
+	std::string interleaveName = "bsq";
+	bool ok = true;
+	for ( Keys::const_iterator k = keys.begin(); k != keys.end() && ok; ++k )
+	{
+	    std::string const & key = k->first;
+	    std::string const & value = k->second;
+	    if ( key == "samples" )
+		ok = ReadCount( value, cols );
+	    else if ( key == "lines" )
+		ok = ReadCount( value, rows );
+	    else if ( key == "bands" )
+		ok = ReadCount( value, bands );
+	    else if ( key == "header offset" )
+		ok = ReadCount( value, offset );
+	    else if ( key == "data type" )
+		ok = ReadCount( value, dataType );
+	    else if ( key == "byte order" )
+		ok = ReadCount( value, byteOrder ) && byteOrder <= 1;
+	    else if ( key == "interleave" )
+		interleaveName = Lower( value );
+	    else if ( key == "data ignore value" )
+		ok = hasNodata = SWCharEstText::ParseFloat( value.data(), value.data() + value.size(), nodata );
+	    else
+	    {
+		for ( char const * const mapKey : enviMapKeys )
+		    if ( key == mapKey )
+			mapKeys.push_back( *k );
+	    }
+	    if ( !ok )
+	    {
+		message = headerName + ": the value of " + key + " is not read: " + value;
+		return false;
+	    }
+	}
+
+	switch ( dataType )
+	{
+	    case 1:			itemSize = 1; break;
+	    case 2: case 12:		itemSize = 2; break;
+	    case 3: case 4: case 13:	itemSize = 4; break;
+	    case 5:			itemSize = 8; break;
+	    default:
+		message = headerName + ": data type " + std::to_string( dataType ) + " is not read";
+		return false;
+	}
+	if ( interleaveName == "bsq" )
+	    interleave = BSQ;
+	else if ( interleaveName == "bil" )
+	    interleave = BIL;
+	else if ( interleaveName == "bip" )
+	    interleave = BIP;
+	else
+	{
+	    message = headerName + ": interleave " + interleaveName + " is not read";
+	    return false;
+	}
+	if ( band >= bands )
+	{
+	    message = fileName + ": has " + std::to_string( bands ) + " bands";
+	    return false;
+	}
+	swap = ( itemSize > 1 && ( byteOrder == 0 ) != LittleEndian() );
+
+	file.reset( new MappedFile( fileName ) );
+	if ( !file->IsOpen() )
+	{
+	    message = file->ErrorMessage();
+	    return false;
+	}
+	std::size_t const maxCells = std::numeric_limits<std::size_t>::max() / itemSize / bands;
+	if ( rows > 0 && cols > 0 &&
+	     ( cols > maxCells / rows ||
+	       file->Size() < offset || ( file->Size() - offset ) / itemSize / bands / cols < rows ) )
+	{
+	    message = fileName + ": the file is smaller than its header describes";
+	    return false;
+	}
+	return true;
+    }
+
+    bool Input::Read (
+	std::size_t const firstRow,
+	std::size_t const numRows,
+	float * const values,
+	std::string & message )
+    {
+	float const nan = std::numeric_limits<float>::quiet_NaN();
+	if ( ascii )
+	{
+	    char const * b;
+	    char const * e;
+	    for ( std::size_t i = 0; i < numRows * cols; ++i )
+	    {
+		if ( !NextToken( b, e ) )
+		{
+		    message = fileName + ": has fewer values than its header describes";
+		    return false;
+		}
+		if ( !SWCharEstText::ParseFloat( b, e, values[i] ) )
+		{
+		    message = fileName + ": not a number: " + std::string( b, e );
+		    return false;
+		}
+		if ( hasNodata && values[i] == nodata )
+		    values[i] = nan;
+	    }
+	    if ( is.bad() )
+	    {
+		message = fileName + ": reading failed";
+		return false;
+	    }
+	    return true;
+	}
+
+	for ( std::size_t r = 0; r < numRows; ++r )
+	{
+	    std::size_t const row = firstRow + r;
+	    std::size_t const first = ( interleave == BSQ ? ( band * rows + row ) * cols :
+					interleave == BIL ? ( row * bands + band ) * cols :
+							    row * cols * bands + band );
+	    std::size_t const stride = ( interleave == BIP ? bands : 1 );
+	    char const * const p = file->Data() + offset + first * itemSize;
+	    float * const out = values + r * cols;
+	    switch ( dataType )
+	    {
+		case 1:  ConvertRow<uint8_t>( p, cols, stride, swap, out ); break;
+		case 2:  ConvertRow<int16_t>( p, cols, stride, swap, out ); break;
+		case 3:  ConvertRow<int32_t>( p, cols, stride, swap, out ); break;
+		case 4:  ConvertRow<float>( p, cols, stride, swap, out ); break;
+		case 5:  ConvertRow<double>( p, cols, stride, swap, out ); break;
+		case 12: ConvertRow<uint16_t>( p, cols, stride, swap, out ); break;
+		case 13: ConvertRow<uint32_t>( p, cols, stride, swap, out ); break;
+	    }
+	    if ( hasNodata )
+		std::replace( out, out + cols, nodata, nan );
+	}
+	return true;
+    }
+
+    // A raster of results, written a strip of rows at a time.
+    class Output
+    {
+      public:
+
+	// Creates the file, and writes the header.
+	bool Open (
+	    std::string const & prefix,
+	    char const * const name,
+	    Input const & like,			// format, size, map keys
+	    float const nodata,
+	    std::string & message );
+
+	bool Write (
+	    float const * const values,
+	    std::size_t const numRows );
+
+	bool Close ();
+
+	std::string fileName;
+
+      private:
+
+	std::ofstream os;
+	bool ascii;
+	std::size_t cols;
+	std::vector<char> text;
+    };
+
+    bool Output::Open (
+	std::string const & prefix,
+	char const * const name,
+	Input const & like,
+	float const nodata,
+	std::string & message )
+    {
+	ascii = like.ascii;
+	cols = like.cols;
+	char number[SWCharEstText::maxFormatted];
+	std::string const nodataText ( number, SWCharEstText::FormatFloat( nodata, number ) );
+	fileName = prefix + name + ( ascii ? ".asc" : ".bsq" );
+	if ( !ascii )
+	{
+	    std::string const headerName = prefix + name + ".hdr";
+	    std::ofstream header ( headerName.c_str(), std::ios::binary | std::ios::trunc );
+	    header << "ENVI\n"
+		   << "description = {SWCharEst " << name << "}\n"
+		   << "samples = " << like.cols << "\n"
+		   << "lines = " << like.rows << "\n"
+		   << "bands = 1\n"
+		   << "header offset = 0\n"
+		   << "file type = ENVI Standard\n"
+		   << "data type = 4\n"
+		   << "interleave = bsq\n"
+		   << "byte order = " << ( LittleEndian() ? 0 : 1 ) << "\n"
+		   << "data ignore value = " << nodataText << "\n"
+		   << "band names = {" << name << "}\n";
+	    for ( Keys::const_iterator k = like.mapKeys.begin(); k != like.mapKeys.end(); ++k )
+		header << k->first << " = " << k->second << "\n";
+	    header.close();
+	    if ( header.fail() )
+	    {
+		message = "cannot write " + headerName;
+		return false;
+	    }
+	}
+	os.open( fileName.c_str(), std::ios::binary | std::ios::trunc );
+	if ( !os.is_open() )
+	{
+	    message = "cannot create " + fileName;
+	    return false;
+	}
+	if ( ascii )
+	{
+	    os << "ncols " << like.cols << "\n"
+	       << "nrows " << like.rows << "\n";
+	    for ( Keys::const_iterator k = like.mapKeys.begin(); k != like.mapKeys.end(); ++k )
+		os << k->first << " " << k->second << "\n";
+	    os << "NODATA_value " << nodataText << "\n";
+	}
+	return os.good();
+    }
+
+    bool Output::Write (
+	float const * const values,
+	std::size_t const numRows )
+    {
+	std::size_t const n = numRows * cols;
+	if ( !ascii )
+	    return os.write( reinterpret_cast<char const *>( values ), n * sizeof(float) ).good();
+	text.resize( n * ( SWCharEstText::maxFormatted + 1 ) );
+	char * p = &text[0];
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    p = SWCharEstText::FormatFloat( values[i], p );
+	    *p++ = ( ( i + 1 ) % cols == 0 ? '\n' : ' ' );
+	}
+	return os.write( &text[0], p - &text[0] ).good();
+    }
+
+    bool Output::Close ()
+    {
+	os.close();
+	return !os.fail();
+    }
+
+} // namespace
+
+
+SWCharEstRasterFile::SWCharEstRasterFile (
+    ThreadPool & threadPool,		// threads which evaluate the strips
+    int const numStripRows )		// rows read at a time
+    : raster ( threadPool ),
+      stripRows ( std::max( 1, numStripRows ) ),
+      rows ( 0 ),
+      cols ( 0 ),
+      numValid ( 0 )
+{
+}
+
+bool SWCharEstRasterFile::Run (
+    std::string const & sandFile,	// sand fractions (0-1)
+    std::string const & clayFile,	// clay fractions (0-1)
+    std::string const & omFile,		// organic matter wt %
+    std::string const & outputPrefix )	// start of the output file names
+{
+    std::string const fileNames[3] = { sandFile, clayFile, omFile };
+    int const bands[3] = { 0, 0, 0 };
+    return Evaluate( fileNames, bands, outputPrefix );
+}
+
+bool SWCharEstRasterFile::RunBands (
+    std::string const & enviFile,	// bands of sand, clay, OM
+    std::string const & outputPrefix )	// start of the output file names
+{
+    std::string const fileNames[3] = { enviFile, enviFile, enviFile };
+    int const bands[3] = { 0, 1, 2 };
+    if ( Extension( enviFile ) == ".asc" )
+    {
+	rows = cols = numValid = 0;
+	errorMessage = "SWCharEstRasterFile: an ASCII grid has one band: " + enviFile;
+	return false;
+    }
+    return Evaluate( fileNames, bands, outputPrefix );
+}
+
+// Reads, evaluates and writes the rasters, a strip at a time.
+bool SWCharEstRasterFile::Evaluate (
+    std::string const (&fileNames)[3],
+    int const (&bands)[3],
+    std::string const & outputPrefix )
+{
+    rows = cols = numValid = 0;
+    errorMessage.clear();
+    std::string message;
+    Input inputs[3];
+    for ( int k = 0; k < 3; ++k )
+    {
+	if ( !inputs[k].Open( fileNames[k], bands[k], message ) )
+	{
+	    errorMessage = "SWCharEstRasterFile: " + message;
+	    return false;
+	}
+	if ( inputs[k].rows != inputs[0].rows || inputs[k].cols != inputs[0].cols )
+	{
+	    errorMessage = "SWCharEstRasterFile: the rasters differ in size";
+	    return false;
+	}
+    }
+
+    float const nodata = ( inputs[0].hasNodata ? inputs[0].nodata : defaultNodata );
+    Output outputs[4];
+    for ( int k = 0; k < 4; ++k )
+    {
+	if ( !outputs[k].Open( outputPrefix, outputNames[k], inputs[0], nodata, message ) )
+	{
+	    errorMessage = "SWCharEstRasterFile: " + message;
+	    return false;
+	}
+    }
+
+    // strips of rows: 3 inputs and 4 outputs
+    std::size_t const numRows = inputs[0].rows;
+    std::size_t const numCols = inputs[0].cols;
+    std::size_t const stripSize = std::min<std::size_t>( stripRows, numRows ) * numCols;
+    std::vector<float> strips ( 7 * stripSize );
+    float * const in = &strips[0];
+    float * const out = in + 3 * stripSize;
+    for ( std::size_t firstRow = 0; firstRow < numRows; firstRow += stripRows )
+    {
+	std::size_t const n = std::min<std::size_t>( stripRows, numRows - firstRow );
+	for ( int k = 0; k < 3; ++k )
+	{
+	    if ( !inputs[k].Read( firstRow, n, in + k * stripSize, message ) )
+	    {
+		errorMessage = "SWCharEstRasterFile: " + message;
+		return false;
+	    }
+	}
+	// Read has made the nodata cells of each input NaN, so only
+	// NaN is matched; nodata only fills the outputs
+	raster.Evaluate( n, numCols, in, in + stripSize, in + 2 * stripSize,
+			 std::numeric_limits<float>::quiet_NaN(), nodata,
+			 out, out + stripSize, out + 2 * stripSize, out + 3 * stripSize );
+	numValid += raster.LastReport().validCells;
+	for ( int k = 0; k < 4; ++k )
+	{
+	    if ( !outputs[k].Write( out + k * stripSize, n ) )
+	    {
+		errorMessage = "SWCharEstRasterFile: cannot write " + outputs[k].fileName;
+		return false;
+	    }
+	}
+    }
+    for ( int k = 0; k < 4; ++k )
+    {
+	if ( !outputs[k].Close() )
+	{
+	    errorMessage = "SWCharEstRasterFile: cannot write " + outputs[k].fileName;
+	    return false;
+	}
+    }
+    rows = numRows;
+    cols = numCols;
+    return true;
+}
+
+} // namespace teh
@@ -0,0 +1,115 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstRasterFile.h
+@class		teh::SWCharEstRasterFile
+@brief 		Streams rasters of sand, clay and OM in ESRI ASCII grid or ENVI files to result rasters.
+@details {
+		Run reads three rasters, of sand fractions (0-1), clay
+		fractions (0-1) and organic matter wt %, and RunBands
+		reads the first three bands of one ENVI raster, and writes
+		rasters of wp, fc, thetaS and ks, in one pass over the
+		inputs: strips of rows are read, evaluated with
+		SWCharEstRaster on the threads of a ThreadPool, and
+		written, so the memory used is a few strips, whatever
+		the size of the rasters.
+		A file with the extension ".asc" is an ESRI ASCII grid;
+		its header of keywords and values (ncols, nrows,
+		xllcorner or xllcenter, yllcorner or yllcenter, cellsize,
+		NODATA_value) is followed by the values by rows, from
+		the top, separated by spaces or newlines.
+		Other files are ENVI rasters, with a header file of the
+		same name with the extension ".hdr", or with ".hdr"
+		appended. Band-sequential (bsq), band-interleaved-by-line
+		(bil) and band-interleaved-by-pixel (bip) layouts, either
+		byte order, a header offset, and data types 1 (byte),
+		2 (int16), 3 (int32), 4 (float32), 5 (float64),
+		12 (uint16) and 13 (uint32) are read; ENVI files are
+		mapped into memory with MappedFile.
+		A cell is nodata if any input equals the NODATA_value,
+		or the ENVI "data ignore value", of its raster, or is NaN.
+		The outputs have the format of the sand raster, and are
+		named by the output prefix and the result: for example
+		"out_wp.asc", or "out_wp.bsq" with "out_wp.hdr", an ENVI
+		float32 raster. They have the size and the map
+		coordinates of the sand raster, and its nodata value,
+		or -9999 if it has none, in nodata cells.
+		ASCII values are written with SWCharEstText::FormatFloat.
+		Run and RunBands return false, with a message from
+		ErrorMessage, if a file cannot be read or written, or the
+		rasters differ in size.
+}
+@example {
+	Example:
+	    teh::ThreadPool pool;
+	    teh::SWCharEstRasterFile rasters ( pool );
+	    if ( !rasters.Run( "sand.asc", "clay.asc", "om.asc", "out_" ) )
+		std::cerr << rasters.ErrorMessage() << std::endl;
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstRasterFile_h
+#define INC_teh_SWCharEstRasterFile_h
+
+#include "SWCharEstRaster.h"
+#include <cstddef>
+#include <string>
+
+namespace teh {
+
+
+    class SWCharEstRasterFile
+    {
+      public:
+
+	/// Uses the threads of the pool.
+	SWCharEstRasterFile (
+	    ThreadPool & threadPool,		///< threads which evaluate the strips
+	    int const stripRows = 64 );		///< rows read at a time
+
+	/// Evaluates three rasters; returns false if failed.
+	bool Run (
+	    std::string const & sandFile,	///< sand fractions (0-1)
+	    std::string const & clayFile,	///< clay fractions (0-1)
+	    std::string const & omFile,		///< organic matter wt %
+	    std::string const & outputPrefix );	///< start of the output file names
+
+	/// Evaluates bands 1, 2 and 3 of an ENVI raster,
+	/// of sand, clay and OM; returns false if failed.
+	bool RunBands (
+	    std::string const & enviFile,	///< bands of sand, clay, OM
+	    std::string const & outputPrefix );	///< start of the output file names
+
+	/// Message of the failure of the last Run or RunBands.
+	std::string const & ErrorMessage () const { return errorMessage; }
+
+	/// Size of the rasters of the last Run or RunBands.
+	std::size_t Rows () const { return rows; }
+	std::size_t Cols () const { return cols; }
+
+	/// Number of cells which are not nodata.
+	std::size_t NumValid () const { return numValid; }
+
+	int StripRows () const { return stripRows; }
+
+      private:
+
+	SWCharEstRaster raster;
+	int const stripRows;
+	std::size_t rows;
+	std::size_t cols;
+	std::size_t numValid;
+	std::string errorMessage;
+
+	bool Evaluate (
+	    std::string const (&fileNames)[3],
+	    int const (&bands)[3],
+	    std::string const & outputPrefix );
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstRasterFile_h
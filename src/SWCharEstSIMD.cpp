@@ -0,0 +1,687 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstSIMD.cpp
+// class	teh::SWCharEstSIMD
+// brief 	x86 SIMD kernels for teh::SWCharEst::GetBatch.
+//		The log and exp functions are vector versions of the
+//		single precision Cephes library functions (S. L. Moshier),
+//		with relative error of a few parts in 1e7.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstSIMD.h"
+#include "SWCharEst.h"
+#include "SWCharEstMatrix.h"
+#include <cstring>
+
+#ifdef TEH_SWCHAREST_X86_KERNELS
+
+#include <immintrin.h>
+
+#define TEH_TARGET_AVX2		__attribute__((target("avx2,fma")))
+#define TEH_TARGET_AVX512	__attribute__((target("avx512f,avx2,fma")))
+
+
+namespace teh {
+
+
+namespace {
+
+    // Cephes logf and expf constants
+    float const sqrtHalf = 0.707106781186547524f;
+    float const ln2Hi = 0.693359375f;
+    float const ln2Lo = -2.12194440e-4f;
+    float const log2e = 1.44269504088896341f;
+    float const expMax = 88.0f;
+    float const expMin = -87.3365448f;
+    float const logP[9] = {
+	7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+	-1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+	2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f };
+    float const expP[6] = {
+	1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+	4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f };
+
+    // Saxton & Rawls equation constants
+    float const ksFactor = 1930.0f / 36000.0f;	// and mm/hour to cm/sec
+    float const invB = 1.0f / 3.816713f;
+
+
+    //----------------------------------------------------------- AVX2 -----
+
+    // natural log; NaN if x < 0, -inf if x = 0; x must not be subnormal
+    TEH_TARGET_AVX2
+    inline __m256 Log8 ( __m256 const x )
+    {
+	__m256 const zero = _mm256_setzero_ps();
+	__m256 const one = _mm256_set1_ps( 1.0f );
+	__m256 const isNeg = _mm256_cmp_ps( x, zero, _CMP_LT_OQ );
+	__m256 const isZero = _mm256_cmp_ps( x, zero, _CMP_EQ_OQ );
+
+	// x = m * 2^e, 0.5 <= m < 1
+	__m256i const xi = _mm256_castps_si256( x );
+	__m256 e = _mm256_cvtepi32_ps( _mm256_sub_epi32(
+			_mm256_srli_epi32( xi, 23 ), _mm256_set1_epi32( 126 ) ) );
+	__m256 m = _mm256_castsi256_ps( _mm256_or_si256(
+			_mm256_and_si256( xi, _mm256_set1_epi32( 0x007fffff ) ),
+			_mm256_set1_epi32( 0x3f000000 ) ) );
+
+	// m < sqrt(0.5): m = 2m - 1, e = e - 1; else m = m - 1
+	__m256 const small = _mm256_cmp_ps( m, _mm256_set1_ps( sqrtHalf ), _CMP_LT_OQ );
+	e = _mm256_sub_ps( e, _mm256_and_ps( one, small ) );
+	m = _mm256_add_ps( _mm256_sub_ps( m, one ), _mm256_and_ps( m, small ) );
+
+	__m256 const z = _mm256_mul_ps( m, m );
+	__m256 y = _mm256_set1_ps( logP[0] );
+	for ( int i = 1; i < 9; ++i )
+	    y = _mm256_fmadd_ps( y, m, _mm256_set1_ps( logP[i] ) );
+	y = _mm256_mul_ps( y, _mm256_mul_ps( m, z ) );
+	y = _mm256_fmadd_ps( e, _mm256_set1_ps( ln2Lo ), y );
+	y = _mm256_fnmadd_ps( _mm256_set1_ps( 0.5f ), z, y );
+	__m256 r = _mm256_add_ps( m, y );
+	r = _mm256_fmadd_ps( e, _mm256_set1_ps( ln2Hi ), r );
+
+	r = _mm256_blendv_ps( r, _mm256_set1_ps( -__builtin_inff() ), isZero );
+	return _mm256_or_ps( r, isNeg );	// all bits set is NaN
+    }
+
+    // exp; zero if x underflows, NaN if x is NaN
+    TEH_TARGET_AVX2
+    inline __m256 Exp8 ( __m256 x )
+    {
+	__m256 const underflow = _mm256_cmp_ps( x, _mm256_set1_ps( expMin ), _CMP_LT_OQ );
+	__m256 const isNaN = _mm256_cmp_ps( x, x, _CMP_UNORD_Q );
+	x = _mm256_min_ps( x, _mm256_set1_ps( expMax ) );
+	x = _mm256_max_ps( x, _mm256_set1_ps( expMin ) );
+
+	// exp(x) = 2^n * exp(r), n = round(x / ln2)
+	__m256 const n = _mm256_round_ps( _mm256_mul_ps( x, _mm256_set1_ps( log2e ) ),
+					  _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+	x = _mm256_fnmadd_ps( n, _mm256_set1_ps( ln2Hi ), x );
+	x = _mm256_fnmadd_ps( n, _mm256_set1_ps( ln2Lo ), x );
+
+	__m256 y = _mm256_set1_ps( expP[0] );
+	for ( int i = 1; i < 6; ++i )
+	    y = _mm256_fmadd_ps( y, x, _mm256_set1_ps( expP[i] ) );
+	y = _mm256_fmadd_ps( y, _mm256_mul_ps( x, x ),
+			     _mm256_add_ps( x, _mm256_set1_ps( 1.0f ) ) );
+
+	__m256i const pow2n = _mm256_slli_epi32( _mm256_add_epi32(
+			_mm256_cvtps_epi32( n ), _mm256_set1_epi32( 127 ) ), 23 );
+	y = _mm256_mul_ps( y, _mm256_castsi256_ps( pow2n ) );
+	return _mm256_or_ps( _mm256_andnot_ps( underflow, y ), isNaN );
+    }
+
+    // One row of SWCharEstMatrix::coefficients times the basis terms
+    TEH_TARGET_AVX2
+    inline __m256 Regression8 (
+	__m256 const s, __m256 const c, __m256 const om,
+	__m256 const som, __m256 const com, __m256 const sc,
+	double const * const a )
+    {
+	typedef SWCharEstMatrix M;
+	__m256 r = _mm256_fmadd_ps( _mm256_set1_ps( static_cast<float>( a[M::BasisSand] ) ), s, _mm256_set1_ps( static_cast<float>( a[M::BasisOne] ) ) );
+	r = _mm256_fmadd_ps( _mm256_set1_ps( static_cast<float>( a[M::BasisClay] ) ), c, r );
+	r = _mm256_fmadd_ps( _mm256_set1_ps( static_cast<float>( a[M::BasisOM] ) ), om, r );
+	r = _mm256_fmadd_ps( _mm256_set1_ps( static_cast<float>( a[M::BasisSandOM] ) ), som, r );
+	r = _mm256_fmadd_ps( _mm256_set1_ps( static_cast<float>( a[M::BasisClayOM] ) ), com, r );
+	return _mm256_fmadd_ps( _mm256_set1_ps( static_cast<float>( a[M::BasisSandClay] ) ), sc, r );
+    }
+
+    // Stores the low bytes of m <= 8 lanes of status.
+    TEH_TARGET_AVX2
+    inline void StoreStatus8 (
+	unsigned char * const p,
+	__m256i const status,
+	std::size_t const m )
+    {
+	__m128i const words = _mm_packus_epi32( _mm256_castsi256_si128( status ),
+						_mm256_extracti128_si256( status, 1 ) );
+	__m128i const bytes = _mm_packus_epi16( words, words );
+	if ( m == 8 )
+	{
+	    _mm_storel_epi64( reinterpret_cast<__m128i *>( p ), bytes );
+	}
+	else
+	{
+	    unsigned char b[16];
+	    _mm_storeu_si128( reinterpret_cast<__m128i *>( b ), bytes );
+	    std::memcpy( p, b, m );
+	}
+    }
+
+    // Bits of the lanes of status which are zero.
+    TEH_TARGET_AVX2
+    inline unsigned ValidLanes8 ( __m256i const status )
+    {
+	__m256i const ok = _mm256_cmpeq_epi32( status, _mm256_setzero_si256() );
+	return _mm256_movemask_ps( _mm256_castsi256_ps( ok ) );
+    }
+
+    // Number of lanes of status which are not zero.
+    TEH_TARGET_AVX2
+    inline unsigned NumRejected8 ( __m256i const status )
+    {
+	return 8 - __builtin_popcount( ValidLanes8( status ) );
+    }
+
+    // Permutations for each 8-bit mask of valid lanes:
+    // pack moves the valid lanes to the front, in order;
+    // expand moves them back from the front to their lanes.
+    struct PackTable
+    {
+	unsigned char pack[256][8];
+	unsigned char expand[256][8];
+
+	PackTable ()
+	{
+	    for ( int mask = 0; mask < 256; ++mask )
+	    {
+		int k = 0;
+		for ( int lane = 0; lane < 8; ++lane )
+		{
+		    expand[mask][lane] = static_cast<unsigned char>( k & 7 );
+		    if ( mask & ( 1 << lane ) )
+			pack[mask][k++] = static_cast<unsigned char>( lane );
+		}
+		while ( k < 8 )
+		    pack[mask][k++] = 0;
+	    }
+	}
+    };
+
+    // Permutation of a table row, as 8 lanes.
+    TEH_TARGET_AVX2
+    inline __m256i Permutation8 ( unsigned char const * const row )
+    {
+	return _mm256_cvtepu8_epi32(
+		_mm_loadl_epi64( reinterpret_cast<__m128i const *>( row ) ) );
+    }
+
+    // Input status of 8 soils;
+    // same tests as SWCharEst::CheckArgs; NaN fails
+    TEH_TARGET_AVX2
+    inline __m256i Status8 (
+	__m256 const s, __m256 const c, __m256 const om )
+    {
+	__m256 const zero = _mm256_setzero_ps();
+	__m256 const one = _mm256_set1_ps( 1.0f );
+	__m256 const badSand = _mm256_or_ps( _mm256_cmp_ps( s, zero, _CMP_NGE_UQ ),
+					     _mm256_cmp_ps( s, one, _CMP_NLE_UQ ) );
+	__m256 const badClay = _mm256_or_ps( _mm256_cmp_ps( c, zero, _CMP_NGE_UQ ),
+					     _mm256_cmp_ps( c, one, _CMP_NLE_UQ ) );
+	__m256 const badOM = _mm256_cmp_ps( om, zero, _CMP_NGE_UQ );
+	__m256 const badSum = _mm256_cmp_ps( _mm256_add_ps( s, c ), one, _CMP_NLE_UQ );
+	return _mm256_or_si256(
+		_mm256_or_si256(
+		    _mm256_and_si256( _mm256_castps_si256( badSand ),
+				      _mm256_set1_epi32( SWCharEst::StatusSand ) ),
+		    _mm256_and_si256( _mm256_castps_si256( badClay ),
+				      _mm256_set1_epi32( SWCharEst::StatusClay ) ) ),
+		_mm256_or_si256(
+		    _mm256_and_si256( _mm256_castps_si256( badOM ),
+				      _mm256_set1_epi32( SWCharEst::StatusOM ) ),
+		    _mm256_and_si256( _mm256_castps_si256( badSum ),
+				      _mm256_set1_epi32( SWCharEst::StatusSandClay ) ) ) );
+    }
+
+    // Saxton & Rawls equations for 8 soils
+    TEH_TARGET_AVX2
+    inline void Kernel8 (
+	__m256 const s, __m256 const c, __m256 const ompc,
+	__m256 & wp, __m256 & fc, __m256 & thetaS, __m256 & ks,
+	__m256i & status )
+    {
+	__m256 const om = _mm256_min_ps( ompc, _mm256_set1_ps( 70.0f ) );
+	status = Status8( s, c, om );
+	__m256 const ok = _mm256_castsi256_ps(
+		_mm256_cmpeq_epi32( status, _mm256_setzero_si256() ) );
+
+	__m256 const som = _mm256_mul_ps( s, om );
+	__m256 const com = _mm256_mul_ps( c, om );
+	__m256 const sc = _mm256_mul_ps( s, c );
+
+	__m256 const t1500t = Regression8( s, c, om, som, com, sc,
+			SWCharEstMatrix::coefficients[SWCharEstMatrix::Theta1500t] );
+	__m256 const t33t = Regression8( s, c, om, som, com, sc,
+			SWCharEstMatrix::coefficients[SWCharEstMatrix::Theta33t] );
+	__m256 const tS33t = Regression8( s, c, om, som, com, sc,
+			SWCharEstMatrix::coefficients[SWCharEstMatrix::ThetaS33t] );
+
+	__m256 const t33 = _mm256_min_ps(
+		_mm256_fmadd_ps( _mm256_fmadd_ps( _mm256_set1_ps( 1.283f ), t33t,
+						  _mm256_set1_ps( 1.0f - 0.374f ) ),
+				 t33t, _mm256_set1_ps( -0.015f ) ),
+		_mm256_set1_ps( 0.80f ) );
+	__m256 t1500 = _mm256_max_ps(
+		_mm256_fmadd_ps( _mm256_set1_ps( 1.14f ), t1500t, _mm256_set1_ps( -0.02f ) ),
+		_mm256_set1_ps( 0.01f ) );
+	t1500 = _mm256_min_ps( t1500, _mm256_mul_ps( _mm256_set1_ps( 0.80f ), t33 ) );
+	__m256 const tS33 = _mm256_fmadd_ps( _mm256_set1_ps( 1.636f ), tS33t,
+					     _mm256_set1_ps( -0.107f ) );
+	__m256 const tS = _mm256_fmadd_ps( _mm256_set1_ps( -0.097f ), s,
+			_mm256_add_ps( _mm256_add_ps( t33, tS33 ), _mm256_set1_ps( 0.043f ) ) );
+
+	// invalid soils get placeholder values for the Ks calculation
+	__m256 const k1500 = _mm256_blendv_ps( _mm256_set1_ps( 0.1f ), t1500, ok );
+	__m256 const k33 = _mm256_blendv_ps( _mm256_set1_ps( 0.2f ), t33, ok );
+	__m256 const kS = _mm256_blendv_ps( _mm256_set1_ps( 0.3f ), tS, ok );
+
+	// Ks = 1930 * (thetaS - theta33)^(3 - lamda) / 36000
+	__m256 const lamda = _mm256_mul_ps( _mm256_sub_ps( Log8( k33 ), Log8( k1500 ) ),
+					    _mm256_set1_ps( invB ) );
+	__m256 const power = _mm256_mul_ps( _mm256_sub_ps( _mm256_set1_ps( 3.0f ), lamda ),
+					    Log8( _mm256_sub_ps( kS, k33 ) ) );
+	__m256 const Ks = _mm256_mul_ps( _mm256_set1_ps( ksFactor ), Exp8( power ) );
+
+	wp = _mm256_and_ps( ok, t1500 );
+	fc = _mm256_and_ps( ok, t33 );
+	thetaS = _mm256_and_ps( ok, tS );
+	ks = _mm256_and_ps( ok, Ks );
+    }
+
+
+    //--------------------------------------------------------- AVX-512 -----
+
+// GCC's avx512fintrin.h fills the unused source of many intrinsics with
+// _mm512_undefined_ps, which -Wall reports as uninitialized when inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+    // natural log; NaN if x < 0, -inf if x = 0
+    TEH_TARGET_AVX512
+    inline __m512 Log16 ( __m512 const x )
+    {
+	__m512 const one = _mm512_set1_ps( 1.0f );
+	__mmask16 const isNeg = _mm512_cmp_ps_mask( x, _mm512_setzero_ps(), _CMP_LT_OQ );
+	__mmask16 const isZero = _mm512_cmp_ps_mask( x, _mm512_setzero_ps(), _CMP_EQ_OQ );
+
+	// x = m * 2^e, 0.5 <= m < 1
+	__m512 m = _mm512_getmant_ps( x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_zero );
+	__m512 e = _mm512_add_ps( _mm512_getexp_ps( x ), one );
+
+	// m < sqrt(0.5): m = 2m - 1, e = e - 1; else m = m - 1
+	__mmask16 const small = _mm512_cmp_ps_mask( m, _mm512_set1_ps( sqrtHalf ), _CMP_LT_OQ );
+	e = _mm512_mask_sub_ps( e, small, e, one );
+	m = _mm512_mask_add_ps( _mm512_sub_ps( m, one ), small, _mm512_sub_ps( m, one ), m );
+
+	__m512 const z = _mm512_mul_ps( m, m );
+	__m512 y = _mm512_set1_ps( logP[0] );
+	for ( int i = 1; i < 9; ++i )
+	    y = _mm512_fmadd_ps( y, m, _mm512_set1_ps( logP[i] ) );
+	y = _mm512_mul_ps( y, _mm512_mul_ps( m, z ) );
+	y = _mm512_fmadd_ps( e, _mm512_set1_ps( ln2Lo ), y );
+	y = _mm512_fnmadd_ps( _mm512_set1_ps( 0.5f ), z, y );
+	__m512 r = _mm512_add_ps( m, y );
+	r = _mm512_fmadd_ps( e, _mm512_set1_ps( ln2Hi ), r );
+
+	r = _mm512_mask_mov_ps( r, isZero, _mm512_set1_ps( -__builtin_inff() ) );
+	return _mm512_mask_mov_ps( r, isNeg, _mm512_set1_ps( __builtin_nanf("") ) );
+    }
+
+    // exp; zero if x underflows, NaN if x is NaN
+    TEH_TARGET_AVX512
+    inline __m512 Exp16 ( __m512 x )
+    {
+	__mmask16 const underflow = _mm512_cmp_ps_mask( x, _mm512_set1_ps( expMin ), _CMP_LT_OQ );
+	__mmask16 const isNaN = _mm512_cmp_ps_mask( x, x, _CMP_UNORD_Q );
+	x = _mm512_min_ps( x, _mm512_set1_ps( expMax ) );
+	x = _mm512_max_ps( x, _mm512_set1_ps( expMin ) );
+
+	// exp(x) = 2^n * exp(r), n = round(x / ln2)
+	__m512 const n = _mm512_roundscale_ps( _mm512_mul_ps( x, _mm512_set1_ps( log2e ) ),
+					       _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+	x = _mm512_fnmadd_ps( n, _mm512_set1_ps( ln2Hi ), x );
+	x = _mm512_fnmadd_ps( n, _mm512_set1_ps( ln2Lo ), x );
+
+	__m512 y = _mm512_set1_ps( expP[0] );
+	for ( int i = 1; i < 6; ++i )
+	    y = _mm512_fmadd_ps( y, x, _mm512_set1_ps( expP[i] ) );
+	y = _mm512_fmadd_ps( y, _mm512_mul_ps( x, x ),
+			     _mm512_add_ps( x, _mm512_set1_ps( 1.0f ) ) );
+
+	y = _mm512_scalef_ps( y, n );
+	y = _mm512_maskz_mov_ps( static_cast<__mmask16>( ~underflow ), y );
+	return _mm512_mask_mov_ps( y, isNaN, _mm512_set1_ps( __builtin_nanf("") ) );
+    }
+
+    // One row of SWCharEstMatrix::coefficients times the basis terms
+    TEH_TARGET_AVX512
+    inline __m512 Regression16 (
+	__m512 const s, __m512 const c, __m512 const om,
+	__m512 const som, __m512 const com, __m512 const sc,
+	double const * const a )
+    {
+	typedef SWCharEstMatrix M;
+	__m512 r = _mm512_fmadd_ps( _mm512_set1_ps( static_cast<float>( a[M::BasisSand] ) ), s, _mm512_set1_ps( static_cast<float>( a[M::BasisOne] ) ) );
+	r = _mm512_fmadd_ps( _mm512_set1_ps( static_cast<float>( a[M::BasisClay] ) ), c, r );
+	r = _mm512_fmadd_ps( _mm512_set1_ps( static_cast<float>( a[M::BasisOM] ) ), om, r );
+	r = _mm512_fmadd_ps( _mm512_set1_ps( static_cast<float>( a[M::BasisSandOM] ) ), som, r );
+	r = _mm512_fmadd_ps( _mm512_set1_ps( static_cast<float>( a[M::BasisClayOM] ) ), com, r );
+	return _mm512_fmadd_ps( _mm512_set1_ps( static_cast<float>( a[M::BasisSandClay] ) ), sc, r );
+    }
+
+    // Input status of 16 soils, and the mask of valid soils;
+    // same tests as SWCharEst::CheckArgs; NaN fails
+    TEH_TARGET_AVX512
+    inline __m512i Status16 (
+	__m512 const s, __m512 const c, __m512 const om,
+	__mmask16 & ok )
+    {
+	__m512 const zero = _mm512_setzero_ps();
+	__m512 const one = _mm512_set1_ps( 1.0f );
+	__mmask16 const badSand =
+		_mm512_cmp_ps_mask( s, zero, _CMP_NGE_UQ ) |
+		_mm512_cmp_ps_mask( s, one, _CMP_NLE_UQ );
+	__mmask16 const badClay =
+		_mm512_cmp_ps_mask( c, zero, _CMP_NGE_UQ ) |
+		_mm512_cmp_ps_mask( c, one, _CMP_NLE_UQ );
+	__mmask16 const badOM = _mm512_cmp_ps_mask( om, zero, _CMP_NGE_UQ );
+	__mmask16 const badSum = _mm512_cmp_ps_mask( _mm512_add_ps( s, c ), one, _CMP_NLE_UQ );
+	__m512i status = _mm512_maskz_mov_epi32( badSand, _mm512_set1_epi32( SWCharEst::StatusSand ) );
+	status = _mm512_mask_or_epi32( status, badClay, status,
+				       _mm512_set1_epi32( SWCharEst::StatusClay ) );
+	status = _mm512_mask_or_epi32( status, badOM, status,
+				       _mm512_set1_epi32( SWCharEst::StatusOM ) );
+	status = _mm512_mask_or_epi32( status, badSum, status,
+				       _mm512_set1_epi32( SWCharEst::StatusSandClay ) );
+	ok = static_cast<__mmask16>( ~( badSand | badClay | badOM | badSum ) );
+	return status;
+    }
+
+    // Saxton & Rawls equations for 16 soils
+    TEH_TARGET_AVX512
+    inline void Kernel16 (
+	__m512 const s, __m512 const c, __m512 const ompc,
+	__m512 & wp, __m512 & fc, __m512 & thetaS, __m512 & ks,
+	__m512i & status )
+    {
+	__m512 const om = _mm512_min_ps( ompc, _mm512_set1_ps( 70.0f ) );
+	__mmask16 ok;
+	status = Status16( s, c, om, ok );
+
+	__m512 const som = _mm512_mul_ps( s, om );
+	__m512 const com = _mm512_mul_ps( c, om );
+	__m512 const sc = _mm512_mul_ps( s, c );
+
+	__m512 const t1500t = Regression16( s, c, om, som, com, sc,
+			SWCharEstMatrix::coefficients[SWCharEstMatrix::Theta1500t] );
+	__m512 const t33t = Regression16( s, c, om, som, com, sc,
+			SWCharEstMatrix::coefficients[SWCharEstMatrix::Theta33t] );
+	__m512 const tS33t = Regression16( s, c, om, som, com, sc,
+			SWCharEstMatrix::coefficients[SWCharEstMatrix::ThetaS33t] );
+
+	__m512 const t33 = _mm512_min_ps(
+		_mm512_fmadd_ps( _mm512_fmadd_ps( _mm512_set1_ps( 1.283f ), t33t,
+						  _mm512_set1_ps( 1.0f - 0.374f ) ),
+				 t33t, _mm512_set1_ps( -0.015f ) ),
+		_mm512_set1_ps( 0.80f ) );
+	__m512 t1500 = _mm512_max_ps(
+		_mm512_fmadd_ps( _mm512_set1_ps( 1.14f ), t1500t, _mm512_set1_ps( -0.02f ) ),
+		_mm512_set1_ps( 0.01f ) );
+	t1500 = _mm512_min_ps( t1500, _mm512_mul_ps( _mm512_set1_ps( 0.80f ), t33 ) );
+	__m512 const tS33 = _mm512_fmadd_ps( _mm512_set1_ps( 1.636f ), tS33t,
+					     _mm512_set1_ps( -0.107f ) );
+	__m512 const tS = _mm512_fmadd_ps( _mm512_set1_ps( -0.097f ), s,
+			_mm512_add_ps( _mm512_add_ps( t33, tS33 ), _mm512_set1_ps( 0.043f ) ) );
+
+	// invalid soils get placeholder values for the Ks calculation
+	__m512 const k1500 = _mm512_mask_mov_ps( _mm512_set1_ps( 0.1f ), ok, t1500 );
+	__m512 const k33 = _mm512_mask_mov_ps( _mm512_set1_ps( 0.2f ), ok, t33 );
+	__m512 const kS = _mm512_mask_mov_ps( _mm512_set1_ps( 0.3f ), ok, tS );
+
+	// Ks = 1930 * (thetaS - theta33)^(3 - lamda) / 36000
+	__m512 const lamda = _mm512_mul_ps( _mm512_sub_ps( Log16( k33 ), Log16( k1500 ) ),
+					    _mm512_set1_ps( invB ) );
+	__m512 const power = _mm512_mul_ps( _mm512_sub_ps( _mm512_set1_ps( 3.0f ), lamda ),
+					    Log16( _mm512_sub_ps( kS, k33 ) ) );
+	__m512 const Ks = _mm512_mul_ps( _mm512_set1_ps( ksFactor ), Exp16( power ) );
+
+	wp = _mm512_maskz_mov_ps( ok, t1500 );
+	fc = _mm512_maskz_mov_ps( ok, t33 );
+	thetaS = _mm512_maskz_mov_ps( ok, tS );
+	ks = _mm512_maskz_mov_ps( ok, Ks );
+    }
+
+} // namespace
+
+
+TEH_TARGET_AVX2
+std::size_t SWCharEstSIMD::GetBatchAVX2 (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks,			// output: sat. hydraulic conductivity
+    unsigned char * const status)	// output: input status bits; may be null
+{
+    __m256 vWP, vFC, vThetaS, vKs;
+    __m256i vStatus;
+    std::size_t rejected = 0;
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+	Kernel8( _mm256_loadu_ps( sand + i ),
+		 _mm256_loadu_ps( clay + i ),
+		 _mm256_loadu_ps( ompc + i ),
+		 vWP, vFC, vThetaS, vKs, vStatus );
+	_mm256_storeu_ps( wp + i, vWP );
+	_mm256_storeu_ps( fc + i, vFC );
+	_mm256_storeu_ps( thetaS + i, vThetaS );
+	_mm256_storeu_ps( ks + i, vKs );
+	rejected += NumRejected8( vStatus );
+	if ( status )
+	    StoreStatus8( status + i, vStatus, 8 );
+    }
+    if ( i < n )	// remainder
+    {
+	__m256i const mask = _mm256_cmpgt_epi32(
+		_mm256_set1_epi32( static_cast<int>( n - i ) ),
+		_mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) );
+	Kernel8( _mm256_maskload_ps( sand + i, mask ),
+		 _mm256_maskload_ps( clay + i, mask ),
+		 _mm256_maskload_ps( ompc + i, mask ),
+		 vWP, vFC, vThetaS, vKs, vStatus );
+	_mm256_maskstore_ps( wp + i, mask, vWP );
+	_mm256_maskstore_ps( fc + i, mask, vFC );
+	_mm256_maskstore_ps( thetaS + i, mask, vThetaS );
+	_mm256_maskstore_ps( ks + i, mask, vKs );
+	vStatus = _mm256_and_si256( vStatus, mask );	// zero in unused lanes
+	rejected += NumRejected8( vStatus );
+	if ( status )
+	    StoreStatus8( status + i, vStatus, n - i );
+    }
+    return rejected;
+}
+
+TEH_TARGET_AVX512
+std::size_t SWCharEstSIMD::GetBatchAVX512 (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks,			// output: sat. hydraulic conductivity
+    unsigned char * const status)	// output: input status bits; may be null
+{
+    __m512 vWP, vFC, vThetaS, vKs;
+    __m512i vStatus;
+    std::size_t rejected = 0;
+    std::size_t i = 0;
+    for ( ; i + 16 <= n; i += 16 )
+    {
+	Kernel16( _mm512_loadu_ps( sand + i ),
+		  _mm512_loadu_ps( clay + i ),
+		  _mm512_loadu_ps( ompc + i ),
+		  vWP, vFC, vThetaS, vKs, vStatus );
+	_mm512_storeu_ps( wp + i, vWP );
+	_mm512_storeu_ps( fc + i, vFC );
+	_mm512_storeu_ps( thetaS + i, vThetaS );
+	_mm512_storeu_ps( ks + i, vKs );
+	rejected += __builtin_popcount(
+		_mm512_test_epi32_mask( vStatus, vStatus ) );
+	if ( status )
+	    _mm512_mask_cvtepi32_storeu_epi8( status + i, 0xffff, vStatus );
+    }
+    if ( i < n )	// remainder
+    {
+	__mmask16 const mask = static_cast<__mmask16>( (1u << (n - i)) - 1u );
+	Kernel16( _mm512_maskz_loadu_ps( mask, sand + i ),
+		  _mm512_maskz_loadu_ps( mask, clay + i ),
+		  _mm512_maskz_loadu_ps( mask, ompc + i ),
+		  vWP, vFC, vThetaS, vKs, vStatus );
+	_mm512_mask_storeu_ps( wp + i, mask, vWP );
+	_mm512_mask_storeu_ps( fc + i, mask, vFC );
+	_mm512_mask_storeu_ps( thetaS + i, mask, vThetaS );
+	_mm512_mask_storeu_ps( ks + i, mask, vKs );
+	rejected += __builtin_popcount(
+		_mm512_mask_test_epi32_mask( mask, vStatus, vStatus ) );
+	if ( status )
+	    _mm512_mask_cvtepi32_storeu_epi8( status + i, mask, vStatus );
+    }
+    return rejected;
+}
+
+TEH_TARGET_AVX2
+std::size_t SWCharEstSIMD::PackAVX2 (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    unsigned char * const status,	// output: input status bits
+    float * const packedSand,		// output: sand of valid soils
+    float * const packedClay,		// output: clay of valid soils
+    float * const packedOM)		// output: OM of valid soils
+{
+    static PackTable const table;
+    std::size_t k = 0;
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+	__m256 const s = _mm256_loadu_ps( sand + i );
+	__m256 const c = _mm256_loadu_ps( clay + i );
+	__m256 const om = _mm256_loadu_ps( ompc + i );
+	__m256i const st = Status8( s, c, _mm256_min_ps( om, _mm256_set1_ps( 70.0f ) ) );
+	StoreStatus8( status + i, st, 8 );
+	unsigned const valid = ValidLanes8( st );
+	__m256i const perm = Permutation8( table.pack[valid] );
+	// all 8 lanes are stored; only the valid ones are used
+	_mm256_storeu_ps( packedSand + k, _mm256_permutevar8x32_ps( s, perm ) );
+	_mm256_storeu_ps( packedClay + k, _mm256_permutevar8x32_ps( c, perm ) );
+	_mm256_storeu_ps( packedOM + k, _mm256_permutevar8x32_ps( om, perm ) );
+	k += __builtin_popcount( valid );
+    }
+    for ( ; i < n; ++i )	// remainder
+    {
+	status[i] = SWCharEst::Status( sand[i], clay[i], ompc[i] );
+	packedSand[k] = sand[i];
+	packedClay[k] = clay[i];
+	packedOM[k] = ompc[i];
+	k += ( status[i] == 0 );
+    }
+    return k;
+}
+
+TEH_TARGET_AVX2
+void SWCharEstSIMD::UnpackAVX2 (
+    std::size_t const n,		// number of soils
+    unsigned char const * const status,	// input status bits from PackAVX2
+    float const * const packed,		// values of the valid soils
+    float * const values)		// output: values of all soils
+{
+    static PackTable const table;
+    std::size_t k = 0;
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+	__m256i const st = _mm256_cvtepu8_epi32(
+		_mm_loadl_epi64( reinterpret_cast<__m128i const *>( status + i ) ) );
+	__m256 const ok = _mm256_castsi256_ps(
+		_mm256_cmpeq_epi32( st, _mm256_setzero_si256() ) );
+	unsigned const valid = _mm256_movemask_ps( ok );
+	// lanes past the valid values are loaded, but not used
+	__m256 const v = _mm256_permutevar8x32_ps( _mm256_loadu_ps( packed + k ),
+						   Permutation8( table.expand[valid] ) );
+	_mm256_storeu_ps( values + i, _mm256_and_ps( ok, v ) );
+	k += __builtin_popcount( valid );
+    }
+    for ( ; i < n; ++i )	// remainder
+    {
+	values[i] = ( status[i] == 0 ? packed[k] : 0.0f );
+	k += ( status[i] == 0 );
+    }
+}
+
+TEH_TARGET_AVX512
+std::size_t SWCharEstSIMD::PackAVX512 (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    unsigned char * const status,	// output: input status bits
+    float * const packedSand,		// output: sand of valid soils
+    float * const packedClay,		// output: clay of valid soils
+    float * const packedOM)		// output: OM of valid soils
+{
+    std::size_t k = 0;
+    for ( std::size_t i = 0; i < n; i += 16 )
+    {
+	__mmask16 const mask = ( n - i >= 16 ? 0xffff
+				 : static_cast<__mmask16>( (1u << (n - i)) - 1u ) );
+	__m512 const s = _mm512_maskz_loadu_ps( mask, sand + i );
+	__m512 const c = _mm512_maskz_loadu_ps( mask, clay + i );
+	__m512 const om = _mm512_maskz_loadu_ps( mask, ompc + i );
+	__mmask16 ok;
+	__m512i const st = Status16( s, c, _mm512_min_ps( om, _mm512_set1_ps( 70.0f ) ), ok );
+	ok &= mask;
+	_mm512_mask_cvtepi32_storeu_epi8( status + i, mask, st );
+	_mm512_mask_compressstoreu_ps( packedSand + k, ok, s );
+	_mm512_mask_compressstoreu_ps( packedClay + k, ok, c );
+	_mm512_mask_compressstoreu_ps( packedOM + k, ok, om );
+	k += __builtin_popcount( ok );
+    }
+    return k;
+}
+
+TEH_TARGET_AVX512
+void SWCharEstSIMD::UnpackAVX512 (
+    std::size_t const n,		// number of soils
+    unsigned char const * const status,	// input status bits from PackAVX512
+    float const * const packed,		// values of the valid soils
+    float * const values)		// output: values of all soils
+{
+    std::size_t k = 0;
+    std::size_t i = 0;
+    for ( ; i + 16 <= n; i += 16 )
+    {
+	__m128i const st = _mm_loadu_si128( reinterpret_cast<__m128i const *>( status + i ) );
+	__mmask16 const ok = static_cast<__mmask16>(
+		_mm_movemask_epi8( _mm_cmpeq_epi8( st, _mm_setzero_si128() ) ) );
+	_mm512_storeu_ps( values + i, _mm512_maskz_expandloadu_ps( ok, packed + k ) );
+	k += __builtin_popcount( ok );
+    }
+    for ( ; i < n; ++i )	// remainder
+    {
+	values[i] = ( status[i] == 0 ? packed[k] : 0.0f );
+	k += ( status[i] == 0 );
+    }
+}
+
+} // namespace teh
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // TEH_SWCHAREST_X86_KERNELS
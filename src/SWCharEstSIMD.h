@@ -0,0 +1,118 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstSIMD.h
+@class		teh::SWCharEstSIMD
+@brief 		x86 SIMD kernels for teh::SWCharEst::GetBatch.
+@details {
+		Hand-written AVX2/FMA (8 lanes) and AVX-512 (16 lanes) versions
+		of the Saxton & Rawls equations, with vectorized log and exp.
+		Each kernel has the same arguments and results as
+		SWCharEst::GetBatch with a status array.
+		Results agree with SWCharEst::Get
+		to within 1e-4 (WP, FC, thetaS) and 1e-3 (Ks) relative.
+		The kernels are compiled with function target attributes,
+		so no special compiler flags are needed, but a kernel
+		must only be called on a CPU that supports it.
+		SWCharEst::GetBatch selects a kernel at run time;
+		see SWCharEst::SetBatchKernel.
+		Available with g++ or clang++ on x86 only;
+		otherwise TEH_SWCHAREST_X86_KERNELS is not defined.
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstSIMD_h
+#define INC_teh_SWCharEstSIMD_h
+
+#include <cstddef>
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && defined(__GNUC__)
+  #define TEH_SWCHAREST_X86_KERNELS
+#endif
+
+namespace teh {
+
+#ifdef TEH_SWCHAREST_X86_KERNELS
+
+    class SWCharEstSIMD
+    {
+      public:
+
+	/// SWCharEst::GetBatch using AVX2 and FMA instructions.
+	static std::size_t GetBatchAVX2 (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks,			///< output: sat. hydraulic conductivity
+	    unsigned char * const status);	///< output: input status bits; may be null
+
+	/// SWCharEst::GetBatch using AVX-512F instructions.
+	static std::size_t GetBatchAVX512 (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks,			///< output: sat. hydraulic conductivity
+	    unsigned char * const status);	///< output: input status bits; may be null
+
+	/// Finds the input status of n soils, as GetBatchAVX2,
+	/// and packs the inputs of the valid soils, in order, using AVX2;
+	/// returns the number of valid soils.
+	/// The packed arrays must have room for n values.
+	static std::size_t PackAVX2 (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    unsigned char * const status,	///< output: input status bits
+	    float * const packedSand,		///< output: sand of valid soils
+	    float * const packedClay,		///< output: clay of valid soils
+	    float * const packedOM);		///< output: OM of valid soils
+
+	/// Unpacks one output of the soils packed by PackAVX2;
+	/// soils with a nonzero status get zero.
+	/// The packed array must have room for n values.
+	static void UnpackAVX2 (
+	    std::size_t const n,		///< number of soils
+	    unsigned char const * const status,	///< input status bits from PackAVX2
+	    float const * const packed,		///< values of the valid soils
+	    float * const values);		///< output: values of all soils
+
+	/// PackAVX2 using AVX-512F instructions.
+	static std::size_t PackAVX512 (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    unsigned char * const status,	///< output: input status bits
+	    float * const packedSand,		///< output: sand of valid soils
+	    float * const packedClay,		///< output: clay of valid soils
+	    float * const packedOM);		///< output: OM of valid soils
+
+	/// UnpackAVX2 using AVX-512F instructions.
+	static void UnpackAVX512 (
+	    std::size_t const n,		///< number of soils
+	    unsigned char const * const status,	///< input status bits from PackAVX512
+	    float const * const packed,		///< values of the valid soils
+	    float * const values);		///< output: values of all soils
+
+      private:
+
+	// not used
+	SWCharEstSIMD ();
+    };
+
+#endif // TEH_SWCHAREST_X86_KERNELS
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstSIMD_h
@@ -0,0 +1,221 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstTable.cpp
+// class	teh::SWCharEstTable
+// brief 	Lookup table of Saxton & Rawls estimates for whole-percent
+//		sand and clay, and OM in steps of 0.1%.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstTable.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+
+namespace teh {
+
+
+namespace {
+
+    // table file header
+    char const fileMagic[16] = "SWCharEstTable1";
+    std::size_t const cellsPerSlice =
+	SWCharEstTable::numTexture * SWCharEstTable::numTexture;
+
+    // Table indices of the arguments; returns false if not on the grid.
+    // A grid value converts back to exactly the float argument,
+    // so the table cell is the same as SWCharEst::Evaluate.
+    bool GridIndex (
+	float const sand,
+	float const clay,
+	float const ompc,
+	int & iSand,
+	int & iClay,
+	int & iOM )
+    {
+	float const om = std::min ( 70.0f, ompc );	// upper limit OM%, as Evaluate
+	// also false for NaN
+	if ( !( sand >= 0.0f && sand <= 1.0f &&
+		clay >= 0.0f && clay <= 1.0f &&
+		om >= 0.0f ) )
+	    return false;
+	iSand = static_cast<int>( sand * 100.0f + 0.5f );
+	iClay = static_cast<int>( clay * 100.0f + 0.5f );
+	iOM = static_cast<int>( om * SWCharEstTable::omPerPercent + 0.5f );
+	return static_cast<float>(iSand) / 100.0f == sand &&
+	       static_cast<float>(iClay) / 100.0f == clay &&
+	       static_cast<float>(iOM) / SWCharEstTable::omPerPercent == om;
+    }
+
+} // namespace
+
+
+SWCharEstTable::SWCharEstTable ()
+{
+    for ( int k = 0; k < numOM; ++k )
+	ready[k].store( false );
+}
+
+SWCharEstTable::Cell const * SWCharEstTable::Slice (
+    int const k )
+{
+    std::call_once( built[k], [this, k] ()
+    {
+	std::unique_ptr<Cell[]> cells ( new Cell [cellsPerSlice] );
+	float const om = static_cast<float>(k) / omPerPercent;
+	for ( int i = 0; i < numTexture; ++i )
+	{
+	    float const sand = static_cast<float>(i) / 100.0f;
+	    for ( int j = 0; j < numTexture; ++j )
+		cells[i * numTexture + j] =
+		    SWCharEst::Evaluate( sand, static_cast<float>(j) / 100.0f, om );
+	}
+	slices[k] = std::move( cells );
+	ready[k].store( true, std::memory_order_release );
+    } );
+    return slices[k].get();
+}
+
+SWCharEst::Results SWCharEstTable::Get (
+    float const sand,			// sand fraction (0-1)
+    float const clay,			// clay fraction (0-1)
+    float const ompc)			// organic matter wt %
+{
+    int iSand, iClay, iOM;
+    if ( GridIndex( sand, clay, ompc, iSand, iClay, iOM ) )
+	return Slice(iOM)[ iSand * numTexture + iClay ];
+    return SWCharEst::Evaluate( sand, clay, ompc );
+}
+
+SWCharEst::Results SWCharEstTable::Lookup (
+    int const sandPercent,		// sand weight % (0-100)
+    int const clayPercent,		// clay weight % (0-100)
+    int const omTenths)			// organic matter, tenths of wt %
+{
+    if ( sandPercent < 0 || sandPercent >= numTexture ||
+	 clayPercent < 0 || clayPercent >= numTexture ||
+	 omTenths < 0 )
+    {
+	SWCharEst::Results const zeros = { 0.0f, 0.0f, 0.0f, 0.0f };
+	return zeros;
+    }
+    int const k = std::min( omTenths, numOM - 1 );	// upper limit OM%
+    return Slice(k)[ sandPercent * numTexture + clayPercent ];
+}
+
+void SWCharEstTable::GetBatch (
+    std::size_t const n,		// number of soils
+    float const * const sand,		// sand fractions (0-1)
+    float const * const clay,		// clay fractions (0-1)
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks)			// output: sat. hydraulic conductivity
+{
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	SWCharEst::Results const r = Get( sand[i], clay[i], ompc[i] );
+	wp[i] = r.WP;
+	fc[i] = r.FC;
+	thetaS[i] = r.thetaS;
+	ks[i] = r.Ks;
+    }
+}
+
+bool SWCharEstTable::IsOnGrid (
+    float const sand,			// sand fraction (0-1)
+    float const clay,			// clay fraction (0-1)
+    float const ompc)			// organic matter wt %
+{
+    int iSand, iClay, iOM;
+    return GridIndex( sand, clay, ompc, iSand, iClay, iOM );
+}
+
+void SWCharEstTable::Build ()
+{
+    for ( int k = 0; k < numOM; ++k )
+	Slice(k);
+}
+
+int SWCharEstTable::NumSlicesBuilt () const
+{
+    int count = 0;
+    for ( int k = 0; k < numOM; ++k )
+	if ( ready[k].load( std::memory_order_acquire ) )
+	    ++count;
+    return count;
+}
+
+// File layout, native byte order:
+//   16 chars	fileMagic
+//   int32	numTexture, numOM, omPerPercent, number of slices
+//   for each slice:
+//     int32	OM index
+//     float	WP, FC, thetaS, Ks for each cell
+bool SWCharEstTable::Save (
+    std::string const & fileName ) const
+{
+    std::ofstream os ( fileName.c_str(), std::ios::binary | std::ios::trunc );
+    if ( !os )
+	return false;
+    int32_t header[4] = { numTexture, numOM, omPerPercent, 0 };
+    bool isReady[numOM];
+    for ( int k = 0; k < numOM; ++k )
+    {
+	isReady[k] = ready[k].load( std::memory_order_acquire );
+	header[3] += isReady[k];
+    }
+    os.write( fileMagic, sizeof(fileMagic) );
+    os.write( reinterpret_cast<char const *>(header), sizeof(header) );
+    for ( int32_t k = 0; k < numOM; ++k )
+    {
+	if ( !isReady[k] )
+	    continue;
+	os.write( reinterpret_cast<char const *>(&k), sizeof(k) );
+	os.write( reinterpret_cast<char const *>( slices[k].get() ),
+		  cellsPerSlice * sizeof(Cell) );
+    }
+    os.close();
+    return !os.fail();
+}
+
+bool SWCharEstTable::Load (
+    std::string const & fileName )
+{
+    std::ifstream is ( fileName.c_str(), std::ios::binary );
+    if ( !is )
+	return false;
+    char magic[sizeof(fileMagic)];
+    int32_t header[4];
+    is.read( magic, sizeof(magic) );
+    is.read( reinterpret_cast<char *>(header), sizeof(header) );
+    if ( !is ||
+	 std::memcmp( magic, fileMagic, sizeof(fileMagic) ) != 0 ||
+	 header[0] != numTexture || header[1] != numOM ||
+	 header[2] != omPerPercent ||
+	 header[3] < 0 || header[3] > numOM )
+	return false;
+    for ( int32_t n = 0; n < header[3]; ++n )
+    {
+	int32_t k = -1;
+	std::unique_ptr<Cell[]> cells ( new Cell [cellsPerSlice] );
+	is.read( reinterpret_cast<char *>(&k), sizeof(k) );
+	is.read( reinterpret_cast<char *>( cells.get() ), cellsPerSlice * sizeof(Cell) );
+	if ( !is || k < 0 || k >= numOM )
+	    return false;
+	std::call_once( built[k], [this, k, &cells] ()
+	{
+	    slices[k] = std::move( cells );
+	    ready[k].store( true, std::memory_order_release );
+	} );
+    }
+    return true;
+}
+
+} // namespace teh
@@ -0,0 +1,135 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstTable.h
+@class		teh::SWCharEstTable
+@brief 		Lookup table of Saxton & Rawls estimates for whole-percent textures.
+@details {
+		Most soil data give sand and clay as whole percents, and
+		organic matter to 0.1%. For these inputs a table of
+		precomputed WP, FC, thetaS, Ks replaces the equations,
+		so that each estimate is a single table read with no log
+		or pow calls.
+		The table has 101 sand x 101 clay values for each OM value
+		from 0 to 70% in steps of 0.1%. An OM slice is calculated,
+		by SWCharEst::Evaluate, the first time it is used,
+		or loaded from a file written by Save.
+		The results are identical to SWCharEst::Evaluate.
+		Cells where sand + clay > 100% contain zeros, as do
+		invalid inputs. Inputs which are not on the table grid are
+		passed to SWCharEst::Evaluate.
+		The methods are thread-safe.
+		A fully built table uses about 114 MB.
+}
+@example {
+	Example - silt loam:
+	    teh::SWCharEstTable table;
+	    teh::SWCharEst::Results r = table.Get( 0.15f, 0.18f, 3.1f );
+
+	Example - SSURGO integer percents, OM in tenths of a percent:
+	    teh::SWCharEst::Results r = table.Lookup( 15, 18, 31 );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstTable_h
+#define INC_teh_SWCharEstTable_h
+
+#include "SWCharEst.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace teh {
+
+
+    class SWCharEstTable
+    {
+      public:
+
+	/// Number of sand or clay values: 0 to 100%.
+	static int const numTexture = 101;
+
+	/// Number of OM values: 0 to 70% in steps of 0.1%.
+	static int const numOM = 701;
+
+	/// OM values per percent.
+	static int const omPerPercent = 10;
+
+	SWCharEstTable ();
+
+	/// Returns WP, FC, thetaS, Ks; all are zero if the arguments are invalid.
+	/// Uses the table if sand and clay are whole percents and
+	/// OM is a multiple of 0.1%, else SWCharEst::Evaluate.
+	SWCharEst::Results Get (
+	    float const sand,			///< sand fraction (0-1)
+	    float const clay,			///< clay fraction (0-1)
+	    float const ompc);			///< organic matter wt %
+
+	/// Returns WP, FC, thetaS, Ks from the table;
+	/// all are zero if the arguments are out of range.
+	SWCharEst::Results Lookup (
+	    int const sandPercent,		///< sand weight % (0-100)
+	    int const clayPercent,		///< clay weight % (0-100)
+	    int const omTenths);		///< organic matter, tenths of wt %
+
+	/// Get for n soils, with the arguments of SWCharEst::GetBatch.
+	void GetBatch (
+	    std::size_t const n,		///< number of soils
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay,		///< clay fractions (0-1)
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks);			///< output: sat. hydraulic conductivity
+
+	/// Returns true if the arguments are on the table grid.
+	static bool IsOnGrid (
+	    float const sand,			///< sand fraction (0-1)
+	    float const clay,			///< clay fraction (0-1)
+	    float const ompc);			///< organic matter wt %
+
+	/// Calculates all OM slices; otherwise slices are calculated when used.
+	void Build ();
+
+	/// Returns the number of OM slices calculated or loaded.
+	int NumSlicesBuilt () const;
+
+	/// Writes the OM slices built so far to a binary file.
+	/// The file is only readable on a machine with the same byte order.
+	/// Returns false if the file could not be written.
+	bool Save (
+	    std::string const & fileName ) const;
+
+	/// Reads the OM slices from a file written by Save.
+	/// Slices already built are not changed.
+	/// Returns false if the file could not be read or is not a table file.
+	bool Load (
+	    std::string const & fileName );
+
+      private:
+
+	typedef SWCharEst::Results Cell;
+
+	// cells for each OM value; index = sand% * numTexture + clay%
+	std::unique_ptr<Cell[]> slices[numOM];
+	std::once_flag built[numOM];
+	std::atomic<bool> ready[numOM];		// true after the slice is stored
+
+	// Returns the cells for OM index k, calculating them on first use.
+	Cell const * Slice (
+	    int const k );
+
+	// not used
+	SWCharEstTable (SWCharEstTable const & rhs);
+	SWCharEstTable & operator= (SWCharEstTable const & rhs);
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstTable_h
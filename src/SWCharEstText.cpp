@@ -0,0 +1,754 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstText.cpp
+// class	teh::SWCharEstText
+// brief 	Fast conversions of floats to and from text, and scanning of delimited text.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstText.h"
+#include "SWCharEst.h"
+#include "SWCharEstSIMD.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+  #include <emmintrin.h>
+  #define TEH_SWCHAREST_SCAN
+#endif
+
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  #define TEH_SWCHAREST_SWAR
+#endif
+
+#ifdef TEH_SWCHAREST_X86_KERNELS
+  #include <immintrin.h>
+  #define TEH_TARGET_AVX2	__attribute__((target("avx2,fma")))
+  #define TEH_TARGET_AVX512	__attribute__((target("avx512f,avx2,fma")))
+#endif
+
+
+namespace teh {
+
+
+namespace {
+
+    // 1e-64 to 1e64; 1e0 to 1e22 are exact.
+    double const powersOf10[129] =
+    {
+	1e-64, 1e-63, 1e-62, 1e-61, 1e-60, 1e-59, 1e-58, 1e-57,
+	1e-56, 1e-55, 1e-54, 1e-53, 1e-52, 1e-51, 1e-50, 1e-49,
+	1e-48, 1e-47, 1e-46, 1e-45, 1e-44, 1e-43, 1e-42, 1e-41,
+	1e-40, 1e-39, 1e-38, 1e-37, 1e-36, 1e-35, 1e-34, 1e-33,
+	1e-32, 1e-31, 1e-30, 1e-29, 1e-28, 1e-27, 1e-26, 1e-25,
+	1e-24, 1e-23, 1e-22, 1e-21, 1e-20, 1e-19, 1e-18, 1e-17,
+	1e-16, 1e-15, 1e-14, 1e-13, 1e-12, 1e-11, 1e-10, 1e-9,
+	1e-8, 1e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1,
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+	1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22, 1e23,
+	1e24, 1e25, 1e26, 1e27, 1e28, 1e29, 1e30, 1e31,
+	1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38, 1e39,
+	1e40, 1e41, 1e42, 1e43, 1e44, 1e45, 1e46, 1e47,
+	1e48, 1e49, 1e50, 1e51, 1e52, 1e53, 1e54, 1e55,
+	1e56, 1e57, 1e58, 1e59, 1e60, 1e61, 1e62, 1e63,
+	1e64
+    };
+
+    inline double PowerOf10 ( int const k )	// -64 <= k <= 64
+    {
+	return powersOf10[k + 64];
+    }
+
+    // 10^0 to 10^8
+    inline uint32_t PowerOf10Integer ( int const k )
+    {
+	static uint32_t const powers[9] =
+	    { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+	return powers[k];
+    }
+
+    int const maxExactPower = 22;			// 10^22 < 2^53 * 2^22
+    uint64_t const maxExactMantissa = uint64_t(1) << 53;
+
+    // Returns false unless mantissa * 10^exponent can be found exactly
+    // rounded: both are exact doubles, and so is their correctly rounded
+    // product or quotient; which then rounds to the nearest float,
+    // unless it is halfway between two floats (double rounding).
+    inline bool FastFloat (
+	uint64_t const mantissa,
+	int const exponent,
+	float & value )
+    {
+	if ( mantissa > maxExactMantissa ||
+	     exponent < -maxExactPower || exponent > maxExactPower )
+	    return false;
+	double const d = ( exponent < 0
+			   ? static_cast<double>( mantissa ) / PowerOf10( -exponent )
+			   : static_cast<double>( mantissa ) * PowerOf10( exponent ) );
+	uint64_t bits;
+	std::memcpy( &bits, &d, sizeof(bits) );
+	if ( ( bits & 0x1FFFFFFF ) == 0x10000000 )	// the 29 bits below a float
+	    return false;
+	value = static_cast<float>( d );
+	return true;
+    }
+
+    // std::strtof, which must read all of begin to end.
+    bool Strtof (
+	char const * const begin,
+	char const * const end,
+	float & value )
+    {
+	if ( begin == end || *begin == ' ' || *begin == '\t' )
+	    return false;
+	std::string const text ( begin, end );
+	char * numberEnd;
+	float const v = std::strtof( text.c_str(), &numberEnd );
+	if ( numberEnd != text.c_str() + text.size() )
+	    return false;
+	value = v;
+	return true;
+    }
+
+    // mantissa * 10^exponent, correctly rounded.
+    float DecimalToFloat (
+	uint64_t const mantissa,
+	int const exponent )
+    {
+	float value;
+	if ( FastFloat( mantissa, exponent, value ) )
+	    return value;
+	char text[48];
+	int const length = std::snprintf( text, sizeof(text), "%llue%d",
+					  static_cast<unsigned long long>( mantissa ), exponent );
+	Strtof( text, text + length, value );
+	return value;
+    }
+
+    // The fewest digits of a which read back as a, padded to 9, found by
+    // reading back each rounding of scaled = a * 10^(8 - e10), from 8
+    // digits down; rounded from scaled, not digits9, to round once.
+    uint32_t ShortestByReading (
+	float const a,
+	double const scaled,
+	int const e10,
+	uint32_t const digits9,
+	int & exponent )		// output: of the first digit
+    {
+	uint64_t digits = digits9;
+	int numDigits = 9;
+	exponent = e10;
+	uint64_t divisor = 10;
+	uint64_t limit = 100000000;	// 10^n
+	for ( int n = 8; n >= 1; --n, divisor *= 10, limit /= 10 )
+	{
+	    uint64_t d = static_cast<uint64_t>( scaled / static_cast<double>( divisor ) + 0.5 );
+	    int de10 = e10;
+	    if ( d == limit )		// rounded up to 10^n
+	    {
+		d /= 10;
+		++de10;
+	    }
+	    if ( DecimalToFloat( d, de10 - ( n - 1 ) ) != a )
+		break;
+	    digits = d;
+	    numDigits = n;
+	    exponent = de10;
+	}
+	return static_cast<uint32_t>( digits * PowerOf10Integer( 9 - numDigits ) );
+    }
+
+    // The 8 digits of n < 10^8, one per byte, the first in the lowest
+    // byte, each split of a number in two done in all of its parts at once.
+    inline uint64_t Digits8 ( uint32_t const n )
+    {
+	uint64_t y = ( n / 10000 ) | ( static_cast<uint64_t>( n % 10000 ) << 32 );
+	uint64_t t = ( ( y * 10486 ) >> 20 ) & 0x0000007F0000007FULL;	// / 100
+	y = t | ( ( y - t * 100 ) << 16 );
+	t = ( ( y * 103 ) >> 10 ) & 0x000F000F000F000FULL;		// / 10
+	return t | ( ( y - t * 10 ) << 8 );
+    }
+
+    // The number of digits of Digits8 to the last nonzero one.
+    inline int NumDigits8 ( uint64_t const y )
+    {
+#ifdef TEH_SWCHAREST_SWAR
+	return 8 - __builtin_clzll( y | 1 ) / 8 - ( y == 0 );
+#else
+	int n = 0;
+	for ( uint64_t rest = y; rest != 0; rest >>= 8 )
+	    ++n;
+	return n;
+#endif
+    }
+
+    // Writes the 8 bytes of y, the lowest first.
+    inline void Store8 (
+	char * const text,
+	uint64_t const y )
+    {
+#ifdef TEH_SWCHAREST_SWAR
+	std::memcpy( text, &y, 8 );
+#else
+	for ( int i = 0; i < 8; ++i )
+	    text[i] = static_cast<char>( ( y >> ( 8 * i ) ) & 0xFF );
+#endif
+    }
+
+    // The fewest digits of a, positive and finite, which read back as a,
+    // padded to 9, and the exponent of the first digit.
+    inline uint32_t ShortestDigits (
+	float const a,
+	int & exponent )		// output: of the first digit
+    {
+	// 9 significant digits, digits9 * 10^(e10 - 8), always read back as a
+	double const v = a;
+	uint32_t bits;
+	std::memcpy( &bits, &a, sizeof(bits) );
+	int e2 = static_cast<int>( bits >> 23 ) - 126;	// a = m * 2^e2, 0.5 <= m < 1
+	if ( bits < 0x00800000 )			// subnormal
+	    std::frexp( v, &e2 );
+	// e10 = floor( ( e2 - 1 ) * log10(2) ), or one more if a >= 10^(e10 + 1)
+	int e10 = ( ( e2 - 1 ) * 78913 ) >> 18;
+	e10 += ( v * PowerOf10( 8 - e10 ) + 0.5 >= 1.0e9 );
+	double const scale = PowerOf10( 8 - e10 );
+	double const scaled = v * scale;
+	uint32_t const digits9 = static_cast<uint32_t>( scaled + 0.5 );
+
+	// The numbers which read back as a are those within half of scaled,
+	// half being half the gap to the neighbours of a, 2^(e2 - 25) if a
+	// is normal, scaled like a; except for a power of 2, whose lower
+	// neighbour is nearer.
+	// j digits can be dropped if a multiple of 10^j is in that interval,
+	// from low to high in whole units, which is if high % 10^j <= width;
+	// then so is the nearest one, which rounding scaled half up gives.
+	// This holds for fewer digits too, and if width < 1000, a third
+	// digit, and more, can be dropped only if they are zeros in high.
+	// scaled is within 3e-7 of v * 10^(8 - e10), so if an end is within
+	// margin of a whole unit, or a is a power of 2 or subnormal, the
+	// digits are found by reading back.
+	uint64_t const halfGapBits = static_cast<uint64_t>( e2 - 25 + 1023 ) << 52;
+	double halfGap;
+	std::memcpy( &halfGap, &halfGapBits, sizeof(halfGap) );
+	double const half = halfGap * scale;
+	double const margin = 1.0e-6;
+	double const lowEnd = std::ceil( scaled - half - margin );
+	double const highEnd = std::floor( scaled + half + margin );
+	bool const uncertain =
+	    ( ( bits & 0x007FFFFF ) == 0 || bits < 0x00800000 ) |
+	    ( lowEnd <= scaled - half + margin ) |
+	    ( highEnd >= scaled + half - margin );
+	uint32_t const high = static_cast<uint32_t>( highEnd );
+	uint32_t const width = high - static_cast<uint32_t>( lowEnd );
+	uint32_t const whole = static_cast<uint32_t>( scaled );
+	int k =					// digits dropped
+	    ( high % 10 <= width ) + ( high % 100 <= width ) + ( high % 1000 <= width );
+
+	uint32_t padded;				// the digits, padded to 9
+	exponent = e10;
+	if ( uncertain )
+	    padded = ShortestByReading( a, scaled, e10, digits9, exponent );
+	else if ( k < 3 )
+	{
+	    // whole % 10^k >= 10^k / 2, from the remainders of 10 and 100
+	    uint32_t const r10 = whole % 10;
+	    uint32_t const r100 = whole % 100;
+	    uint32_t const down = ( k == 2 ? r100 : ( k == 1 ? r10 : 0 ) );
+	    uint32_t const power = ( k == 2 ? 100 : ( k == 1 ? 10 : 1 ) );
+	    padded = ( k == 0 ? digits9 : whole - down + power * ( 2 * down >= power ) );
+	}
+	else
+	{
+	    for ( uint32_t rest = high / 1000; k < 8 && rest % 10 == 0; rest /= 10 )
+		++k;
+	    uint32_t const power = PowerOf10Integer( k );
+	    padded = ( whole + power / 2 ) / power * power;
+	}
+	if ( padded == 1000000000 )			// rounded up to 10^9
+	{
+	    padded = 100000000;
+	    ++exponent;
+	}
+	return padded;
+    }
+
+    // Writes the digits of ShortestDigits at q; returns the end of the text.
+    inline char * WriteDigits (
+	char * q,
+	uint32_t const padded,		// the digits, padded to 9
+	int const exponent )		// of the first digit
+    {
+	// the digits, without the zeros after the last nonzero one
+	uint32_t const first = padded / 100000000;
+	uint64_t const rest = Digits8( padded - first * 100000000 );
+	int const numDigits = 1 + NumDigits8( rest );
+	char const firstChar = static_cast<char>( '0' + first );
+	uint64_t const chars = rest + 0x3030303030303030ULL;	// + '0'
+
+	// The text is written with copies of 8 digits, which can go past
+	// its end; the digits after numDigits are zeros, or past them.
+	if ( exponent < -4 || exponent >= 9 )	// d.ddde-XX
+	{
+	    q[0] = firstChar;
+	    q[1] = '.';
+	    Store8( q + 2, chars );
+	    q += ( numDigits > 1 ? numDigits + 1 : 1 );
+	    int const e = std::abs( exponent );
+	    q[0] = 'e';
+	    q[1] = ( exponent < 0 ? '-' : '+' );
+	    q[2] = static_cast<char>( '0' + e / 10 );
+	    q[3] = static_cast<char>( '0' + e % 10 );
+	    q += 4;
+	}
+	else if ( exponent >= 0 )			// ddd.ddd
+	{
+	    q[0] = firstChar;
+	    Store8( q + 1, chars );
+	    q += exponent + 1;
+	    if ( numDigits > exponent + 1 )		// and so exponent < 8
+	    {
+		*q = '.';
+		Store8( q + 1, chars >> ( 8 * exponent ) );
+		q += numDigits - exponent;
+	    }
+	}
+	else					// 0.000ddd
+	{
+	    std::memcpy( q, "0.000000", 8 );
+	    q += 1 - exponent;
+	    q[0] = firstChar;
+	    Store8( q + 1, chars );
+	    q += numDigits;
+	}
+	return q;
+    }
+
+    inline bool IsDigit ( char const c )
+    {
+	return static_cast<unsigned>( c - '0' ) < 10u;
+    }
+
+#ifdef TEH_SWCHAREST_SCAN
+    inline uint32_t Separators16 (
+	char const * const text,
+	__m128i const newline,
+	__m128i const quote,
+	__m128i const delimiter )
+    {
+	__m128i const x = _mm_loadu_si128( reinterpret_cast<__m128i const *>( text ) );
+	__m128i const found = _mm_or_si128(
+	    _mm_or_si128( _mm_cmpeq_epi8( x, newline ), _mm_cmpeq_epi8( x, quote ) ),
+	    _mm_cmpeq_epi8( x, delimiter ) );
+	return static_cast<uint32_t>( _mm_movemask_epi8( found ) );
+    }
+#endif
+
+#ifdef TEH_SWCHAREST_X86_KERNELS
+
+// GCC's intrinsics headers fill the unused source of the gathers, and of
+// many AVX-512 intrinsics, with _mm256_undefined_pd or _mm512_undefined_pd,
+// which -Wall reports as uninitialized when inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+    //----------------------------------------------------------- AVX2 -----
+
+    TEH_TARGET_AVX2
+    inline __m256d Floor4 ( __m256d const x )
+    {
+	return _mm256_round_pd( x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC );
+    }
+
+    // x % d, for whole x < 2^32; inverse = 1 / d rounds up, for d = 10,
+    // 100 and 1000, so the quotient of a multiple of d is not too small.
+    TEH_TARGET_AVX2
+    inline __m256d Remainder4 ( __m256d const x, double const d, double const inverse )
+    {
+	return _mm256_fnmadd_pd( Floor4( _mm256_mul_pd( x, _mm256_set1_pd( inverse ) ) ),
+				 _mm256_set1_pd( d ), x );
+    }
+
+    // ShortestDigits of 4 values at a time, as doubles, with up to
+    // 2 digits dropped; values which ShortestDigits reads back, or with
+    // 3 or more digits dropped, and 0, inf and nan, get 0 digits.
+    // Returns the number of values done.
+    TEH_TARGET_AVX2
+    std::size_t FindDigitsAVX2 (
+	std::size_t const n,
+	float const * const values,
+	uint32_t * const digits,
+	int * const exponents )
+    {
+	__m256d const margin = _mm256_set1_pd( 1.0e-6 );
+	__m256d const oneHalf = _mm256_set1_pd( 0.5 );
+	__m256d const ones = _mm256_set1_pd( 1.0 );
+	__m128i const one = _mm_set1_epi32( 1 );
+	__m128i const exponentMask = _mm_set1_epi32( 0x7F800000 );
+	std::size_t i = 0;
+	for ( ; i + 4 <= n; i += 4 )
+	{
+	    __m128i const bits = _mm_and_si128(
+		_mm_loadu_si128( reinterpret_cast<__m128i const *>( values + i ) ),
+		_mm_set1_epi32( 0x7FFFFFFF ) );
+	    __m256d const v = _mm256_cvtps_pd( _mm_castsi128_ps( bits ) );
+
+	    // e2, e10 and scale as ShortestDigits
+	    __m128i const e2 = _mm_sub_epi32( _mm_srli_epi32( bits, 23 ), _mm_set1_epi32( 126 ) );
+	    __m128i e10 = _mm_srai_epi32( _mm_mullo_epi32(
+				_mm_sub_epi32( e2, one ), _mm_set1_epi32( 78913 ) ), 18 );
+	    __m128i const index = _mm_sub_epi32( _mm_set1_epi32( 64 + 8 ), e10 );
+	    __m256d const scale0 = _mm256_i32gather_pd( powersOf10, index, 8 );
+	    __m256d const scale1 = _mm256_i32gather_pd( powersOf10, _mm_sub_epi32( index, one ), 8 );
+	    __m256d const more = _mm256_cmp_pd( _mm256_add_pd( _mm256_mul_pd( v, scale0 ), oneHalf ),
+						_mm256_set1_pd( 1.0e9 ), _CMP_GE_OQ );
+	    __m256d const scale = _mm256_blendv_pd( scale0, scale1, more );
+	    __m256d const scaled = _mm256_mul_pd( v, scale );
+
+	    // the interval, and the digits which can be dropped
+	    __m256d const halfGap = _mm256_castsi256_pd( _mm256_slli_epi64( _mm256_add_epi64(
+		_mm256_cvtepi32_epi64( e2 ), _mm256_set1_epi64x( 1023 - 25 ) ), 52 ) );
+	    __m256d const half = _mm256_mul_pd( halfGap, scale );
+	    __m256d const low = _mm256_sub_pd( scaled, half );
+	    __m256d const high = _mm256_add_pd( scaled, half );
+	    __m256d const lowEnd = _mm256_round_pd( _mm256_sub_pd( low, margin ),
+						    _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC );
+	    __m256d const highEnd = Floor4( _mm256_add_pd( high, margin ) );
+	    __m256d const width = _mm256_sub_pd( highEnd, lowEnd );
+	    __m256d const drop1 = _mm256_cmp_pd( Remainder4( highEnd, 10.0, 0.1 ), width, _CMP_LE_OQ );
+	    __m256d const drop2 = _mm256_cmp_pd( Remainder4( highEnd, 100.0, 0.01 ), width, _CMP_LE_OQ );
+	    __m256d const drop3 = _mm256_cmp_pd( Remainder4( highEnd, 1000.0, 0.001 ), width, _CMP_LE_OQ );
+
+	    // 0, subnormal, inf, nan, or a power of 2
+	    __m128i const exponentBits = _mm_and_si128( bits, exponentMask );
+	    __m128i const special = _mm_or_si128( _mm_or_si128(
+		_mm_cmpeq_epi32( exponentBits, _mm_setzero_si128() ),
+		_mm_cmpeq_epi32( exponentBits, exponentMask ) ),
+		_mm_cmpeq_epi32( _mm_and_si128( bits, _mm_set1_epi32( 0x007FFFFF ) ), _mm_setzero_si128() ) );
+	    __m256d const uncertain = _mm256_or_pd( _mm256_or_pd(
+		_mm256_castsi256_pd( _mm256_cvtepi32_epi64( special ) ), drop3 ), _mm256_or_pd(
+		_mm256_cmp_pd( lowEnd, _mm256_add_pd( low, margin ), _CMP_LE_OQ ),
+		_mm256_cmp_pd( highEnd, _mm256_sub_pd( high, margin ), _CMP_GE_OQ ) ) );
+
+	    // scaled rounded half up to 9, 8 or 7 digits
+	    __m256d const whole = Floor4( scaled );
+	    __m256d const down1 = Remainder4( whole, 10.0, 0.1 );
+	    __m256d const down2 = Remainder4( whole, 100.0, 0.01 );
+	    __m256d const digits1 = _mm256_add_pd( _mm256_sub_pd( whole, down1 ), _mm256_and_pd(
+		_mm256_cmp_pd( down1, _mm256_set1_pd( 5.0 ), _CMP_GE_OQ ), _mm256_set1_pd( 10.0 ) ) );
+	    __m256d const digits2 = _mm256_add_pd( _mm256_sub_pd( whole, down2 ), _mm256_and_pd(
+		_mm256_cmp_pd( down2, _mm256_set1_pd( 50.0 ), _CMP_GE_OQ ), _mm256_set1_pd( 100.0 ) ) );
+	    __m256d padded = Floor4( _mm256_add_pd( scaled, oneHalf ) );
+	    padded = _mm256_blendv_pd( padded, digits1, drop1 );
+	    padded = _mm256_blendv_pd( padded, digits2, drop2 );
+	    __m256d const up = _mm256_cmp_pd( padded, _mm256_set1_pd( 1.0e9 ), _CMP_EQ_OQ );
+	    padded = _mm256_blendv_pd( padded, _mm256_set1_pd( 1.0e8 ), up );
+	    e10 = _mm_add_epi32( e10, _mm256_cvttpd_epi32( _mm256_add_pd(
+		_mm256_and_pd( more, ones ), _mm256_and_pd( up, ones ) ) ) );
+
+	    _mm_storeu_si128( reinterpret_cast<__m128i *>( digits + i ),
+			      _mm256_cvttpd_epi32( _mm256_andnot_pd( uncertain, padded ) ) );
+	    _mm_storeu_si128( reinterpret_cast<__m128i *>( exponents + i ), e10 );
+	}
+	return i;
+    }
+
+
+    //-------------------------------------------------------- AVX-512 -----
+
+    TEH_TARGET_AVX512
+    inline __m512d Floor8 ( __m512d const x )
+    {
+	return _mm512_roundscale_pd( x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC );
+    }
+
+    // Remainder4 using AVX-512F instructions.
+    TEH_TARGET_AVX512
+    inline __m512d Remainder8 ( __m512d const x, double const d, double const inverse )
+    {
+	return _mm512_fnmadd_pd( Floor8( _mm512_mul_pd( x, _mm512_set1_pd( inverse ) ) ),
+				 _mm512_set1_pd( d ), x );
+    }
+
+    // FindDigitsAVX2 using AVX-512F instructions, 8 values at a time.
+    TEH_TARGET_AVX512
+    std::size_t FindDigitsAVX512 (
+	std::size_t const n,
+	float const * const values,
+	uint32_t * const digits,
+	int * const exponents )
+    {
+	__m512d const margin = _mm512_set1_pd( 1.0e-6 );
+	__m512d const oneHalf = _mm512_set1_pd( 0.5 );
+	__m512d const ones = _mm512_set1_pd( 1.0 );
+	__m256i const one = _mm256_set1_epi32( 1 );
+	__m256i const exponentMask = _mm256_set1_epi32( 0x7F800000 );
+	std::size_t i = 0;
+	for ( ; i + 8 <= n; i += 8 )
+	{
+	    __m256i const bits = _mm256_and_si256(
+		_mm256_loadu_si256( reinterpret_cast<__m256i const *>( values + i ) ),
+		_mm256_set1_epi32( 0x7FFFFFFF ) );
+	    __m512d const v = _mm512_cvtps_pd( _mm256_castsi256_ps( bits ) );
+
+	    // e2, e10 and scale as ShortestDigits
+	    __m256i const e2 = _mm256_sub_epi32( _mm256_srli_epi32( bits, 23 ), _mm256_set1_epi32( 126 ) );
+	    __m256i e10 = _mm256_srai_epi32( _mm256_mullo_epi32(
+				_mm256_sub_epi32( e2, one ), _mm256_set1_epi32( 78913 ) ), 18 );
+	    __m256i const index = _mm256_sub_epi32( _mm256_set1_epi32( 64 + 8 ), e10 );
+	    __m512d const scale0 = _mm512_i32gather_pd( index, powersOf10, 8 );
+	    __m512d const scale1 = _mm512_i32gather_pd( _mm256_sub_epi32( index, one ), powersOf10, 8 );
+	    __mmask8 const more = _mm512_cmp_pd_mask( _mm512_add_pd( _mm512_mul_pd( v, scale0 ), oneHalf ),
+						      _mm512_set1_pd( 1.0e9 ), _CMP_GE_OQ );
+	    __m512d const scale = _mm512_mask_blend_pd( more, scale0, scale1 );
+	    __m512d const scaled = _mm512_mul_pd( v, scale );
+
+	    // the interval, and the digits which can be dropped
+	    __m512d const halfGap = _mm512_castsi512_pd( _mm512_slli_epi64( _mm512_add_epi64(
+		_mm512_cvtepi32_epi64( e2 ), _mm512_set1_epi64( 1023 - 25 ) ), 52 ) );
+	    __m512d const half = _mm512_mul_pd( halfGap, scale );
+	    __m512d const low = _mm512_sub_pd( scaled, half );
+	    __m512d const high = _mm512_add_pd( scaled, half );
+	    __m512d const lowEnd = _mm512_roundscale_pd( _mm512_sub_pd( low, margin ),
+							 _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC );
+	    __m512d const highEnd = Floor8( _mm512_add_pd( high, margin ) );
+	    __m512d const width = _mm512_sub_pd( highEnd, lowEnd );
+	    __mmask8 const drop1 = _mm512_cmp_pd_mask( Remainder8( highEnd, 10.0, 0.1 ), width, _CMP_LE_OQ );
+	    __mmask8 const drop2 = _mm512_cmp_pd_mask( Remainder8( highEnd, 100.0, 0.01 ), width, _CMP_LE_OQ );
+	    __mmask8 const drop3 = _mm512_cmp_pd_mask( Remainder8( highEnd, 1000.0, 0.001 ), width, _CMP_LE_OQ );
+
+	    // 0, subnormal, inf, nan, or a power of 2
+	    __m256i const exponentBits = _mm256_and_si256( bits, exponentMask );
+	    __m256i const special = _mm256_or_si256( _mm256_or_si256(
+		_mm256_cmpeq_epi32( exponentBits, _mm256_setzero_si256() ),
+		_mm256_cmpeq_epi32( exponentBits, exponentMask ) ),
+		_mm256_cmpeq_epi32( _mm256_and_si256( bits, _mm256_set1_epi32( 0x007FFFFF ) ),
+				    _mm256_setzero_si256() ) );
+	    __mmask8 const uncertain = static_cast<__mmask8>(
+		_mm256_movemask_ps( _mm256_castsi256_ps( special ) ) | drop3 |
+		_mm512_cmp_pd_mask( lowEnd, _mm512_add_pd( low, margin ), _CMP_LE_OQ ) |
+		_mm512_cmp_pd_mask( highEnd, _mm512_sub_pd( high, margin ), _CMP_GE_OQ ) );
+
+	    // scaled rounded half up to 9, 8 or 7 digits
+	    __m512d const whole = Floor8( scaled );
+	    __m512d const down1 = Remainder8( whole, 10.0, 0.1 );
+	    __m512d const down2 = Remainder8( whole, 100.0, 0.01 );
+	    __m512d const digits1 = _mm512_mask_add_pd( _mm512_sub_pd( whole, down1 ),
+		_mm512_cmp_pd_mask( down1, _mm512_set1_pd( 5.0 ), _CMP_GE_OQ ),
+		_mm512_sub_pd( whole, down1 ), _mm512_set1_pd( 10.0 ) );
+	    __m512d const digits2 = _mm512_mask_add_pd( _mm512_sub_pd( whole, down2 ),
+		_mm512_cmp_pd_mask( down2, _mm512_set1_pd( 50.0 ), _CMP_GE_OQ ),
+		_mm512_sub_pd( whole, down2 ), _mm512_set1_pd( 100.0 ) );
+	    __m512d padded = Floor8( _mm512_add_pd( scaled, oneHalf ) );
+	    padded = _mm512_mask_blend_pd( drop1, padded, digits1 );
+	    padded = _mm512_mask_blend_pd( drop2, padded, digits2 );
+	    __mmask8 const up = _mm512_cmp_pd_mask( padded, _mm512_set1_pd( 1.0e9 ), _CMP_EQ_OQ );
+	    padded = _mm512_mask_mov_pd( padded, up, _mm512_set1_pd( 1.0e8 ) );
+	    e10 = _mm256_add_epi32( e10, _mm512_cvttpd_epi32( _mm512_add_pd(
+		_mm512_maskz_mov_pd( more, ones ), _mm512_maskz_mov_pd( up, ones ) ) ) );
+
+	    _mm256_storeu_si256( reinterpret_cast<__m256i *>( digits + i ),
+				 _mm512_cvttpd_epi32( _mm512_maskz_mov_pd(
+				     static_cast<__mmask8>( ~uncertain ), padded ) ) );
+	    _mm256_storeu_si256( reinterpret_cast<__m256i *>( exponents + i ), e10 );
+	}
+	return i;
+    }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // TEH_SWCHAREST_X86_KERNELS
+
+} // namespace
+
+
+bool SWCharEstText::ParseFloat (
+    char const * const begin,	// first character
+    char const * const end,	// after the last character
+    float & value )		// output: the number
+{
+    char const * p = begin;
+    bool const negative = ( p < end && *p == '-' );
+    if ( p < end && ( *p == '-' || *p == '+' ) )
+	++p;
+
+    // the first 19 significant digits, mantissa * 10^exponent
+    uint64_t mantissa = 0;
+    int numSignificant = 0;
+    int exponent = 0;
+    bool truncated = false;		// nonzero digits after the 19th
+    char const * const integerBegin = p;
+    for ( ; p < end && IsDigit( *p ); ++p )
+    {
+	if ( numSignificant < 19 )
+	{
+	    mantissa = 10 * mantissa + ( *p - '0' );
+	    numSignificant += ( mantissa != 0 );
+	}
+	else
+	{
+	    ++exponent;
+	    truncated = truncated || ( *p != '0' );
+	}
+    }
+    std::size_t numDigits = p - integerBegin;
+    if ( p < end && *p == '.' )
+    {
+	char const * const fractionBegin = ++p;
+	for ( ; p < end && IsDigit( *p ); ++p )
+	{
+	    if ( numSignificant < 19 )
+	    {
+		mantissa = 10 * mantissa + ( *p - '0' );
+		numSignificant += ( mantissa != 0 );
+		--exponent;
+	    }
+	    else
+		truncated = truncated || ( *p != '0' );
+	}
+	numDigits += p - fractionBegin;
+    }
+    if ( numDigits == 0 )		// inf, nan, or not a number
+	return Strtof( begin, end, value );
+    if ( p < end && ( *p == 'e' || *p == 'E' ) )
+    {
+	++p;
+	bool const negativeExponent = ( p < end && *p == '-' );
+	if ( p < end && ( *p == '-' || *p == '+' ) )
+	    ++p;
+	if ( !( p < end && IsDigit( *p ) ) )
+	    return false;
+	int e = 0;
+	for ( ; p < end && IsDigit( *p ); ++p )
+	    if ( e < 100000 )
+		e = 10 * e + ( *p - '0' );
+	exponent += ( negativeExponent ? -e : e );
+    }
+    if ( p != end )			// hex, or not a number
+	return Strtof( begin, end, value );
+
+    float v;
+    if ( mantissa == 0 )
+	v = 0.0f;
+    else if ( truncated || !FastFloat( mantissa, exponent, v ) )
+	return Strtof( begin, end, value );
+    value = ( negative ? -v : v );
+    return true;
+}
+
+char * SWCharEstText::FormatFloat (
+    float const value,		// value to write
+    char * const text )		// output: maxFormatted characters or less
+{
+    char * p = text;
+    if ( value != value )
+    {
+	std::memcpy( p, "nan", 3 );
+	return p + 3;
+    }
+    if ( std::signbit( value ) )
+	*p++ = '-';
+    float const a = std::fabs( value );
+    if ( a == 0.0f )
+    {
+	*p++ = '0';
+	return p;
+    }
+    if ( a > FLT_MAX )
+    {
+	std::memcpy( p, "inf", 3 );
+	return p + 3;
+    }
+
+    int exponent;
+    uint32_t const digits = ShortestDigits( a, exponent );
+    return WriteDigits( p, digits, exponent );
+}
+
+void SWCharEstText::FindDigits (
+    std::size_t const n,		// number of values
+    float const * const values,		// values to write
+    uint32_t * const digits,		// output: 9 digits, or 0
+    int * const exponents )		// output: exponent of the first digit
+{
+    std::size_t i = 0;
+#ifdef TEH_SWCHAREST_X86_KERNELS
+    switch ( SWCharEst::GetBatchKernel() )
+    {
+      case SWCharEst::KernelAVX512:
+	i = FindDigitsAVX512( n, values, digits, exponents );
+	break;
+      case SWCharEst::KernelAVX2:
+	i = FindDigitsAVX2( n, values, digits, exponents );
+	break;
+      default:
+	break;
+    }
+#endif
+    for ( ; i < n; ++i )
+    {
+	float const a = std::fabs( values[i] );
+	digits[i] = ( a > 0.0f && a <= FLT_MAX ? ShortestDigits( a, exponents[i] ) : 0 );
+    }
+}
+
+char * SWCharEstText::FormatDigits (
+    float const value,		// value to write
+    uint32_t const digits,	// digits of value from FindDigits
+    int const exponent,		// exponent of value from FindDigits
+    char * const text )		// output: maxFormatted characters or less
+{
+    if ( digits == 0 )
+	return FormatFloat( value, text );
+    char * p = text;
+    if ( std::signbit( value ) )
+	*p++ = '-';
+    return WriteDigits( p, digits, exponent );
+}
+
+std::size_t SWCharEstText::FindSeparators (
+    char const * const text,	// text to scan
+    std::size_t const size,	// number of characters
+    char const delimiter,	// field delimiter
+    uint32_t * const positions )	// output: offsets in text
+{
+    std::size_t count = 0;
+    std::size_t i = 0;
+#ifdef TEH_SWCHAREST_SCAN
+    __m128i const newline = _mm_set1_epi8( '\n' );
+    __m128i const quote = _mm_set1_epi8( '"' );
+    __m128i const delimiters = _mm_set1_epi8( delimiter );
+    for ( ; i + 32 <= size; i += 32 )
+    {
+	uint32_t found =
+	    Separators16( text + i, newline, quote, delimiters ) |
+	    ( Separators16( text + i + 16, newline, quote, delimiters ) << 16 );
+	while ( found != 0 )
+	{
+	    positions[count++] = static_cast<uint32_t>( i + __builtin_ctz( found ) );
+	    found &= found - 1;
+	}
+    }
+#endif
+    for ( ; i < size; ++i )
+    {
+	char const c = text[i];
+	if ( c == '\n' || c == '"' || c == delimiter )
+	    positions[count++] = static_cast<uint32_t>( i );
+    }
+    return count;
+}
+
+} // namespace teh
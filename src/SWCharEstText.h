@@ -0,0 +1,112 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstText.h
+@class		teh::SWCharEstText
+@brief 		Fast conversions of floats to and from text, and scanning of delimited text.
+@details {
+		ParseFloat reads a decimal number, with the same result as
+		std::strtof, correctly rounded. Most numbers, with up to
+		19 significant digits and a decimal exponent within 22,
+		are found with one double multiply or divide, which is
+		exact, and rounded to float (Clinger's fast path); when the
+		double lies exactly halfway between two floats, or for
+		other numbers (more digits, large exponents, inf, nan, hex),
+		std::strtof is used.
+		FormatFloat writes a float with the fewest significant
+		digits which read back as the same float, in the
+		style of printf "%g": 0.00043272183, 0.1286, 1.5e-07.
+		The value is scaled to 9 digits, which always read back,
+		and the digits which can be dropped are found from the
+		interval of numbers which read back as the value; in the
+		few cases too near the ends of the interval, roundings to
+		fewer digits are checked with the fast path of ParseFloat.
+		FindDigits does the same for an array of values, with
+		AVX2 or AVX-512 instructions, and FormatDigits writes
+		the text of each value from its digits.
+		FindSeparators finds the positions of the newlines, quotes
+		and delimiters in a block of text, 16 bytes at a time
+		with SSE2 compares, so that the fields of the rows can be
+		found without looking at each character again.
+		These do not depend on the locale.
+}
+@example {
+	Example:
+	    float value;
+	    bool const ok = teh::SWCharEstText::ParseFloat( begin, end, value );
+	    char text[teh::SWCharEstText::maxFormatted];
+	    char * const textEnd = teh::SWCharEstText::FormatFloat( value, text );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstText_h
+#define INC_teh_SWCharEstText_h
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace teh {
+
+
+    class SWCharEstText
+    {
+      public:
+
+	/// Largest number of characters written by FormatFloat, which
+	/// can be more than its text, of 15 characters or less,
+	/// as in "-1.23456789e-38".
+	static std::size_t const maxFormatted = 18;
+
+	/// Reads the number in begin to end, with no spaces;
+	/// returns false if it is not all a number.
+	static bool ParseFloat (
+	    char const * const begin,	///< first character
+	    char const * const end,	///< after the last character
+	    float & value );		///< output: the number
+
+	/// Writes the shortest text which reads back as value,
+	/// with no terminating null; returns the end of the text.
+	static char * FormatFloat (
+	    float const value,		///< value to write
+	    char * const text );	///< output: maxFormatted characters or less
+
+	/// Finds the digits of FormatFloat for n values, for FormatDigits:
+	/// 9 digits, with zeros after the last one, and the exponent of
+	/// the first digit; or 0 digits for a value which FormatDigits
+	/// writes with FormatFloat. Uses the SIMD instructions of
+	/// SWCharEst::GetBatchKernel, if any.
+	static void FindDigits (
+	    std::size_t const n,	///< number of values
+	    float const * const values,	///< values to write
+	    uint32_t * const digits,	///< output: 9 digits, or 0
+	    int * const exponents );	///< output: exponent of the first digit
+
+	/// Writes the text of FormatFloat from the digits and exponent
+	/// found by FindDigits; returns the end of the text.
+	static char * FormatDigits (
+	    float const value,		///< value to write
+	    uint32_t const digits,	///< digits of value from FindDigits
+	    int const exponent,		///< exponent of value from FindDigits
+	    char * const text );	///< output: maxFormatted characters or less
+
+	/// Finds the newlines, quotes (") and delimiters in text;
+	/// writes their offsets to positions, which must have room
+	/// for size offsets, and returns their number.
+	static std::size_t FindSeparators (
+	    char const * const text,	///< text to scan
+	    std::size_t const size,	///< number of characters, less than 2^32
+	    char const delimiter,	///< field delimiter
+	    uint32_t * const positions );	///< output: offsets in text
+
+      private:
+
+	// not used
+	SWCharEstText ();
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstText_h
@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+// file		SWCharEstTexture.cpp
+// class	teh::SWCharEstTexture
+// brief 	Precomputed texture state of many cells, for repeated OM updates.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstTexture.h"
+#include "SWCharEstMatrix.h"
+#include <algorithm>
+
+
+namespace teh {
+
+
+namespace {
+
+    typedef SWCharEstMatrix M;
+
+    // Number of cells per block in Evaluate.
+    // The block work arrays fit in the L1 cache.
+    std::size_t const blockSize = 256;
+
+} // namespace
+
+
+SWCharEstTexture::SWCharEstTexture (
+    std::size_t const n,		// number of cells
+    float const * const sandFraction,	// sand fractions (0-1)
+    float const * const clayFraction )	// clay fractions (0-1)
+    : numCells ( n ),
+      sand ( sandFraction, sandFraction + n ),
+      valid ( n ),
+      intercept ( M::numRegressions * n ),
+      slope ( M::numRegressions * n )
+{
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	float const s = sandFraction[i];
+	float const c = clayFraction[i];
+	// texture tests of CheckArgs; also invalid for NaN
+	valid[i] = ( s >= 0.0f && s <= 1.0f &&
+		     c >= 0.0f && c <= 1.0f &&
+		     s + c <= 1.0f ) ? 1.0f : 0.0f;
+	for ( int r = 0; r < M::numRegressions; ++r )
+	{
+	    float a[M::numBasisTerms];
+	    for ( int k = 0; k < M::numBasisTerms; ++k )
+		a[k] = static_cast<float>( M::coefficients[r][k] );
+	    intercept[r * n + i] =
+		a[M::BasisOne] + a[M::BasisSand] * s + a[M::BasisClay] * c
+		+ a[M::BasisSandClay] * s * c;
+	    slope[r * n + i] =
+		a[M::BasisOM] + a[M::BasisSandOM] * s + a[M::BasisClayOM] * c;
+	}
+    }
+}
+
+void SWCharEstTexture::EvaluateBlock (
+    std::size_t const start,		// first cell
+    std::size_t const m,		// number of cells
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks) const		// output: sat. hydraulic conductivity
+{
+    float regressions[M::numRegressions * blockSize];
+    float ok[blockSize];		// 1 = valid soil, 0 = invalid
+
+    float const * __restrict const cellValid = &valid[start];
+    // NaN OM is valid, and limited to 70, as in SWCharEst::GetBatch
+    for ( std::size_t i = 0; i < m; ++i )
+	ok[i] = !( ompc[i] < 0.0f ) ? cellValid[i] : 0.0f;
+    for ( int r = 0; r < M::numRegressions; ++r )
+    {
+	float const * __restrict const a = &intercept[r * numCells + start];
+	float const * __restrict const b = &slope[r * numCells + start];
+	float * __restrict const y = regressions + r * blockSize;
+	for ( std::size_t i = 0; i < m; ++i )
+	    y[i] = a[i] + b[i] * std::min( 70.0f, ompc[i] );	// upper limit OM%
+    }
+    M::Results( m, &sand[start], ok, regressions, blockSize, wp, fc, thetaS, ks );
+}
+
+void SWCharEstTexture::Evaluate (
+    float const * const ompc,		// organic matter wt %
+    float * const wp,			// output: wilting point
+    float * const fc,			// output: field capacity
+    float * const thetaS,		// output: saturated water content
+    float * const ks) const		// output: sat. hydraulic conductivity
+{
+    for ( std::size_t start = 0; start < numCells; start += blockSize )
+    {
+	std::size_t const m = std::min( blockSize, numCells - start );
+	EvaluateBlock( start, m, ompc + start,
+		       wp + start, fc + start, thetaS + start, ks + start );
+    }
+}
+
+SWCharEst::Results SWCharEstTexture::Get (
+    std::size_t const cell,		// cell index
+    float const ompc) const		// organic matter wt %
+{
+    SWCharEst::Results r = { 0.0f, 0.0f, 0.0f, 0.0f };
+    if ( cell < numCells )
+	EvaluateBlock( cell, 1, &ompc, &r.WP, &r.FC, &r.thetaS, &r.Ks );
+    return r;
+}
+
+std::size_t SWCharEstTexture::MemorySize () const
+{
+    return ( sand.size() + valid.size() + intercept.size() + slope.size() ) * sizeof(float);
+}
+
+} // namespace teh
@@ -0,0 +1,102 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		SWCharEstTexture.h
+@class		teh::SWCharEstTexture
+@brief 		Precomputed texture state of many cells, for repeated OM updates.
+@details {
+		For fixed sand and clay, each of the regressions
+		theta1500t, theta33t and thetaS33t is linear in OM:
+		regression = intercept + slope * OM.
+		The constructor stores the intercepts and slopes of
+		each cell, so that evaluating the cells for a new
+		array of OM costs one multiply-add per regression,
+		plus the constraints and Ks.
+		Use this when the texture of the cells does not change
+		but OM does, as in a simulation which updates OM each year.
+		Results agree with SWCharEst::Evaluate to within rounding
+		of the regressions, as SWCharEstMatrix::GetBatch.
+		Invalid textures or OM give zero results.
+		After construction the methods are const and thread-safe.
+}
+@example {
+	Example - update each year:
+	    teh::SWCharEstTexture const texture ( n, &sand[0], &clay[0] );
+	    for ( int year = 0; year < numYears; ++year )
+	    {
+		...update ompc...
+		texture.Evaluate( &ompc[0], &wp[0], &fc[0], &thetaS[0], &ks[0] );
+	    }
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_SWCharEstTexture_h
+#define INC_teh_SWCharEstTexture_h
+
+#include "SWCharEst.h"
+#include <cstddef>
+#include <vector>
+
+namespace teh {
+
+
+    class SWCharEstTexture
+    {
+      public:
+
+	/// Stores the intercepts and slopes of the regressions of n cells.
+	SWCharEstTexture (
+	    std::size_t const n,		///< number of cells
+	    float const * const sand,		///< sand fractions (0-1)
+	    float const * const clay );		///< clay fractions (0-1)
+
+	/// Returns the number of cells.
+	std::size_t Size () const { return numCells; }
+
+	/// Calculates the results of all cells for their OM.
+	/// Output arrays have Size() elements.
+	/// Does not allocate memory.
+	void Evaluate (
+	    float const * const ompc,		///< organic matter wt %
+	    float * const wp,			///< output: wilting point
+	    float * const fc,			///< output: field capacity
+	    float * const thetaS,		///< output: saturated water content
+	    float * const ks) const;		///< output: sat. hydraulic conductivity
+
+	/// Returns WP, FC, thetaS, Ks of one cell;
+	/// all are zero if the texture or OM is invalid.
+	/// As in SWCharEst::GetBatch, OM over 70%, or NaN, is 70%.
+	SWCharEst::Results Get (
+	    std::size_t const cell,		///< cell index (< Size())
+	    float const ompc) const;		///< organic matter wt %
+
+	/// Returns the memory size of the state in bytes.
+	std::size_t MemorySize () const;
+
+      private:
+
+	std::size_t const numCells;
+
+	// per cell; the regressions are rows of SWCharEstMatrix::Regression
+	std::vector<float> sand;		// sand fraction, for thetaS
+	std::vector<float> valid;		// 1 = valid texture, 0 = invalid
+	std::vector<float> intercept;		// 3 x numCells, regressions at OM = 0
+	std::vector<float> slope;		// 3 x numCells, d(regression)/d(OM)
+
+	// Evaluate for cells start to start + m - 1, m <= block size
+	void EvaluateBlock (
+	    std::size_t const start,
+	    std::size_t const m,
+	    float const * const ompc,
+	    float * const wp,
+	    float * const fc,
+	    float * const thetaS,
+	    float * const ks) const;
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_SWCharEstTexture_h
@@ -0,0 +1,127 @@
+//-----------------------------------------------------------------------------
+// file		ThreadPool.cpp
+// class	teh::ThreadPool
+// brief 	Persistent pool of worker threads for parallel loops.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+
+namespace teh {
+
+
+ThreadPool::ThreadPool (
+    unsigned const numThreads )		// 0 = number of hardware threads
+    : stop ( false ),
+      generation ( 0 ),
+      busy ( 0 ),
+      job ( nullptr ),
+      jobSize ( 0 ),
+      next ( 0 )
+{
+    unsigned n = numThreads;
+    if ( n == 0 )
+	n = std::max( 1u, std::thread::hardware_concurrency() );
+    workers.reserve( n - 1 );
+    for ( unsigned id = 1; id < n; ++id )
+	workers.push_back( std::thread( &ThreadPool::Worker, this, id ) );
+}
+
+ThreadPool::~ThreadPool ()
+{
+    {
+	std::lock_guard<std::mutex> lock ( mutex );
+	stop = true;
+    }
+    wake.notify_all();
+    for ( std::thread & worker : workers )
+	worker.join();
+}
+
+void ThreadPool::Run (
+    std::size_t const numTasks,		// number of tasks
+    Task const & task )			// called once for each task
+{
+    if ( numTasks == 0 )
+	return;
+    std::lock_guard<std::mutex> runLock ( runMutex );
+    if ( workers.empty() || numTasks == 1 )
+    {
+	for ( std::size_t i = 0; i < numTasks; ++i )
+	    task( i, 0 );
+	return;
+    }
+
+    {
+	std::lock_guard<std::mutex> lock ( mutex );
+	job = &task;
+	jobSize = numTasks;
+	next.store( 0 );
+	busy = static_cast<unsigned>( workers.size() );
+	error = nullptr;
+	++generation;
+    }
+    wake.notify_all();
+    Work( 0 );
+
+    std::unique_lock<std::mutex> lock ( mutex );
+    done.wait( lock, [this] () { return busy == 0; } );
+    job = nullptr;
+    if ( error )
+    {
+	std::exception_ptr const e = error;
+	error = nullptr;
+	std::rethrow_exception( e );
+    }
+}
+
+void ThreadPool::Worker (
+    unsigned const id )
+{
+    unsigned long seen = 0;
+    for ( ;; )
+    {
+	{
+	    std::unique_lock<std::mutex> lock ( mutex );
+	    wake.wait( lock, [this, seen] () { return stop || generation != seen; } );
+	    if ( stop )
+		return;
+	    seen = generation;
+	}
+	Work( id );
+	std::lock_guard<std::mutex> lock ( mutex );
+	if ( --busy == 0 )
+	    done.notify_one();
+    }
+}
+
+// Takes tasks from the shared counter until there are none left.
+void ThreadPool::Work (
+    unsigned const id )
+{
+    for ( ;; )
+    {
+	std::size_t const i = next.fetch_add( 1 );
+	if ( i >= jobSize )
+	    break;
+	try
+	{
+	    (*job)( i, id );
+	}
+	catch ( ... )
+	{
+	    std::lock_guard<std::mutex> lock ( mutex );
+	    if ( !error )
+		error = std::current_exception();
+	    next.store( jobSize );		// start no more tasks
+	}
+    }
+}
+
+} // namespace teh
@@ -0,0 +1,101 @@
+/*! ----------------------------------------------------------------------------------------------------------
+@file		ThreadPool.h
+@class		teh::ThreadPool
+@brief 		Persistent pool of worker threads for parallel loops.
+@details {
+		The threads are started by the constructor and wait
+		for work until the destructor.
+		Run calls a task function for task indices 0 to numTasks - 1,
+		shared among the workers and the calling thread,
+		and returns when all tasks are done.
+		Tasks are taken in order from a shared counter, so that
+		workers which finish early take more tasks.
+		If a task throws an exception, the remaining tasks are
+		not started, and Run rethrows the first exception.
+		Calls of Run from several threads are serialized.
+		Run must not be called from inside a task.
+}
+@example {
+	Example - parallel loop over chunks:
+	    teh::ThreadPool pool ( 8 );
+	    pool.Run( numChunks, [&] ( std::size_t chunk, unsigned worker )
+	    {
+		...process chunk...
+	    } );
+}
+@author		Thomas E. Hilinski <https://github.com/tehilinski>
+@copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+		This software library, including source code and documentation,
+		is licensed under the Apache License version 2.0.
+		See the file "LICENSE.md" for more information.
+----------------------------------------------------------------------------------------------------------*/
+#ifndef INC_teh_ThreadPool_h
+#define INC_teh_ThreadPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace teh {
+
+
+    class ThreadPool
+    {
+      public:
+
+	/// Task function: task index, and worker index (0 = calling thread).
+	typedef std::function<void ( std::size_t, unsigned )> Task;
+
+	/// Starts numThreads - 1 worker threads; the calling thread
+	/// of Run is the other one.
+	explicit ThreadPool (
+	    unsigned const numThreads = 0 );	///< 0 = number of hardware threads
+
+	/// Stops and joins the worker threads.
+	~ThreadPool ();
+
+	/// Returns the number of threads, including the calling thread.
+	unsigned NumThreads () const
+	  {
+	    return static_cast<unsigned>( workers.size() ) + 1;
+	  }
+
+	/// Calls task for 0 to numTasks - 1 in parallel; returns when all are done.
+	void Run (
+	    std::size_t const numTasks,		///< number of tasks
+	    Task const & task );		///< called once for each task
+
+      private:
+
+	std::vector<std::thread> workers;
+	std::mutex runMutex;			// serializes Run
+	std::mutex mutex;			// guards the job and worker states
+	std::condition_variable wake;		// signals workers: new job or stop
+	std::condition_variable done;		// signals Run: workers are done
+	bool stop;
+	unsigned long generation;		// incremented for each job
+	unsigned busy;				// workers working on the job
+
+	// the current job
+	Task const * job;
+	std::size_t jobSize;
+	std::atomic<std::size_t> next;		// next task index
+	std::exception_ptr error;		// first exception thrown by a task
+
+	void Worker ( unsigned const id );
+	void Work ( unsigned const id );
+
+	// not used
+	ThreadPool ( ThreadPool const & );
+	ThreadPool & operator= ( ThreadPool const & );
+    };
+
+
+} // namespace teh
+
+#endif // INC_teh_ThreadPool_h
@@ -0,0 +1,124 @@
+//-----------------------------------------------------------------------------
+// file		swcharest.cpp
+// brief 	Command-line program: estimates wilting point, field capacity,
+//		saturated water content, and saturated hydraulic conductivity
+//		for rows of sand, clay and OM in a CSV file.
+// build:
+//	g++ -std=c++11 -O3 -march=native -o swcharest swcharest.cpp
+//	    SWCharEstCSV.cpp SWCharEstText.cpp SWCharEst.cpp SWCharEstSIMD.cpp
+//	    SWCharEstMatrix.cpp MappedFile.cpp ThreadPool.cpp -pthread
+// run:
+//	swcharest [options] [file]
+//	Reads the standard input if there is no file, or it is "-".
+//	Writes the results to the standard output.
+// author	Thomas E. Hilinski <https://github.com/tehilinski>
+// copyright	Copyright 2020 Thomas E. Hilinski. All rights reserved.
+//		This software library, including source code and documentation,
+//		is licensed under the Apache License version 2.0.
+//		See the file "LICENSE.md" for more information.
+//-----------------------------------------------------------------------------
+
+#include "SWCharEstCSV.h"
+#include "ThreadPool.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+
+namespace {
+
+    void Usage ()
+    {
+	std::cerr <<
+	    "Usage:\n"
+	    "  swcharest [options] [file]\n"
+	    "Reads rows of sand, clay and OM from a CSV file, or the standard input,\n"
+	    "and writes rows of wp, fc, thetaS and ks to the standard output.\n"
+	    "Options:\n"
+	    "  --sand COLUMN   column of sand fractions (0-1); default: sand\n"
+	    "  --clay COLUMN   column of clay fractions (0-1); default: clay\n"
+	    "  --om COLUMN     column of organic matter wt %; default: om\n"
+	    "                  COLUMN is a name in the header, or a number from 1\n"
+	    "  --no-header     the input has no header; columns must be numbers\n"
+	    "  -d C            field delimiter; default: ,\n"
+	    "  -t              fields are delimited by tabs\n"
+	    "  -j N            threads which convert a file; default: 0 = all\n"
+	    "  -v              write the numbers of rows to the standard error\n"
+	    "Results:\n"
+	    "  wp     = wilting point (volume fraction)\n"
+	    "  fc     = field capacity (volume fraction)\n"
+	    "  thetaS = saturated water content (volume fraction)\n"
+	    "  ks     = saturated hydraulic conductivity (cm/sec)\n"
+	    "Rows with invalid inputs have zero results.\n";
+    }
+
+    // True if text is a number of 1 to 4 digits.
+    bool IsCount ( char const * const text )
+    {
+	std::size_t const length = std::strlen( text );
+	return length > 0 && length < 5 &&
+	       std::strspn( text, "0123456789" ) == length;
+    }
+
+} // namespace
+
+
+int main ( int argc, char ** argv )
+{
+    std::string sand = "sand", clay = "clay", om = "om";
+    std::string fileName;
+    char delimiter = ',';
+    bool header = true;
+    bool verbose = false;
+    long numThreads = 0;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+	std::string const arg = argv[i];
+	bool const hasValue = ( i + 1 < argc );
+	if ( arg == "--sand" && hasValue )
+	    sand = argv[++i];
+	else if ( arg == "--clay" && hasValue )
+	    clay = argv[++i];
+	else if ( arg == "--om" && hasValue )
+	    om = argv[++i];
+	else if ( arg == "--no-header" )
+	    header = false;
+	else if ( arg == "-d" && hasValue && std::strlen( argv[i + 1] ) == 1 )
+	    delimiter = argv[++i][0];
+	else if ( arg == "-t" )
+	    delimiter = '\t';
+	else if ( arg == "-j" && hasValue && IsCount( argv[i + 1] ) )
+	    numThreads = std::atol( argv[++i] );
+	else if ( arg == "-v" )
+	    verbose = true;
+	else if ( ( arg == "-" || arg[0] != '-' ) && fileName.empty() )
+	    fileName = arg;
+	else
+	{
+	    Usage();
+	    return 1;
+	}
+    }
+
+    std::ios::sync_with_stdio( false );
+    teh::SWCharEstCSV csv ( sand, clay, om, delimiter, header );
+    bool ok;
+    if ( !fileName.empty() && fileName != "-" )
+    {
+	teh::ThreadPool pool ( static_cast<unsigned>( numThreads ) );
+	ok = csv.RunFile( fileName, std::cout, pool );
+    }
+    else
+	ok = csv.Run( std::cin, std::cout );
+    if ( !ok )
+    {
+	std::cerr << csv.ErrorMessage() << std::endl;
+	return 1;
+    }
+    if ( verbose )
+	std::cerr << "swcharest: " << csv.NumRows() << " rows, "
+		  << csv.NumInvalid() << " with invalid inputs" << std::endl;
+    return 0;
+}
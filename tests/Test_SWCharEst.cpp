@@ -1,7 +1,8 @@
 // file:	Test_SWCharEst.cpp
 // 		Test of class teh::SWCharEst
 // build:
-//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEst Test_SWCharEst.cpp ../src/SWCharEst.cpp
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEst Test_SWCharEst.cpp
+//	    ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
 // run:
 //	./Test_SWCharEst
 
@@ -10,6 +11,8 @@ using std::cout;
 using std::endl;
 #include <vector>
 #include <cmath>
+#include <cstring>
+#include <limits>
 #include "SWCharEst.h"
 using teh::SWCharEst;
 
@@ -93,10 +96,329 @@ void Test2 ()
     Compare( expected, results );
 }
 
+void TestEvaluate ()
+{
+    cout << "Test: SWCharEst::Evaluate" << endl;
+
+    //                                     WP      FC       thetaS  Ks
+    std::vector<float> const expected1 = { 0.0400, 0.09785, 0.4545, 0.003096 };
+    std::vector<float> const expected2 = { 0.1286, 0.33148, 0.5050, 0.000433 };
+
+    SWCharEst::Results const r1 = SWCharEst::Evaluate( 0.85f, 0.04f, 2.08f );
+    SWCharEst::Results const r2 = SWCharEst::Evaluate( 0.15f, 0.18f, 3.05f );
+    SWCharEst::Results const r3 = SWCharEst::Evaluate( 0.80f, 0.30f, 1.00f );	// invalid
+    std::vector<float> const results1 = { r1.WP, r1.FC, r1.thetaS, r1.Ks };
+    std::vector<float> const results2 = { r2.WP, r2.FC, r2.thetaS, r2.Ks };
+    DisplaySWCharEst( "results ", results1 );
+    Compare( expected1, results1 );
+    DisplaySWCharEst( "results ", results2 );
+    Compare( expected2, results2 );
+
+    cout << "Test: SWCharEst::Evaluate with invalid soil" << endl;
+    if ( r3.WP == 0.0f && r3.FC == 0.0f && r3.thetaS == 0.0f && r3.Ks == 0.0f )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestEvaluateDouble ()
+{
+    cout << "Test: SWCharEst::Evaluate<double>" << endl;
+
+    //                                     WP      FC       thetaS  Ks
+    std::vector<float> const expected1 = { 0.0400, 0.09785, 0.4545, 0.003096 };
+    std::vector<float> const expected2 = { 0.1286, 0.33148, 0.5050, 0.000433 };
+
+    SWCharEst::TResults<double> const r1 = SWCharEst::Evaluate( 0.85, 0.04, 2.08 );
+    SWCharEst::TResults<double> const r2 = SWCharEst::Evaluate<double>( 0.15, 0.18, 3.05 );
+    std::vector<float> const results1 = {
+	float(r1.WP), float(r1.FC), float(r1.thetaS), float(r1.Ks) };
+    std::vector<float> const results2 = {
+	float(r2.WP), float(r2.FC), float(r2.thetaS), float(r2.Ks) };
+    DisplaySWCharEst( "results ", results1 );
+    Compare( expected1, results1 );
+    DisplaySWCharEst( "results ", results2 );
+    Compare( expected2, results2 );
+}
+
+// Returns true if a and b are close, or both are NaN.
+bool AreCloseOrNaN ( float const a, float const b, float const threshold )
+{
+    if ( std::isnan(a) || std::isnan(b) )
+	return std::isnan(a) && std::isnan(b);
+    return AreClose( a, b, threshold );
+}
+
+void TestEvaluateFast ()
+{
+    cout << "Test: SWCharEst::EvaluateFast" << endl;
+
+    //                                     WP      FC       thetaS  Ks
+    std::vector<float> const expected1 = { 0.0400, 0.09785, 0.4545, 0.003096 };
+    SWCharEst::Results const r1 = SWCharEst::EvaluateFast( 0.85f, 0.04f, 2.08f );
+    std::vector<float> const results1 = { r1.WP, r1.FC, r1.thetaS, r1.Ks };
+    DisplaySWCharEst( "results ", results1 );
+    Compare( expected1, results1 );
+
+    // error budget: WP, FC, thetaS same as Evaluate; Ks relative error < 1e-5
+    cout << "Test: SWCharEst::EvaluateFast error budget over the texture triangle" << endl;
+    float const om[] = { 0.0f, 0.5f, 1.0f, 2.08f, 3.05f, 5.0f, 8.0f, 20.0f, 70.0f, 90.0f };
+    bool passed = true;
+    for ( int iSand = 0; iSand <= 200; ++iSand )
+	for ( int iClay = 0; iSand + iClay <= 200; ++iClay )
+	    for ( float const ompc : om )
+	    {
+		float const sand = 0.005f * iSand;
+		float const clay = 0.005f * iClay;
+		SWCharEst::Results const a = SWCharEst::Evaluate( sand, clay, ompc );
+		SWCharEst::Results const b = SWCharEst::EvaluateFast( sand, clay, ompc );
+		passed = passed &&
+			 a.WP == b.WP && a.FC == b.FC && a.thetaS == b.thetaS &&
+			 AreCloseOrNaN( a.Ks, b.Ks, 1.0e-5f );
+	    }
+    SWCharEst::Results const r3 = SWCharEst::EvaluateFast( 0.80f, 0.30f, 1.00f );	// invalid
+    passed = passed &&
+	     r3.WP == 0.0f && r3.FC == 0.0f && r3.thetaS == 0.0f && r3.Ks == 0.0f;
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// signature of SWCharEst::GetBatch and the SIMD kernels
+typedef void (*BatchFunction) (
+    std::size_t const, float const * const, float const * const, float const * const,
+    float * const, float * const, float * const, float * const );
+
+// Returns true if the batch function agrees with SWCharEst::Get
+// over the texture triangle, and gives zeros for invalid soils.
+// OM is limited to the 8% upper range of the Saxton & Rawls data,
+// since some water contents approach zero at very high OM.
+// Ks is NaN for some high-clay soils, where thetaS < FC.
+bool CheckBatch ( BatchFunction const batch )
+{
+    std::vector<float> sand, clay, ompc;
+    float const omValues[] = { 0.0f, 0.5f, 2.08f, 3.05f, 8.0f };
+    for ( int iOM = 0; iOM < 5; ++iOM )
+	for ( int iSand = 0; iSand <= 100; ++iSand )
+	    for ( int iClay = 0; iSand + iClay <= 100; ++iClay )
+	    {
+		sand.push_back( 0.01f * iSand );
+		clay.push_back( 0.01f * iClay );
+		ompc.push_back( omValues[iOM] );
+	    }
+    // OM above the 70% limit
+    sand.push_back( 0.30f );  clay.push_back( 0.20f );  ompc.push_back( 90.0f );
+    // invalid soils
+    sand.push_back( 0.80f );  clay.push_back( 0.30f );  ompc.push_back( 1.0f );
+    sand.push_back( -0.1f );  clay.push_back( 0.30f );  ompc.push_back( 1.0f );
+    sand.push_back( 0.50f );  clay.push_back( 1.10f );  ompc.push_back( 1.0f );
+    sand.push_back( 0.50f );  clay.push_back( 0.30f );  ompc.push_back( -1.0f );
+    std::size_t const n = sand.size();
+
+    std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+    batch( n, &sand[0], &clay[0], &ompc[0], &wp[0], &fc[0], &thetaS[0], &ks[0] );
+
+    bool passed = true;
+    SWCharEst swc;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	std::vector<float> const expected = swc.Get( sand[i], clay[i], ompc[i] );
+	passed = passed &&
+		 AreClose( expected[0], wp[i], 1.0e-4f ) &&
+		 AreClose( expected[1], fc[i], 1.0e-4f ) &&
+		 AreClose( expected[2], thetaS[i], 1.0e-4f ) &&
+		 AreCloseOrNaN( expected[3], ks[i], 1.0e-3f );
+    }
+    for ( std::size_t i = n - 4; i < n; ++i )
+	passed = passed && wp[i] == 0.0f && fc[i] == 0.0f &&
+		 thetaS[i] == 0.0f && ks[i] == 0.0f;
+    return passed;
+}
+
+void TestBatch ()
+{
+    cout << "Test: SWCharEst::GetBatch" << endl;
+    if ( CheckBatch( SWCharEst::GetBatch ) )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestKernels ()
+{
+    SWCharEst::BatchKernel const kernels[] = {
+	SWCharEst::KernelPortable, SWCharEst::KernelAVX2, SWCharEst::KernelAVX512 };
+    for ( int i = 0; i < 3; ++i )
+    {
+	cout << "Test: SWCharEst::GetBatch with kernel "
+	     << SWCharEst::KernelName( kernels[i] ) << endl;
+	if ( !SWCharEst::IsKernelSupported( kernels[i] ) )
+	{
+	    if ( !SWCharEst::SetBatchKernel( kernels[i] ) )
+		cout << "  skipped: not supported" << endl;
+	    else
+		cout << "  failed" << endl;
+	    continue;
+	}
+	if ( SWCharEst::SetBatchKernel( kernels[i] ) &&
+	     SWCharEst::GetBatchKernel() == kernels[i] &&
+	     CheckBatch( SWCharEst::GetBatch ) )
+	    cout << "  passed" << endl;
+	else
+	    cout << "  failed" << endl;
+    }
+
+    cout << "Test: SWCharEst::SetBatchKernel( KernelAuto )" << endl;
+    if ( SWCharEst::SetBatchKernel( SWCharEst::KernelAuto ) &&
+	 SWCharEst::GetBatchKernel() != SWCharEst::KernelAuto )
+	cout << "  passed: using " << SWCharEst::KernelName( SWCharEst::GetBatchKernel() ) << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// Returns true if GetBatch writes the same status as SWCharEst::Status,
+// counts the rejected soils, and gives them zero results.
+bool CheckStatus ()
+{
+    float const nan = std::numeric_limits<float>::quiet_NaN();
+    float const values[][4] = {	// sand, clay, OM, expected status
+	{ 0.30f, 0.20f, 2.0f, SWCharEst::StatusOK },
+	{ -0.1f, 0.20f, 2.0f, SWCharEst::StatusSand },
+	{ 1.10f, 0.00f, 2.0f, SWCharEst::StatusSand | SWCharEst::StatusSandClay },
+	{ 0.30f, -0.2f, 2.0f, SWCharEst::StatusClay },
+	{ 0.30f, 1.20f, 2.0f, SWCharEst::StatusClay | SWCharEst::StatusSandClay },
+	{ 0.30f, 0.20f, -1.0f, SWCharEst::StatusOM },
+	{ 0.30f, 0.20f, 90.0f, SWCharEst::StatusOK },
+	{ 0.60f, 0.50f, 2.0f, SWCharEst::StatusSandClay },
+	{ nan, 0.20f, 2.0f, SWCharEst::StatusSand | SWCharEst::StatusSandClay },
+	{ -0.1f, 1.20f, -1.0f, SWCharEst::StatusSand | SWCharEst::StatusClay |
+			       SWCharEst::StatusOM | SWCharEst::StatusSandClay } };
+    int const numValues = sizeof(values) / sizeof(values[0]);
+
+    // odd length, so that the SIMD remainders are used
+    std::size_t const n = 37;
+    std::vector<float> sand (n), clay (n), ompc (n), wp (n), fc (n), thetaS (n), ks (n);
+    std::vector<unsigned char> status ( n, 0xff );
+    std::size_t expectedRejected = 0;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	float const * const v = values[ ( i * 7 ) % numValues ];
+	sand[i] = v[0];
+	clay[i] = v[1];
+	ompc[i] = v[2];
+	expectedRejected += ( v[3] != 0.0f );
+    }
+    std::size_t const rejected = SWCharEst::GetBatch(
+	n, &sand[0], &clay[0], &ompc[0], &wp[0], &fc[0], &thetaS[0], &ks[0], &status[0] );
+    bool passed = ( rejected == expectedRejected ) &&
+		  ( SWCharEst::GetBatch( n, &sand[0], &clay[0], &ompc[0],
+					 &wp[0], &fc[0], &thetaS[0], &ks[0], 0 ) == rejected );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	float const * const v = values[ ( i * 7 ) % numValues ];
+	passed = passed &&
+		 status[i] == static_cast<unsigned char>( v[3] ) &&
+		 status[i] == SWCharEst::Status( sand[i], clay[i], ompc[i] );
+	if ( status[i] != 0 )
+	    passed = passed && wp[i] == 0.0f && fc[i] == 0.0f &&
+		     thetaS[i] == 0.0f && ks[i] == 0.0f;
+    }
+    return passed;
+}
+
+void TestStatus ()
+{
+    SWCharEst::BatchKernel const kernels[] = {
+	SWCharEst::KernelPortable, SWCharEst::KernelAVX2, SWCharEst::KernelAVX512 };
+    for ( int i = 0; i < 3; ++i )
+    {
+	if ( !SWCharEst::SetBatchKernel( kernels[i] ) )
+	    continue;
+	cout << "Test: SWCharEst::GetBatch input status with kernel "
+	     << SWCharEst::KernelName( kernels[i] ) << endl;
+	if ( CheckStatus() )
+	    cout << "  passed" << endl;
+	else
+	    cout << "  failed" << endl;
+    }
+    SWCharEst::SetBatchKernel( SWCharEst::KernelAuto );
+}
+
+// GetBatch with compaction equals GetBatch without, bitwise.
+bool CheckCompaction ()
+{
+    float const nan = std::numeric_limits<float>::quiet_NaN();
+    // more than one chunk, with runs of invalid soils, and odd length
+    std::size_t const n = 1500 + 7;
+    std::vector<float> sand (n), clay (n), ompc (n);
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	sand[i] = ( i % 89 ) / 100.0f;
+	clay[i] = ( i % 67 ) / 100.0f;		// some sand + clay > 1
+	ompc[i] = ( i % 13 ) * 0.5f;
+	if ( i % 11 == 0 )
+	    ompc[i] = -1.0f;
+	if ( i % 17 == 0 )
+	    sand[i] = nan;
+	if ( i >= 600 && i < 900 )		// a chunk with most soils invalid
+	    clay[i] = 2.0f;
+    }
+    std::size_t const bytes = n * sizeof(float);
+    std::vector<float> wp0 (n), fc0 (n), thetaS0 (n), ks0 (n);
+    std::vector<unsigned char> status0 (n);
+    SWCharEst::SetCompactionThreshold( 2.0f );		// never
+    std::size_t const rejected0 = SWCharEst::GetBatch( n, &sand[0], &clay[0], &ompc[0],
+	&wp0[0], &fc0[0], &thetaS0[0], &ks0[0], &status0[0] );
+    bool passed = rejected0 > 0;
+    for ( float const threshold : { 0.0f, 0.25f, 0.9f } )
+    {
+	SWCharEst::SetCompactionThreshold( threshold );
+	std::vector<float> wp (n, 1.0f), fc (n, 1.0f), thetaS (n, 1.0f), ks (n, 1.0f);
+	std::vector<unsigned char> status ( n, 0xff );
+	std::size_t const rejected = SWCharEst::GetBatch( n, &sand[0], &clay[0], &ompc[0],
+	    &wp[0], &fc[0], &thetaS[0], &ks[0], &status[0] );
+	passed = passed && rejected == rejected0 &&
+		 SWCharEst::GetCompactionThreshold() == threshold &&
+		 std::memcmp( &wp[0], &wp0[0], bytes ) == 0 &&
+		 std::memcmp( &fc[0], &fc0[0], bytes ) == 0 &&
+		 std::memcmp( &thetaS[0], &thetaS0[0], bytes ) == 0 &&
+		 std::memcmp( &ks[0], &ks0[0], bytes ) == 0 &&
+		 status == status0;
+    }
+    SWCharEst::SetCompactionThreshold( SWCharEst::defaultCompactionThreshold );
+    return passed;
+}
+
+void TestCompaction ()
+{
+    SWCharEst::BatchKernel const kernels[] = {
+	SWCharEst::KernelPortable, SWCharEst::KernelAVX2, SWCharEst::KernelAVX512 };
+    for ( int i = 0; i < 3; ++i )
+    {
+	if ( !SWCharEst::SetBatchKernel( kernels[i] ) )
+	    continue;
+	cout << "Test: SWCharEst::GetBatch compaction with kernel "
+	     << SWCharEst::KernelName( kernels[i] ) << endl;
+	if ( CheckCompaction() )
+	    cout << "  passed" << endl;
+	else
+	    cout << "  failed" << endl;
+    }
+    SWCharEst::SetBatchKernel( SWCharEst::KernelAuto );
+}
+
 int main ()
 {
     SWCharEst::Usage();
     Test1();
     Test2();
+    TestEvaluate();
+    TestEvaluateDouble();
+    TestEvaluateFast();
+    TestBatch();
+    TestKernels();
+    TestStatus();
+    TestCompaction();
     return 0;
 }
@@ -0,0 +1,212 @@
+// file:	Test_SWCharEstAggregate.cpp
+// 		Test of class teh::SWCharEstAggregate
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstAggregate Test_SWCharEstAggregate.cpp
+//	    ../src/SWCharEstAggregate.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp
+//	    ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstAggregate
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "SWCharEstAggregate.h"
+#include "SWCharEst.h"
+using teh::SWCharEst;
+using teh::SWCharEstAggregate;
+typedef SWCharEstAggregate::MapUnit MapUnit;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+inline bool AreClose ( double const a, double const b )
+{
+    return std::fabs( a - b ) <= 1e-6 * std::max( std::fabs( a ), std::fabs( b ) );
+}
+
+// Component rows of map units with 1 to 5 components,
+// some invalid, some with comppct 0.
+struct Components
+{
+    std::vector<int32_t> mukey;
+    std::vector<float> comppct, sand, clay, ompc;
+
+    Components ( std::size_t const numMapUnits )
+    {
+	for ( std::size_t u = 0; u < numMapUnits; ++u )
+	    for ( std::size_t k = 0; k < 1 + u % 5; ++k )
+	    {
+		std::size_t const i = mukey.size();
+		mukey.push_back( static_cast<int32_t>( 100 + u * 3 ) );
+		comppct.push_back( ( i % 13 == 0 ) ? 0.0f : 5.0f + ( i % 7 ) * 10.0f );
+		sand.push_back( ( i % 89 ) / 100.0f );
+		clay.push_back( ( i % 53 ) / 100.0f );	// some sand + clay > 1
+		ompc.push_back( ( i % 11 ) * 0.5f );
+	    }
+    }
+
+    std::size_t Size () const { return mukey.size(); }
+
+    // component-weighted means, from one soil at a time, in two passes
+    std::vector<MapUnit> Expected () const
+    {
+	std::vector<MapUnit> mapUnits;
+	for ( std::size_t first = 0; first < Size(); )
+	{
+	    std::size_t last = first;
+	    while ( last < Size() && mukey[last] == mukey[first] )
+		++last;
+	    double weight = 0.0, ksWeight = 0.0, logKsWeight = 0.0;
+	    MapUnit m = { mukey[first], unsigned( last - first ), 0, 0.0,
+			  0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	    for ( std::size_t i = first; i < last; ++i )
+	    {
+		if ( SWCharEst::Status( sand[i], clay[i], ompc[i] ) == 0 && comppct[i] > 0.0f )
+		{
+		    weight += comppct[i];
+		    float r[4];
+		    SWCharEst::GetBatch( 1, &sand[i], &clay[i], &ompc[i], &r[0], &r[1], &r[2], &r[3] );
+		    if ( std::isfinite( r[3] ) )
+			ksWeight += comppct[i];
+		    if ( r[3] > 0.0f )
+			logKsWeight += comppct[i];
+		    ++m.numValid;
+		}
+	    }
+	    double wp = 0.0, fc = 0.0, thetaS = 0.0, ks = 0.0, logKs = 0.0;
+	    for ( std::size_t i = first; i < last; ++i )
+	    {
+		if ( SWCharEst::Status( sand[i], clay[i], ompc[i] ) != 0 || !( comppct[i] > 0.0f ) )
+		    continue;
+		float r[4];
+		SWCharEst::GetBatch( 1, &sand[i], &clay[i], &ompc[i], &r[0], &r[1], &r[2], &r[3] );
+		double const f = comppct[i] / weight;
+		wp += f * r[0];
+		fc += f * r[1];
+		thetaS += f * r[2];
+		if ( std::isfinite( r[3] ) )
+		    ks += comppct[i] / ksWeight * r[3];
+		if ( r[3] > 0.0f )
+		    logKs += comppct[i] / logKsWeight * std::log( double( r[3] ) );
+	    }
+	    m.weight = weight;
+	    m.wp = float( wp );
+	    m.fc = float( fc );
+	    m.thetaS = float( thetaS );
+	    m.ks = float( ks );
+	    m.ksLogMean = ( logKsWeight > 0.0 ? float( std::exp( logKs ) ) : 0.0f );
+	    mapUnits.push_back( m );
+	    first = last;
+	}
+	return mapUnits;
+    }
+};
+
+bool AreEqual ( MapUnit const & a, MapUnit const & b )
+{
+    return a.mukey == b.mukey &&
+	   a.numComponents == b.numComponents && a.numValid == b.numValid &&
+	   AreClose( a.weight, b.weight ) &&
+	   AreClose( a.wp, b.wp ) && AreClose( a.fc, b.fc ) &&
+	   AreClose( a.thetaS, b.thetaS ) && AreClose( a.ks, b.ks ) &&
+	   AreClose( a.ksLogMean, b.ksLogMean );
+}
+
+bool AreEqual ( std::vector<MapUnit> const & a, std::vector<MapUnit> const & b )
+{
+    if ( a.size() != b.size() )
+	return false;
+    for ( std::size_t i = 0; i < a.size(); ++i )
+	if ( !AreEqual( a[i], b[i] ) )
+	    return false;
+    return true;
+}
+
+void TestAggregate ()
+{
+    cout << "Test: SWCharEstAggregate::Aggregate equals a two-pass calculation" << endl;
+    Components const c ( 1000 );
+    std::vector<MapUnit> const expected = c.Expected();
+    std::vector<MapUnit> const mapUnits = SWCharEstAggregate::Aggregate(
+	c.Size(), &c.mukey[0], &c.comppct[0], &c.sand[0], &c.clay[0], &c.ompc[0] );
+    bool passed = mapUnits.size() == 1000 && AreEqual( mapUnits, expected );
+    // some map units have no valid components
+    std::size_t numEmpty = 0;
+    for ( MapUnit const & m : mapUnits )
+	if ( m.numValid == 0 )
+	{
+	    ++numEmpty;
+	    passed = passed && m.wp == 0.0f && m.ks == 0.0f && m.ksLogMean == 0.0f;
+	}
+    Report( passed && numEmpty > 0 );
+}
+
+void TestChunks ()
+{
+    cout << "Test: SWCharEstAggregate::Add in chunks" << endl;
+    Components const c ( 500 );
+    std::vector<MapUnit> const expected = SWCharEstAggregate::Aggregate(
+	c.Size(), &c.mukey[0], &c.comppct[0], &c.sand[0], &c.clay[0], &c.ompc[0] );
+    bool passed = true;
+    SWCharEstAggregate aggregate;
+    for ( std::size_t chunkSize : { 1, 2, 7, 300 } )
+    {
+	std::vector<MapUnit> mapUnits;
+	std::size_t count = 0;
+	for ( std::size_t start = 0; start < c.Size(); start += chunkSize )
+	{
+	    std::size_t const m = std::min( chunkSize, c.Size() - start );
+	    count += aggregate.Add( m, &c.mukey[start], &c.comppct[start],
+				    &c.sand[start], &c.clay[start], &c.ompc[start], mapUnits );
+	}
+	count += aggregate.Finish( mapUnits );
+	passed = passed && count == mapUnits.size() && AreEqual( mapUnits, expected );
+    }
+
+    // nothing added
+    std::vector<MapUnit> none;
+    passed = passed && aggregate.Finish( none ) == 0 &&
+	     aggregate.Add( 0, 0, 0, 0, 0, 0, none ) == 0 && none.empty();
+    Report( passed );
+}
+
+void TestNaNKs ()
+{
+    cout << "Test: SWCharEstAggregate ks leaves out valid components with a NaN Ks" << endl;
+    // the first component is valid, with a NaN Ks
+    int32_t const mukey[3] = { 7, 7, 7 };
+    float const comppct[3] = { 30.0f, 50.0f, 20.0f };
+    float const sand[3] = { 0.14f, 0.40f, 0.65f };
+    float const clay[3] = { 0.86f, 0.20f, 0.10f };
+    float const ompc[3] = { 8.0f, 2.5f, 1.0f };
+    float r[3][4];
+    for ( int i = 0; i < 3; ++i )
+	SWCharEst::GetBatch( 1, &sand[i], &clay[i], &ompc[i], &r[i][0], &r[i][1], &r[i][2], &r[i][3] );
+    bool passed = SWCharEst::Status( sand[0], clay[0], ompc[0] ) == 0 &&
+		  std::isnan( r[0][3] ) && std::isfinite( r[0][1] );
+
+    std::vector<MapUnit> const mapUnits =
+	SWCharEstAggregate::Aggregate( 3, mukey, comppct, sand, clay, ompc );
+    double const ks = ( 50.0 * r[1][3] + 20.0 * r[2][3] ) / 70.0;
+    double const fc = ( 30.0 * r[0][1] + 50.0 * r[1][1] + 20.0 * r[2][1] ) / 100.0;
+    passed = passed && mapUnits.size() == 1 && mapUnits[0].numValid == 3 &&
+	     AreClose( mapUnits[0].weight, 100.0 ) && AreClose( mapUnits[0].fc, fc ) &&
+	     AreClose( mapUnits[0].ks, ks ) && std::isfinite( mapUnits[0].ksLogMean );
+    Report( passed );
+}
+
+int main ()
+{
+    TestAggregate();
+    TestChunks();
+    TestNaNKs();
+    return 0;
+}
@@ -0,0 +1,216 @@
+// file:	Test_SWCharEstCSV.cpp
+// 		Test of class teh::SWCharEstCSV
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstCSV Test_SWCharEstCSV.cpp
+//	    ../src/SWCharEstCSV.cpp ../src/SWCharEstText.cpp ../src/SWCharEst.cpp
+//	    ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+//	    ../src/MappedFile.cpp ../src/ThreadPool.cpp -pthread
+// run:
+//	./Test_SWCharEstCSV
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "SWCharEstCSV.h"
+#include "SWCharEstText.h"
+#include "SWCharEst.h"
+#include "ThreadPool.h"
+using teh::SWCharEst;
+using teh::SWCharEstCSV;
+using teh::SWCharEstText;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// Returns the output rows expected for the inputs,
+// with the results of GetBatch, written by FormatFloat.
+std::string Expected (
+    std::vector<float> const & sand,
+    std::vector<float> const & clay,
+    std::vector<float> const & ompc,
+    bool const header = true,
+    char const delimiter = ',' )
+{
+    std::size_t const n = sand.size();
+    std::vector<float> r ( 4 * n );
+    if ( n > 0 )
+	SWCharEst::GetBatch( n, &sand[0], &clay[0], &ompc[0], &r[0], &r[n], &r[2 * n], &r[3 * n] );
+    std::string s;
+    if ( header )
+	s = std::string( "wp" ) + delimiter + "fc" + delimiter + "thetaS" + delimiter + "ks\n";
+    char text[32];
+    for ( std::size_t i = 0; i < n; ++i )
+	for ( std::size_t k = 0; k < 4; ++k )
+	{
+	    s.append( text, SWCharEstText::FormatFloat( r[k * n + i], text ) );
+	    s += ( k < 3 ? delimiter : '\n' );
+	}
+    return s;
+}
+
+std::string Run ( SWCharEstCSV & csv, std::string const & input, bool & ok )
+{
+    std::istringstream is ( input );
+    std::ostringstream os;
+    ok = csv.Run( is, os );
+    return os.str();
+}
+
+void TestColumns ()
+{
+    cout << "Test: SWCharEstCSV columns by name, quotes, CR LF, bad fields" << endl;
+    std::string const input =
+	"\xEF\xBB\xBFid,\"Name\",OM, Clay ,SAND\r\n"
+	"1,\"loam, silty\",3.05,0.18,0.15\r\n"
+	"\r\n"
+	"2,\"sand\"\"y\",2.08,\"0.04\",  0.85  \r\n"
+	"3,x,abc,0.1,0.2\n"
+	"4,y,,0.1,0.2\n"
+	"5,z,1.0,0.1\n"
+	"6,w,2.5,0.3,0.3";		// no newline
+    float const nan = std::strtof( "nan", 0 );
+    std::vector<float> const sand = { 0.15f, 0.85f, nan, nan, nan, 0.3f };
+    std::vector<float> const clay = { 0.18f, 0.04f, 0.1f, 0.1f, 0.1f, 0.3f };
+    std::vector<float> const ompc = { 3.05f, 2.08f, nan, nan, 1.0f, 2.5f };
+    SWCharEstCSV csv;
+    bool ok;
+    std::string const output = Run( csv, input, ok );
+    Report( ok && output == Expected( sand, clay, ompc ) &&
+	    csv.NumRows() == 6 && csv.NumInvalid() == 3 );
+}
+
+void TestNumbers ()
+{
+    cout << "Test: SWCharEstCSV columns by number, tabs, no header" << endl;
+    std::string const input =
+	"0.15\t0.18\t3.05\n"
+	"0.85\t0.04\t2.08\n";
+    SWCharEstCSV csv ( "1", "2", "3", '\t', false );
+    bool ok;
+    std::string const output = Run( csv, input, ok );
+    std::vector<float> const sand = { 0.15f, 0.85f }, clay = { 0.18f, 0.04f }, ompc = { 3.05f, 2.08f };
+    bool passed = ok && output == Expected( sand, clay, ompc, false, '\t' );
+
+    // names without a header
+    SWCharEstCSV names ( "sand", "2", "3", '\t', false );
+    passed = passed && Run( names, input, ok ).empty() && !ok &&
+	     !names.ErrorMessage().empty();
+
+    // a name not in the header
+    SWCharEstCSV missing ( "sand", "clay", "ompc" );
+    std::string const noOutput = Run( missing, "sand,clay,om\n0.1,0.2,1\n", ok );
+    passed = passed && !ok && noOutput.empty() &&
+	     missing.ErrorMessage().find( "ompc" ) != std::string::npos;
+
+    // empty input
+    SWCharEstCSV empty;
+    passed = passed && Run( empty, "", ok ).empty() && ok && empty.NumRows() == 0;
+    Report( passed );
+}
+
+void TestLarge ()
+{
+    cout << "Test: SWCharEstCSV many rows, results read back exactly" << endl;
+    std::size_t const n = 100000;	// more than one read and one batch
+    std::vector<float> sand ( n ), clay ( n ), ompc ( n );
+    std::string input = "sand,clay,om,notes\n";
+    char text[128];
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	sand[i] = ( i % 89 ) / 100.0f;
+	clay[i] = ( i % 53 ) / 100.0f;
+	ompc[i] = ( i % 11 ) * 0.5f;
+	std::snprintf( text, sizeof(text), "%.9g,%.9g,%.9g,row %u\n",
+		       sand[i], clay[i], ompc[i], unsigned( i ) );
+	input += text;
+    }
+    SWCharEstCSV csv;
+    bool ok;
+    std::string const output = Run( csv, input, ok );
+    bool passed = ok && output == Expected( sand, clay, ompc ) && csv.NumRows() == n;
+
+    // the formatted results are the same floats
+    std::istringstream is ( output );
+    std::string line;
+    std::getline( is, line );
+    std::vector<float> r ( 4 );
+    SWCharEst::GetBatch( 1, &sand[7], &clay[7], &ompc[7], &r[0], &r[1], &r[2], &r[3] );
+    for ( std::size_t i = 0; i <= 7; ++i )
+	std::getline( is, line );
+    char * p = &line[0];
+    for ( std::size_t k = 0; k < 4; ++k )
+    {
+	passed = passed && std::strtof( p, &p ) == r[k];
+	++p;
+    }
+    Report( passed );
+}
+
+void TestFile ()
+{
+    cout << "Test: SWCharEstCSV::RunFile in parallel chunks equals Run" << endl;
+    char const * const fileName = "Test_SWCharEstCSV.csv";
+    std::string input = "\r\nid,\"Sand\",clay,om\r\n";
+    char text[128];
+    for ( std::size_t i = 0; i < 200000; ++i )	// several chunks
+    {
+	std::snprintf( text, sizeof(text), "%u,\"%.4g\",%.3g,%.3g\r\n%s",
+		       unsigned( i ), ( i % 89 ) / 100.0, ( i % 53 ) / 100.0, ( i % 11 ) * 0.5,
+		       ( i % 1000 == 0 ? "\n" : "" ) );
+	input += text;
+    }
+    input += "x,0.3,0.3,2.5";		// no newline
+    {
+	std::ofstream file ( fileName, std::ios::binary );
+	file << input;
+    }
+
+    SWCharEstCSV csv;
+    bool ok;
+    std::string const expected = Run( csv, input, ok );
+    bool passed = ok && csv.NumRows() == 200001;
+    for ( unsigned const numThreads : { 1u, 3u } )
+    {
+	teh::ThreadPool pool ( numThreads );
+	SWCharEstCSV parallel;
+	std::ostringstream os;
+	passed = passed && parallel.RunFile( fileName, os, pool ) &&
+		 os.str() == expected &&
+		 parallel.NumRows() == csv.NumRows() &&
+		 parallel.NumInvalid() == csv.NumInvalid();
+    }
+
+    // header only, and a missing file
+    {
+	std::ofstream file ( fileName, std::ios::binary );
+	file << "sand,clay,om\n";
+    }
+    teh::ThreadPool pool ( 2 );
+    std::ostringstream os;
+    passed = passed && csv.RunFile( fileName, os, pool ) &&
+	     os.str() == "wp,fc,thetaS,ks\n" && csv.NumRows() == 0;
+    std::remove( fileName );
+    passed = passed && !csv.RunFile( fileName, os, pool ) &&
+	     !csv.ErrorMessage().empty();
+    Report( passed );
+}
+
+int main ()
+{
+    TestColumns();
+    TestNumbers();
+    TestLarge();
+    TestFile();
+    return 0;
+}
@@ -0,0 +1,183 @@
+// file:	Test_SWCharEstConstexpr.cpp
+// 		Test of class teh::SWCharEstConstexpr
+// build:
+//	g++ -std=c++14 -g -Wall -I../src -o Test_SWCharEstConstexpr Test_SWCharEstConstexpr.cpp
+//	    ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstConstexpr
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <vector>
+#include <cmath>
+#include "SWCharEstConstexpr.h"
+using teh::SWCharEst;
+using teh::SWCharEstConstexpr;
+
+// calculated by the compiler
+constexpr SWCharEst::Results sandResults = SWCharEstConstexpr::Evaluate( 0.85f, 0.04f, 2.08f );
+constexpr SWCharEstConstexpr::TextureClassTable textureClasses = SWCharEstConstexpr::TextureClasses();
+static_assert( sandResults.WP > 0.0399f && sandResults.WP < 0.0401f, "constexpr WP" );
+static_assert( textureClasses[4].props.FC > 0.30f && textureClasses[4].props.FC < 0.32f, "constexpr FC" );
+
+//	Returns true if fabs(a-b) / a <= threshold (a != 0)
+//	or if fabs(a-b) / b <= threshold (b != 0)
+//	or true if a = b = 0.
+template
+<
+    typename T	///< floating-point type
+>
+inline bool AreClose (
+	T const a, T const b, T const threshold )
+{
+	bool result = true;
+	if ( 1.0f + (a - b) - 1.0f != 0.0f )
+	{
+		if ( a != 0.0f )
+		    result = (std::fabs ((a - b) / a) <= threshold);
+		else if ( b != 0.0f )
+		    result = (std::fabs ((a - b) / b) <= threshold);
+	}
+	return result;
+}
+
+void DisplaySWCharEst (
+    char const * const name,
+    SWCharEst::Results const & values )
+{
+    cout << "  " << name << ": WP, FC, thetaS, Ks = "
+	 << values.WP << ", "
+	 << values.FC << ", "
+	 << values.thetaS << ", "
+	 << values.Ks << endl;
+}
+
+void Compare (
+    SWCharEst::Results const & expected,
+    SWCharEst::Results const & results)
+{
+    bool passed = AreClose( expected.WP, results.WP, 1.0e-4f ) &&
+		  AreClose( expected.FC, results.FC, 1.0e-4f ) &&
+		  AreClose( expected.thetaS, results.thetaS, 1.0e-4f ) &&
+		  AreClose( expected.Ks, results.Ks, 1.0e-3f );
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestMath ()
+{
+    cout << "Test: SWCharEstConstexpr::Log, Exp, Pow" << endl;
+    bool passed = true;
+    for ( double x = 1.0e-6; x < 1.0e6; x *= 1.37 )
+	passed = passed && AreClose( std::log(x), SWCharEstConstexpr::Log(x), 1.0e-14 );
+    for ( double x = -80.0; x < 80.0; x += 0.173 )
+	passed = passed && AreClose( std::exp(x), SWCharEstConstexpr::Exp(x), 1.0e-14 );
+    for ( double x = 0.001; x < 1.0; x += 0.0137 )
+	for ( double y = 2.0; y < 3.0; y += 0.093 )
+	    passed = passed && AreClose( std::pow(x, y), SWCharEstConstexpr::Pow(x, y), 1.0e-13 );
+    passed = passed && std::isnan( SWCharEstConstexpr::Log(-1.0) ) &&
+	     SWCharEstConstexpr::Pow( 0.0, 2.5 ) == 0.0;
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestEvaluate ()
+{
+    cout << "Test: constexpr SWCharEstConstexpr::Evaluate( 0.85, 0.04, 2.08 )" << endl;
+    SWCharEst::Results const expected = SWCharEst::Evaluate( 0.85f, 0.04f, 2.08f );
+    DisplaySWCharEst( "expected", expected );
+    DisplaySWCharEst( "results ", sandResults );
+    Compare( expected, sandResults );
+
+    cout << "Test: SWCharEstConstexpr::Evaluate over the texture triangle" << endl;
+    bool passed = true;
+    for ( int iSand = 0; iSand <= 100; ++iSand )
+	for ( int iClay = 0; iSand + iClay <= 100; ++iClay )
+	    for ( float om = 0.0f; om <= 8.0f; om += 0.5f )
+	    {
+		float const sand = 0.01f * iSand;
+		float const clay = 0.01f * iClay;
+		SWCharEst::Results const a = SWCharEst::Evaluate( sand, clay, om );
+		SWCharEst::Results const b = SWCharEstConstexpr::Evaluate( sand, clay, om );
+		passed = passed &&
+			 AreClose( a.WP, b.WP, 1.0e-6f ) &&
+			 AreClose( a.FC, b.FC, 1.0e-6f ) &&
+			 AreClose( a.thetaS, b.thetaS, 1.0e-6f ) &&
+			 ( ( std::isnan(a.Ks) && std::isnan(b.Ks) ) ||
+			   AreClose( a.Ks, b.Ks, 1.0e-6f ) );
+	    }
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+bool AreCloseDouble ( double const a, double const b )
+{
+    return ( std::isnan(a) && std::isnan(b) ) ||
+	   std::fabs( a - b ) <= 1.0e-12 * std::fabs( a );
+}
+
+void TestEvaluateDouble ()
+{
+    cout << "Test: SWCharEstConstexpr::Evaluate<double> vs. SWCharEst::Evaluate<double>" << endl;
+    bool passed = true;
+    for ( int iSand = 0; iSand <= 100; iSand += 2 )
+	for ( int iClay = 0; iSand + iClay <= 100; iClay += 2 )
+	    for ( double om = 0.0; om <= 8.0; om += 0.5 )
+	    {
+		double const sand = 0.01 * iSand;
+		double const clay = 0.01 * iClay;
+		SWCharEst::TResults<double> const a = SWCharEst::Evaluate( sand, clay, om );
+		SWCharEst::TResults<double> const b = SWCharEstConstexpr::Evaluate( sand, clay, om );
+		passed = passed &&
+			 AreCloseDouble( a.WP, b.WP ) &&
+			 AreCloseDouble( a.FC, b.FC ) &&
+			 AreCloseDouble( a.thetaS, b.thetaS ) &&
+			 AreCloseDouble( a.Ks, b.Ks );
+	    }
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestTextureClasses ()
+{
+    // Saxton & Rawls (2006), table 3, OM = 2.5%
+    float const WP[]     = {  5,  5,  8, 14, 11,  6, 17, 22, 22, 27, 25, 30 };	// volume %
+    float const FC[]     = { 10, 12, 18, 28, 31, 30, 27, 36, 38, 41, 36, 42 };	// volume %
+    float const thetaS[] = { 46, 46, 45, 46, 48, 48, 43, 48, 51, 52, 44, 50 };	// volume %
+    float const Ks[]     = { 108.1f, 96.7f, 50.3f, 15.5f, 16.1f, 22.0f,
+			     11.3f, 4.3f, 5.7f, 3.7f, 1.4f, 1.1f };		// mm/hour
+
+    cout << "Test: constexpr SWCharEstConstexpr::TextureClasses vs. Saxton & Rawls table 3" << endl;
+    bool passed = true;
+    for ( std::size_t i = 0; i < SWCharEstConstexpr::numTextureClasses; ++i )
+    {
+	SWCharEst::Results const & p = textureClasses[i].props;
+	passed = passed &&
+		 std::round( p.WP * 100.0f ) == WP[i] &&
+		 std::round( p.FC * 100.0f ) == FC[i] &&
+		 std::round( p.thetaS * 100.0f ) == thetaS[i] &&
+		 std::fabs( std::round( p.Ks * 360000.0f ) / 10.0f - Ks[i] ) < 0.01f;
+    }
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+int main ()
+{
+    TestMath();
+    TestEvaluate();
+    TestEvaluateDouble();
+    TestTextureClasses();
+    return 0;
+}
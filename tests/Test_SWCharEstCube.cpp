@@ -0,0 +1,169 @@
+// file:	Test_SWCharEstCube.cpp
+// 		Test of class teh::SWCharEstCube
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstCube Test_SWCharEstCube.cpp
+//	    ../src/SWCharEstCube.cpp ../src/SWCharEstProfile.cpp ../src/SWCharEst.cpp
+//	    ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstCube
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "SWCharEstCube.h"
+#include "SWCharEstProfile.h"
+#include "SWCharEst.h"
+using teh::SWCharEst;
+using teh::SWCharEstCube;
+using teh::SWCharEstProfile;
+typedef SWCharEstCube::Interval Interval;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+inline bool AreClose ( double const a, double const b )
+{
+    return std::fabs( a - b ) <= 1e-5 * std::max( 1.0, std::max( std::fabs( a ), std::fabs( b ) ) );
+}
+
+// A depth-major cube of numPixels by 6 SoilGrids depths,
+// and its pixel-major transpose; some soils are invalid.
+struct Cube
+{
+    std::size_t const numPixels, numDepths;
+    std::vector<float> sand, clay, ompc;		// depth-major
+    std::vector<float> sandP, clayP, ompcP;		// pixel-major
+
+    Cube ( std::size_t const N )
+	: numPixels (N), numDepths (6),
+	  sand (N * 6), clay (N * 6), ompc (N * 6),
+	  sandP (N * 6), clayP (N * 6), ompcP (N * 6)
+    {
+	for ( std::size_t d = 0; d < numDepths; ++d )
+	    for ( std::size_t p = 0; p < N; ++p )
+	    {
+		std::size_t const i = d * N + p;
+		std::size_t const j = p * numDepths + d;
+		sandP[j] = sand[i] = ( ( p + 7 * d ) % 89 ) / 100.0f;
+		clayP[j] = clay[i] = ( ( p + 3 * d ) % 53 ) / 100.0f;	// some sand + clay > 1
+		ompcP[j] = ompc[i] = ( ( p + d ) % 11 ) * 0.5f;
+	    }
+    }
+
+    std::size_t Size () const { return sand.size(); }
+};
+
+struct Results
+{
+    std::vector<float> wp, fc, thetaS, ks, awc;
+
+    Results ( std::size_t const size, std::size_t const awcSize )
+	: wp (size), fc (size), thetaS (size), ks (size), awc (awcSize, -1.0f)
+    {
+    }
+};
+
+void TestDepthMajor ()
+{
+    cout << "Test: SWCharEstCube::Evaluate, DepthMajor, equals SWCharEstProfile" << endl;
+    std::size_t const N = 1000;
+    Cube const c ( N );
+    Interval const intervals[] = { { 0.0f, 30.0f }, { 0.0f, 100.0f }, { 10.0f, 70.0f } };
+    std::vector<Interval> const depthIntervals ( intervals, intervals + 3 );
+    SWCharEstCube const cube ( SWCharEstCube::SoilGridsDepths(), depthIntervals );
+    Results r ( c.Size(), 3 * N );
+    cube.Evaluate( SWCharEstCube::DepthMajor, N, &c.sand[0], &c.clay[0], &c.ompc[0],
+		   &r.wp[0], &r.fc[0], &r.thetaS[0], &r.ks[0], &r.awc[0] );
+
+    // profiles with the SoilGrids thicknesses
+    float const thicknesses[] = { 5.0f, 10.0f, 15.0f, 30.0f, 40.0f, 100.0f };
+    std::vector<float> thickness ( c.Size() );
+    for ( std::size_t d = 0; d < c.numDepths; ++d )
+	std::fill( thickness.begin() + d * N, thickness.begin() + ( d + 1 ) * N, thicknesses[d] );
+    Results e ( c.Size(), 3 * N );
+    SWCharEstProfile const profile ( depthIntervals );
+    profile.Evaluate( N, c.numDepths, &thickness[0], &c.sand[0], &c.clay[0], &c.ompc[0],
+		      &e.wp[0], &e.fc[0], &e.thetaS[0], &e.ks[0], &e.awc[0] );
+
+    bool passed = cube.NumDepths() == 6 && r.wp == e.wp && r.fc == e.fc &&
+		  r.thetaS == e.thetaS && r.ks == e.ks;
+    for ( std::size_t i = 0; i < r.awc.size(); ++i )
+	passed = passed && AreClose( r.awc[i], e.awc[i] );
+    Report( passed );
+}
+
+void TestPixelMajor ()
+{
+    cout << "Test: SWCharEstCube::Evaluate, PixelMajor, equals DepthMajor" << endl;
+    std::size_t const N = 777;
+    Cube const c ( N );
+    SWCharEstCube const cube;
+    std::size_t const numIntervals = cube.Intervals().size();
+    Results d ( c.Size(), numIntervals * N );
+    cube.Evaluate( SWCharEstCube::DepthMajor, N, &c.sand[0], &c.clay[0], &c.ompc[0],
+		   &d.wp[0], &d.fc[0], &d.thetaS[0], &d.ks[0], &d.awc[0] );
+    Results p ( c.Size(), numIntervals * N );
+    cube.Evaluate( SWCharEstCube::PixelMajor, N, &c.sandP[0], &c.clayP[0], &c.ompcP[0],
+		   &p.wp[0], &p.fc[0], &p.thetaS[0], &p.ks[0], &p.awc[0] );
+
+    bool passed = numIntervals == 2;
+    bool someNonzero = false;
+    for ( std::size_t px = 0; px < N; ++px )
+    {
+	for ( std::size_t k = 0; k < c.numDepths; ++k )
+	{
+	    std::size_t const i = k * N + px;
+	    std::size_t const j = px * c.numDepths + k;
+	    passed = passed && d.wp[i] == p.wp[j] && d.fc[i] == p.fc[j] &&
+		     d.thetaS[i] == p.thetaS[j] && d.ks[i] == p.ks[j];
+	}
+	for ( std::size_t k = 0; k < numIntervals; ++k )
+	    passed = passed && AreClose( d.awc[k * N + px], p.awc[px * numIntervals + k] );
+	someNonzero = someNonzero || p.awc[px * numIntervals + 1] > 0.0f;
+    }
+    Report( passed && someNonzero );
+}
+
+void TestNoAWC ()
+{
+    cout << "Test: SWCharEstCube::Evaluate without AWC" << endl;
+    std::size_t const N = 300;
+    Cube const c ( N );
+    std::vector<float> bounds ( 1, 0.0f );
+    bounds.push_back( 10.0f );
+    bounds.push_back( 30.0f );
+    SWCharEstCube const cube ( bounds );	// first 2 of the 6 depths
+    Results r ( c.Size(), 0 );
+    cube.Evaluate( SWCharEstCube::DepthMajor, 3 * N, &c.sand[0], &c.clay[0], &c.ompc[0],
+		   &r.wp[0], &r.fc[0], &r.thetaS[0], &r.ks[0] );
+    Results e ( c.Size(), 0 );
+    SWCharEst::GetBatch( c.Size(), &c.sand[0], &c.clay[0], &c.ompc[0],
+			 &e.wp[0], &e.fc[0], &e.thetaS[0], &e.ks[0] );
+    bool passed = cube.NumDepths() == 2 && r.wp == e.wp && r.ks == e.ks;
+    cube.Evaluate( SWCharEstCube::PixelMajor, 3 * N, &c.sandP[0], &c.clayP[0], &c.ompcP[0],
+		   &r.wp[0], &r.fc[0], &r.thetaS[0], &r.ks[0] );
+    SWCharEst::GetBatch( c.Size(), &c.sandP[0], &c.clayP[0], &c.ompcP[0],
+			 &e.wp[0], &e.fc[0], &e.thetaS[0], &e.ks[0] );
+    passed = passed && r.fc == e.fc && r.thetaS == e.thetaS;
+
+    // no depths
+    SWCharEstCube const empty ( std::vector<float>( 1, 0.0f ) );
+    empty.Evaluate( SWCharEstCube::DepthMajor, N, 0, 0, 0, 0, 0, 0, 0, 0 );
+    Report( passed && empty.NumDepths() == 0 );
+}
+
+int main ()
+{
+    TestDepthMajor();
+    TestPixelMajor();
+    TestNoAWC();
+    return 0;
+}
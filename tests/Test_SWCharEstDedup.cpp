@@ -0,0 +1,115 @@
+// file:	Test_SWCharEstDedup.cpp
+// 		Test of class teh::SWCharEstDedup
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstDedup Test_SWCharEstDedup.cpp
+//	    ../src/SWCharEstDedup.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp
+//	    ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstDedup
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "SWCharEstDedup.h"
+#include "SWCharEst.h"
+using teh::SWCharEst;
+using teh::SWCharEstDedup;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// n soils from numUnique triples, some invalid or NaN
+struct Soils
+{
+    std::vector<float> sand, clay, ompc;
+
+    Soils ( std::size_t const n, std::size_t const numUnique )
+    : sand (n), clay (n), ompc (n)
+    {
+	float const nan = std::numeric_limits<float>::quiet_NaN();
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    std::size_t const u = ( i * 7919 ) % numUnique;
+	    sand[i] = ( u % 97 ) / 100.0f;
+	    clay[i] = ( u / 97 % 61 ) / 100.0f;	// some sand + clay > 1
+	    ompc[i] = ( u / ( 97 * 61 ) ) * 0.25f;
+	    if ( u % 101 == 5 )
+		sand[i] = nan;
+	}
+    }
+};
+
+void TestEvaluate ()
+{
+    cout << "Test: SWCharEstDedup::Evaluate equals SWCharEst::GetBatch" << endl;
+    std::size_t const n = 200003;
+    bool passed = true;
+    SWCharEstDedup dedup ( 16 );		// so that the table grows
+    for ( std::size_t numUnique : { std::size_t(1), std::size_t(500), std::size_t(20000) } )
+    {
+	Soils const soils ( n, numUnique );
+	std::vector<float> wp0 (n), fc0 (n), thetaS0 (n), ks0 (n);
+	SWCharEst::GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+			     &wp0[0], &fc0[0], &thetaS0[0], &ks0[0] );
+	std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+	dedup.Evaluate( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+			&wp[0], &fc[0], &thetaS[0], &ks[0] );
+	std::size_t const bytes = n * sizeof(float);
+	// bitwise, so that NaN Ks compare equal
+	passed = passed &&
+		 std::memcmp( &wp[0], &wp0[0], bytes ) == 0 &&
+		 std::memcmp( &fc[0], &fc0[0], bytes ) == 0 &&
+		 std::memcmp( &thetaS[0], &thetaS0[0], bytes ) == 0 &&
+		 std::memcmp( &ks[0], &ks0[0], bytes ) == 0 &&
+		 dedup.NumInputs() == n && dedup.NumUnique() == numUnique &&
+		 dedup.DedupRatio() == double(n) / double(numUnique);
+	cout << "  " << numUnique << " unique: dedup ratio " << dedup.DedupRatio() << endl;
+    }
+    Report( passed );
+}
+
+void TestBuild ()
+{
+    cout << "Test: SWCharEstDedup::Build" << endl;
+    float const sand[] = { 0.3f, 0.4f, 0.3f, 0.3f, -0.0f, 0.0f, 0.4f };
+    float const clay[] = { 0.2f, 0.2f, 0.2f, 0.2f, 0.1f, 0.1f, 0.2f };
+    float const ompc[] = { 2.0f, 2.0f, 2.0f, 3.0f, 1.0f, 1.0f, 2.0f };
+    uint32_t const expected[] = { 0, 1, 0, 2, 3, 4, 1 };	// -0 and 0 differ in bits
+    std::size_t const n = sizeof(sand) / sizeof(sand[0]);
+    SWCharEstDedup dedup;
+    uint32_t index[n];
+    bool passed = dedup.Build( n, sand, clay, ompc, index ) == 5 &&
+		  std::memcmp( index, expected, sizeof(index) ) == 0 &&
+		  dedup.UniqueSand()[2] == 0.3f && dedup.UniqueOM()[2] == 3.0f;
+    dedup.EvaluateUnique();
+    float wp[n], fc[n], thetaS[n], ks[n];
+    dedup.Gather( n, index, wp, fc, thetaS, ks );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	float r[4];
+	SWCharEst::GetBatch( 1, &sand[i], &clay[i], &ompc[i], &r[0], &r[1], &r[2], &r[3] );
+	passed = passed && dedup.UniqueWP().size() == 5 &&
+		 wp[i] == r[0] && fc[i] == r[1] && thetaS[i] == r[2] && ks[i] == r[3];
+    }
+
+    // empty input
+    passed = passed && dedup.Build( 0, 0, 0, 0, 0 ) == 0 &&
+	     dedup.NumUnique() == 0 && dedup.DedupRatio() == 0.0;
+    dedup.EvaluateUnique();
+    Report( passed );
+}
+
+int main ()
+{
+    TestEvaluate();
+    TestBuild();
+    return 0;
+}
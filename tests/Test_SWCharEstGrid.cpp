@@ -0,0 +1,153 @@
+// file:	Test_SWCharEstGrid.cpp
+// 		Test of class teh::SWCharEstGrid
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstGrid Test_SWCharEstGrid.cpp
+//	    ../src/SWCharEstGrid.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstGrid
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "SWCharEstGrid.h"
+using teh::SWCharEst;
+using teh::SWCharEstGrid;
+
+//	Returns true if fabs(a-b) / a <= threshold (a != 0)
+//	or if fabs(a-b) / b <= threshold (b != 0)
+//	or true if a = b = 0.
+template
+<
+    typename T	///< floating-point type
+>
+inline bool AreClose (
+	T const a, T const b, T const threshold )
+{
+	bool result = true;
+	if ( 1.0f + (a - b) - 1.0f != 0.0f )
+	{
+		if ( a != 0.0f )
+		    result = (std::fabs ((a - b) / a) <= threshold);
+		else if ( b != 0.0f )
+		    result = (std::fabs ((a - b) / b) <= threshold);
+	}
+	return result;
+}
+
+bool AreEqual (
+    SWCharEst::Results const & a,
+    SWCharEst::Results const & b )
+{
+    // bitwise, so that NaN Ks compare equal
+    return std::memcmp( &a, &b, sizeof(a) ) == 0;
+}
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestErrorReport ( SWCharEstGrid const & grid )
+{
+    cout << "Test: SWCharEstGrid error report" << endl;
+    grid.WriteErrors( cout );
+    SWCharEstGrid::ErrorReport const & e = grid.Errors();
+    SWCharEstGrid const coarse ( 21, 9, 8.0f );
+    bool const passed =
+	e.numPoints > 1000000 &&
+	// the regressions are interpolated exactly
+	e.WP.maxRel < 1.0e-5f && e.FC.maxRel < 1.0e-5f && e.thetaS.maxRel < 1.0e-5f &&
+	e.Ks.maxAbs > 0.0f && e.Ks.maxAbs < 5.0e-4f &&
+	coarse.Errors().Ks.maxAbs > e.Ks.maxAbs &&
+	coarse.MemorySize() < grid.MemorySize();
+    Report( passed );
+}
+
+void TestInterpolation ( SWCharEstGrid const & grid )
+{
+    cout << "Test: SWCharEstGrid::Get vs. SWCharEst::Evaluate" << endl;
+    // points which are not the error report points
+    float const ksLimit = 2.0f * grid.Errors().Ks.maxAbs;
+    bool passed = true;
+    int numInterpolated = 0;
+    for ( int i = 0; i < 300; ++i )
+	for ( int j = 0; i + j < 300; ++j )
+	    for ( float om = 0.13f; om < 8.0f; om += 0.61f )
+	    {
+		float const sand = ( i + 0.29f ) / 300.0f;
+		float const clay = ( j + 0.71f ) / 300.0f;
+		SWCharEst::Results const a = grid.Get( sand, clay, om );
+		SWCharEst::Results const e = SWCharEst::Evaluate( sand, clay, om );
+		if ( !grid.IsInterpolated( sand, clay, om ) )
+		{
+		    passed = passed && AreEqual( a, e );
+		    continue;
+		}
+		++numInterpolated;
+		passed = passed &&
+			 AreClose( e.WP, a.WP, 1.0e-5f ) &&
+			 AreClose( e.FC, a.FC, 1.0e-5f ) &&
+			 AreClose( e.thetaS, a.thetaS, 1.0e-5f ) &&
+			 std::fabs( e.Ks - a.Ks ) <= ksLimit;
+	    }
+    passed = passed && numInterpolated > 400000;
+    Report( passed );
+}
+
+void TestNotInterpolated ( SWCharEstGrid const & grid )
+{
+    cout << "Test: SWCharEstGrid::Get outside of the grid, and invalid arguments" << endl;
+    SWCharEst::Results const zeros = { 0.0f, 0.0f, 0.0f, 0.0f };
+    bool const passed =
+	grid.IsInterpolated( 0.153f, 0.184f, 3.05f ) &&
+	!grid.IsInterpolated( 0.153f, 0.184f, 20.0f ) &&	// OM > grid
+	!grid.IsInterpolated( 0.503f, 0.495f, 3.05f ) &&	// cell crosses sand + clay = 1
+	AreEqual( grid.Get( 0.153f, 0.184f, 20.0f ),
+		  SWCharEst::Evaluate( 0.153f, 0.184f, 20.0f ) ) &&
+	AreEqual( grid.Get( 0.503f, 0.495f, 3.05f ),
+		  SWCharEst::Evaluate( 0.503f, 0.495f, 3.05f ) ) &&
+	AreEqual( grid.Get( 0.6f, 0.5f, 2.0f ), zeros ) &&
+	AreEqual( grid.Get( -0.1f, 0.5f, 2.0f ), zeros ) &&
+	AreEqual( grid.Get( 0.1f, 0.5f, -2.0f ), zeros ) &&
+	!grid.IsInterpolated( NAN, 0.5f, 2.0f );
+    Report( passed );
+}
+
+void TestBatch ( SWCharEstGrid const & grid )
+{
+    cout << "Test: SWCharEstGrid::GetBatch" << endl;
+    std::vector<float> sand, clay, ompc;
+    for ( int i = 0; i <= 100; i += 3 )
+	for ( int j = 0; i + j <= 100; j += 7 )
+	{
+	    sand.push_back( i / 101.0f );
+	    clay.push_back( j / 101.0f );
+	    ompc.push_back( 0.1f * ( i % 90 ) );
+	}
+    std::size_t const n = sand.size();
+    std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+    grid.GetBatch( n, &sand[0], &clay[0], &ompc[0], &wp[0], &fc[0], &thetaS[0], &ks[0] );
+    bool passed = true;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	SWCharEst::Results const r = { wp[i], fc[i], thetaS[i], ks[i] };
+	passed = passed && AreEqual( r, grid.Get( sand[i], clay[i], ompc[i] ) );
+    }
+    Report( passed );
+}
+
+int main ()
+{
+    SWCharEstGrid const grid;
+    TestErrorReport( grid );
+    TestInterpolation( grid );
+    TestNotInterpolated( grid );
+    TestBatch( grid );
+    return 0;
+}
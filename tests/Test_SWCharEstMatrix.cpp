@@ -0,0 +1,149 @@
+// file:	Test_SWCharEstMatrix.cpp
+// 		Test of class teh::SWCharEstMatrix
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstMatrix Test_SWCharEstMatrix.cpp
+//	    ../src/SWCharEstMatrix.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp
+// run:
+//	./Test_SWCharEstMatrix
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cmath>
+#include <vector>
+#include "SWCharEst.h"
+#include "SWCharEstMatrix.h"
+using teh::SWCharEst;
+using teh::SWCharEstMatrix;
+
+//	Returns true if fabs(a-b) / a <= threshold (a != 0)
+//	or if fabs(a-b) / b <= threshold (b != 0)
+//	or true if a = b = 0, or both are NaN.
+inline bool AreCloseOrNaN (
+	float const a, float const b, float const threshold )
+{
+	if ( std::isnan(a) || std::isnan(b) )
+	    return std::isnan(a) && std::isnan(b);
+	bool result = true;
+	if ( a != b )
+	{
+		if ( a != 0.0f )
+		    result = (std::fabs ((a - b) / a) <= threshold);
+		else
+		    result = (std::fabs ((a - b) / b) <= threshold);
+	}
+	return result;
+}
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// sand, clay and OM which include the micro-kernel tails
+void MakeSoils (
+    std::vector<float> & sand,
+    std::vector<float> & clay,
+    std::vector<float> & ompc )
+{
+    for ( int i = 0; i <= 100; i += 3 )
+	for ( int j = 0; i + j <= 100; j += 4 )
+	    for ( float const om : { 0.0f, 1.7f, 5.0f, 12.0f } )
+	    {
+		sand.push_back( i / 100.0f );
+		clay.push_back( j / 100.0f );
+		ompc.push_back( om );
+	    }
+    sand.push_back( 0.3f );	// odd number of soils
+    clay.push_back( 0.2f );
+    ompc.push_back( 2.0f );
+}
+
+void TestRegressions ()
+{
+    cout << "Test: SWCharEstMatrix::Regressions vs. the sums in double" << endl;
+    std::vector<float> sand, clay, ompc;
+    MakeSoils( sand, clay, ompc );
+    std::size_t const n = sand.size();
+    std::size_t const ld = n + 3;	// row strides larger than n
+    std::vector<float> basis ( SWCharEstMatrix::numBasisTerms * ld );
+    std::vector<float> regressions ( SWCharEstMatrix::numRegressions * ld );
+    SWCharEstMatrix::Basis( n, &sand[0], &clay[0], &ompc[0], &basis[0], ld );
+    SWCharEstMatrix::Regressions( n, &basis[0], ld, &regressions[0], ld );
+    bool passed = true;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	double const s = sand[i], c = clay[i], om = ompc[i];
+	double const terms[SWCharEstMatrix::numBasisTerms] =
+	    { s, c, om, s * om, c * om, s * c, 1.0 };
+	for ( int r = 0; r < SWCharEstMatrix::numRegressions; ++r )
+	{
+	    double sum = 0.0;
+	    for ( int k = 0; k < SWCharEstMatrix::numBasisTerms; ++k )
+		sum += SWCharEstMatrix::coefficients[r][k] * terms[k];
+	    passed = passed &&
+		     std::fabs( regressions[r * ld + i] - sum ) <= 1.0e-6 * ( 1.0 + std::fabs(sum) );
+	}
+    }
+    Report( passed );
+}
+
+void TestBasisOMLimit ()
+{
+    cout << "Test: SWCharEstMatrix::Basis limits OM to 70%" << endl;
+    float const sand = 0.2f, clay = 0.3f, ompc = 85.0f;
+    float basis[SWCharEstMatrix::numBasisTerms];
+    SWCharEstMatrix::Basis( 1, &sand, &clay, &ompc, basis, 1 );
+    Report( basis[SWCharEstMatrix::BasisOM] == 70.0f &&
+	    basis[SWCharEstMatrix::BasisSandOM] == sand * 70.0f &&
+	    basis[SWCharEstMatrix::BasisOne] == 1.0f );
+}
+
+void TestGetBatch ()
+{
+    cout << "Test: SWCharEstMatrix::GetBatch vs. SWCharEst::Evaluate" << endl;
+    std::vector<float> sand, clay, ompc;
+    MakeSoils( sand, clay, ompc );
+    // invalid soils in the middle of a block
+    float const badSand[] = { 0.6f, -0.1f, 0.1f, 0.2f };
+    float const badClay[] = { 0.5f, 0.5f, 1.1f, 0.2f };
+    float const badOM[] = { 2.0f, 2.0f, 2.0f, -1.0f };
+    for ( int k = 0; k < 4; ++k )
+    {
+	sand.insert( sand.begin() + 100 + k, badSand[k] );
+	clay.insert( clay.begin() + 100 + k, badClay[k] );
+	ompc.insert( ompc.begin() + 100 + k, badOM[k] );
+    }
+    std::size_t const n = sand.size();
+    std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+    SWCharEstMatrix::GetBatch( n, &sand[0], &clay[0], &ompc[0],
+			       &wp[0], &fc[0], &thetaS[0], &ks[0] );
+    bool passed = true;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	SWCharEst::Results const r = SWCharEst::Evaluate( sand[i], clay[i], ompc[i] );
+	bool const ok = AreCloseOrNaN( wp[i], r.WP, 1.0e-5f ) &&
+			AreCloseOrNaN( fc[i], r.FC, 1.0e-5f ) &&
+			AreCloseOrNaN( thetaS[i], r.thetaS, 1.0e-5f ) &&
+			AreCloseOrNaN( ks[i], r.Ks, 1.0e-4f );
+	if ( !ok )
+	    cout << "  sand, clay, om = " << sand[i] << ", " << clay[i] << ", " << ompc[i]
+		 << ": Ks = " << ks[i] << ", expected " << r.Ks << endl;
+	passed = passed && ok;
+    }
+    for ( int k = 0; k < 4; ++k )
+	passed = passed && wp[100 + k] == 0.0f && fc[100 + k] == 0.0f &&
+		 thetaS[100 + k] == 0.0f && ks[100 + k] == 0.0f;
+    Report( passed );
+}
+
+int main ()
+{
+    TestRegressions();
+    TestBasisOMLimit();
+    TestGetBatch();
+    return 0;
+}
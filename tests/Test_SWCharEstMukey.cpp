@@ -0,0 +1,154 @@
+// file:	Test_SWCharEstMukey.cpp
+// 		Test of class teh::SWCharEstMukey
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstMukey Test_SWCharEstMukey.cpp
+//	    ../src/SWCharEstMukey.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp
+//	    ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstMukey
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstring>
+#include <vector>
+#include "SWCharEstMukey.h"
+#include "SWCharEst.h"
+using teh::SWCharEst;
+using teh::SWCharEstMukey;
+
+float const nodata = -9999.0f;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// A table of map units, and a raster of their keys with runs,
+// scattered cells, and unknown keys.
+struct MapUnits
+{
+    std::vector<int32_t> keys;
+    std::vector<float> sand, clay, ompc;
+    std::vector<int32_t> cellKeys;
+
+    MapUnits ( std::size_t const numKeys,
+	       int32_t const firstKey,
+	       int32_t const keyStep,
+	       std::size_t const numCells )
+    : keys (numKeys), sand (numKeys), clay (numKeys), ompc (numKeys),
+      cellKeys (numCells)
+    {
+	for ( std::size_t r = 0; r < numKeys; ++r )
+	{
+	    keys[r] = firstKey + static_cast<int32_t>( r ) * keyStep;
+	    sand[r] = ( r % 89 ) / 100.0f;
+	    clay[r] = ( r % 53 ) / 100.0f;	// some sand + clay > 1
+	    ompc[r] = ( r % 11 ) * 0.5f;
+	}
+	for ( std::size_t i = 0; i < numCells; ++i )
+	{
+	    std::size_t const r = ( i / 7 * 131 + ( i % 3 == 0 ? i : 0 ) ) % numKeys;
+	    cellKeys[i] = keys[r];
+	    if ( i % 101 == 0 )
+		cellKeys[i] = firstKey - 1;		// unknown
+	}
+    }
+
+    // expected results, from SWCharEst::GetBatch on each cell
+    void Expected (
+	std::vector<float> & wp, std::vector<float> & fc,
+	std::vector<float> & thetaS, std::vector<float> & ks ) const
+    {
+	for ( std::size_t i = 0; i < cellKeys.size(); ++i )
+	{
+	    std::size_t r = 0;
+	    while ( r < keys.size() && keys[r] != cellKeys[i] )
+		++r;
+	    if ( r == keys.size() )
+	    {
+		wp[i] = fc[i] = thetaS[i] = ks[i] = nodata;
+		continue;
+	    }
+	    SWCharEst::GetBatch( 1, &sand[r], &clay[r], &ompc[r], &wp[i], &fc[i], &thetaS[i], &ks[i] );
+	}
+    }
+};
+
+void TestJoin ()
+{
+    cout << "Test: SWCharEstMukey::Join equals SWCharEst::GetBatch" << endl;
+    bool passed = true;
+    // dense keys, sparse keys (hash table), and negative keys
+    int32_t const steps[] = { 1, 1000003, -3 };
+    bool const isDirect[] = { true, false, true };
+    for ( int k = 0; k < 3; ++k )
+    {
+	std::size_t const numCells = 5003;
+	MapUnits const units ( 300, ( steps[k] < 0 ? 1000 : 17 ), steps[k], numCells );
+	SWCharEstMukey table ( units.keys.size(), &units.keys[0],
+			       &units.sand[0], &units.clay[0], &units.ompc[0], nodata );
+	passed = passed && table.IsDirect() == isDirect[k] &&
+		 table.Find( units.keys[5] ) == 5 && table.Find( -123456 ) == table.NumKeys();
+	std::vector<float> wp0 (numCells), fc0 (numCells), thetaS0 (numCells), ks0 (numCells);
+	units.Expected( wp0, fc0, thetaS0, ks0 );
+
+	// with streaming and without, at aligned and unaligned offsets
+	for ( bool const streaming : { true, false } )
+	    for ( std::size_t offset : { 0, 1, 3 } )
+	    {
+		table.SetStreaming( streaming );
+		std::size_t const n = numCells - offset;
+		std::vector<float> wp (numCells), fc (numCells), thetaS (numCells), ks (numCells);
+		std::size_t const found = table.Join( n, &units.cellKeys[offset],
+						      &wp[offset], &fc[offset],
+						      &thetaS[offset], &ks[offset] );
+		std::size_t const bytes = n * sizeof(float);
+		std::size_t expectedFound = 0;
+		for ( std::size_t i = offset; i < numCells; ++i )
+		    expectedFound += ( wp0[i] != nodata );
+		// bitwise, so that NaN Ks compare equal
+		passed = passed && found == expectedFound &&
+			 std::memcmp( &wp[offset], &wp0[offset], bytes ) == 0 &&
+			 std::memcmp( &fc[offset], &fc0[offset], bytes ) == 0 &&
+			 std::memcmp( &thetaS[offset], &thetaS0[offset], bytes ) == 0 &&
+			 std::memcmp( &ks[offset], &ks0[offset], bytes ) == 0;
+	    }
+    }
+    Report( passed );
+}
+
+void TestTableEdges ()
+{
+    cout << "Test: SWCharEstMukey with an empty table and repeated keys" << endl;
+    int32_t const cellKeys[] = { 1, 2, 3 };
+    float wp[3], fc[3], thetaS[3], ks[3];
+    SWCharEstMukey const empty ( 0, 0, 0, 0, 0 );
+    bool passed = empty.Join( 3, cellKeys, wp, fc, thetaS, ks ) == 0 &&
+		  wp[0] == nodata && ks[2] == nodata && empty.Find( 1 ) == 0;
+
+    // the first row of a repeated key is used
+    int32_t const keys[] = { 2, 2 };
+    float const sand[] = { 0.3f, 0.6f };
+    float const clay[] = { 0.2f, 0.1f };
+    float const ompc[] = { 2.0f, 1.0f };
+    SWCharEstMukey const repeated ( 2, keys, sand, clay, ompc );
+    float expected[4];
+    SWCharEst::GetBatch( 1, sand, clay, ompc, &expected[0], &expected[1], &expected[2], &expected[3] );
+    passed = passed && repeated.Join( 3, cellKeys, wp, fc, thetaS, ks ) == 1 &&
+	     repeated.Find( 2 ) == 0 &&
+	     wp[1] == expected[0] && fc[1] == expected[1] &&
+	     thetaS[1] == expected[2] && ks[1] == expected[3] &&
+	     wp[0] == repeated.Nodata() && wp[2] == repeated.Nodata();
+    Report( passed );
+}
+
+int main ()
+{
+    TestJoin();
+    TestTableEdges();
+    return 0;
+}
@@ -0,0 +1,281 @@
+// file:	Test_SWCharEstNpy.cpp
+// 		Test of class teh::SWCharEstNpy
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstNpy Test_SWCharEstNpy.cpp
+//	    ../src/SWCharEstNpy.cpp ../src/MappedFile.cpp ../src/SWCharEst.cpp
+//	    ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstNpy
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "SWCharEstNpy.h"
+#include "SWCharEst.h"
+using teh::SWCharEst;
+using teh::SWCharEstNpy;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+bool LittleEndian ()
+{
+    uint16_t const one = 1;
+    return *reinterpret_cast<unsigned char const *>( &one ) == 1;
+}
+
+// .npy file contents, as written by numpy, of the values as float32
+// or float64, in either byte order
+std::string Npy (
+    std::vector<float> const & values,
+    std::string const & descr,		// such as "<f4"
+    std::string const & shape,		// such as "(10,)"
+    bool const fortranOrder = false )
+{
+    std::string header = "{'descr': '" + descr + "', 'fortran_order': " +
+			 ( fortranOrder ? "True" : "False" ) + ", 'shape': " + shape + ", }";
+    header.append( 63 - ( 10 + header.size() ) % 64, ' ' );
+    header += '\n';
+    std::string s = "\x93NUMPY";
+    s += char( 1 );
+    s += char( 0 );
+    s += char( header.size() & 0xFF );
+    s += char( header.size() >> 8 );
+    s += header;
+    bool const swap = ( descr[0] == ( LittleEndian() ? '>' : '<' ) );
+    for ( float const f : values )
+    {
+	char bytes[8];
+	std::size_t const size = ( descr[2] == '4' ? 4 : 8 );
+	if ( size == 4 )
+	    std::memcpy( bytes, &f, 4 );
+	else
+	{
+	    double const d = f;
+	    std::memcpy( bytes, &d, 8 );
+	}
+	for ( std::size_t i = 0; i < size; ++i )
+	    s += bytes[swap ? size - 1 - i : i];
+    }
+    return s;
+}
+
+void WriteFile ( std::string const & fileName, std::string const & contents )
+{
+    std::ofstream os ( fileName.c_str(), std::ios::binary );
+    os << contents;
+}
+
+std::string ReadFile ( std::string const & fileName )
+{
+    std::ifstream is ( fileName.c_str(), std::ios::binary );
+    std::ostringstream os;
+    os << is.rdbuf();
+    return os.str();
+}
+
+// zip file of stored members, as written by numpy.savez
+std::string Zip (
+    std::vector<std::string> const & names,
+    std::vector<std::string> const & members,
+    uint16_t const method = 0 )
+{
+    auto const Put = [] ( std::string & s, uint32_t v, int n )
+    {
+	for ( int i = 0; i < n; ++i, v >>= 8 )
+	    s += char( v & 0xFF );
+    };
+    std::string zip, directory;
+    for ( std::size_t i = 0; i < names.size(); ++i )
+    {
+	uint32_t crc = 0xFFFFFFFF;
+	for ( char const c : members[i] )
+	{
+	    crc ^= static_cast<unsigned char>( c );
+	    for ( int b = 0; b < 8; ++b )
+		crc = ( crc >> 1 ) ^ ( 0xEDB88320 & ( 0 - ( crc & 1 ) ) );
+	}
+	crc = ~crc;
+	uint32_t const offset = uint32_t( zip.size() );
+	uint32_t const size = uint32_t( members[i].size() );
+	Put( zip, 0x04034b50, 4 ); Put( zip, 20, 2 ); Put( zip, 0, 2 ); Put( zip, method, 2 );
+	Put( zip, 0, 4 ); Put( zip, crc, 4 ); Put( zip, size, 4 ); Put( zip, size, 4 );
+	Put( zip, uint32_t( names[i].size() ), 2 ); Put( zip, 0, 2 );
+	zip += names[i] + members[i];
+	Put( directory, 0x02014b50, 4 ); Put( directory, 20, 2 ); Put( directory, 20, 2 );
+	Put( directory, 0, 2 ); Put( directory, method, 2 ); Put( directory, 0, 4 );
+	Put( directory, crc, 4 ); Put( directory, size, 4 ); Put( directory, size, 4 );
+	Put( directory, uint32_t( names[i].size() ), 2 ); Put( directory, 0, 2 ); Put( directory, 0, 2 );
+	Put( directory, 0, 2 ); Put( directory, 0, 2 ); Put( directory, 0, 4 ); Put( directory, offset, 4 );
+	directory += names[i];
+    }
+    uint32_t const directoryOffset = uint32_t( zip.size() );
+    zip += directory;
+    Put( zip, 0x06054b50, 4 ); Put( zip, 0, 4 );
+    Put( zip, uint32_t( names.size() ), 2 ); Put( zip, uint32_t( names.size() ), 2 );
+    Put( zip, uint32_t( directory.size() ), 4 ); Put( zip, directoryOffset, 4 ); Put( zip, 0, 2 );
+    return zip;
+}
+
+struct Soils
+{
+    std::vector<float> sand, clay, ompc;
+    std::vector<float> r;		// wp, fc, thetaS, ks arrays
+
+    explicit Soils ( std::size_t const n )
+	: sand ( n ), clay ( n ), ompc ( n ), r ( 4 * n )
+    {
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    sand[i] = ( i % 97 ) / 100.0f;
+	    clay[i] = ( i % 61 ) / 100.0f;
+	    ompc[i] = ( i % 13 ) * 0.5f;
+	}
+	SWCharEst::GetBatch( n, &sand[0], &clay[0], &ompc[0], &r[0], &r[n], &r[2 * n], &r[3 * n] );
+    }
+};
+
+// true if the file has the header and the float32 values
+bool HasContents (
+    std::string const & fileName,
+    std::string const & header,		// part of the header text
+    std::vector<float> const & values )
+{
+    std::string const s = ReadFile( fileName );
+    if ( s.size() < 10 || s.compare( 0, 6, "\x93NUMPY" ) != 0 )
+	return false;
+    std::size_t const offset = 10 + static_cast<unsigned char>( s[8] ) +
+			       256 * static_cast<unsigned char>( s[9] );
+    if ( offset % 64 != 0 || s.substr( 10, offset - 10 ).find( header ) == std::string::npos ||
+	 s.size() != offset + 4 * values.size() )
+	return false;
+    return values.empty() ||
+	   std::memcmp( &s[offset], &values[0], 4 * values.size() ) == 0;
+}
+
+void TestNpy ()
+{
+    cout << "Test: SWCharEstNpy float32 .npy in place, structured and separate outputs" << endl;
+    std::size_t const n = 100003;	// more than one block
+    Soils const soils ( n );
+    std::string const order = ( LittleEndian() ? "<f4" : ">f4" );
+    WriteFile( "Test_sand.npy", Npy( soils.sand, order, "(100003,)" ) );
+    WriteFile( "Test_clay.npy", Npy( soils.clay, order, "(100003,)" ) );
+    WriteFile( "Test_om.npy", Npy( soils.ompc, order, "(100003,)" ) );
+
+    SWCharEstNpy structured;
+    bool passed = structured.Run( "Test_sand.npy", "Test_clay.npy", "Test_om.npy", "Test_results.npy" ) &&
+		  structured.ZeroCopy() && structured.NumElements() == n;
+    std::vector<float> records ( 4 * n );
+    for ( std::size_t i = 0; i < n; ++i )
+	for ( std::size_t k = 0; k < 4; ++k )
+	    records[4 * i + k] = soils.r[k * n + i];
+    std::string const descr = "'descr': [('wp', '" + order + "'), ('fc', '" + order +
+			      "'), ('thetaS', '" + order + "'), ('ks', '" + order + "')]";
+    passed = passed && HasContents( "Test_results.npy", descr, records ) &&
+	     HasContents( "Test_results.npy", "'shape': (100003,)", records );
+
+    SWCharEstNpy separate ( SWCharEstNpy::Separate );
+    passed = passed && separate.Run( "Test_sand.npy", "Test_clay.npy", "Test_om.npy", "Test_" ) &&
+	     separate.ZeroCopy();
+    char const * const names[4] = { "Test_wp.npy", "Test_fc.npy", "Test_thetaS.npy", "Test_ks.npy" };
+    for ( std::size_t k = 0; k < 4; ++k )
+    {
+	std::vector<float> const values ( soils.r.begin() + k * n, soils.r.begin() + ( k + 1 ) * n );
+	passed = passed && HasContents( names[k], "'descr': '" + order + "'", values );
+	std::remove( names[k] );
+    }
+    std::remove( "Test_results.npy" );
+    Report( passed );
+}
+
+void TestConvert ()
+{
+    cout << "Test: SWCharEstNpy float64, other byte order, Fortran order, bad arrays" << endl;
+    std::size_t const n = 300 * 7;
+    Soils const soils ( n );
+    std::string const other = ( LittleEndian() ? ">" : "<" );
+    WriteFile( "Test_sand.npy", Npy( soils.sand, "<f8", "(300, 7)", true ) );
+    WriteFile( "Test_clay.npy", Npy( soils.clay, other + "f4", "(300, 7)", true ) );
+    WriteFile( "Test_om.npy", Npy( soils.ompc, other + "f8", "(300, 7)", true ) );
+    SWCharEstNpy npy ( SWCharEstNpy::Separate );
+    bool passed = npy.Run( "Test_sand.npy", "Test_clay.npy", "Test_om.npy", "Test_" ) &&
+		  !npy.ZeroCopy() && npy.NumElements() == n;
+    std::vector<float> const wp ( soils.r.begin(), soils.r.begin() + n );
+    passed = passed && HasContents( "Test_wp.npy", "'fortran_order': True, 'shape': (300, 7)", wp );
+    char const * const names[4] = { "Test_wp.npy", "Test_fc.npy", "Test_thetaS.npy", "Test_ks.npy" };
+    for ( char const * name : names )
+	std::remove( name );
+
+    // a different shape, an integer dtype, a missing file
+    WriteFile( "Test_om.npy", Npy( soils.ompc, "<f8", "(7, 300)", true ) );
+    passed = passed && !npy.Run( "Test_sand.npy", "Test_clay.npy", "Test_om.npy", "Test_" ) &&
+	     npy.ErrorMessage().find( "shape" ) != std::string::npos;
+    WriteFile( "Test_om.npy", Npy( soils.ompc, "<i4", "(300, 7)", true ) );
+    passed = passed && !npy.Run( "Test_sand.npy", "Test_clay.npy", "Test_om.npy", "Test_" ) &&
+	     npy.ErrorMessage().find( "i4" ) != std::string::npos;
+    std::remove( "Test_om.npy" );
+    passed = passed && !npy.Run( "Test_sand.npy", "Test_clay.npy", "Test_om.npy", "Test_" ) &&
+	     npy.ErrorMessage().find( "Test_om.npy" ) != std::string::npos;
+
+    // truncated data
+    std::string const sand = Npy( soils.sand, "<f8", "(300, 7)", true );
+    SWCharEstNpy::Array array;
+    std::string message;
+    passed = passed && SWCharEstNpy::ReadArray( sand.data(), sand.size(), array, message ) &&
+	     array.numElements == n && array.shape.size() == 2 && array.itemSize == 8 &&
+	     !SWCharEstNpy::ReadArray( sand.data(), sand.size() - 1, array, message );
+    std::remove( "Test_sand.npy" );
+    std::remove( "Test_clay.npy" );
+    Report( passed );
+}
+
+void TestNpz ()
+{
+    cout << "Test: SWCharEstNpy .npz of stored arrays" << endl;
+    std::size_t const n = 5000;
+    Soils const soils ( n );
+    std::vector<std::string> const names = { "id.npy", "om.npy", "clay.npy", "sand.npy" };
+    std::vector<std::string> const members = {
+	Npy( soils.sand, "<f8", "(5000,)" ), Npy( soils.ompc, "<f4", "(5000,)" ),
+	Npy( soils.clay, "<f4", "(5000,)" ), Npy( soils.sand, ">f4", "(5000,)" ) };
+    WriteFile( "Test_soils.npz", Zip( names, members ) );
+    SWCharEstNpy npy;
+    std::vector<float> records ( 4 * n );
+    for ( std::size_t i = 0; i < n; ++i )
+	for ( std::size_t k = 0; k < 4; ++k )
+	    records[4 * i + k] = soils.r[k * n + i];
+    bool passed = npy.RunNpz( "Test_soils.npz", "Test_results.npy" ) &&
+		  npy.NumElements() == n && HasContents( "Test_results.npy", "(5000,)", records );
+
+    // compressed, or without an array
+    WriteFile( "Test_soils.npz", Zip( names, members, 8 ) );
+    passed = passed && !npy.RunNpz( "Test_soils.npz", "Test_results.npy" ) &&
+	     npy.ErrorMessage().find( "compressed" ) != std::string::npos;
+    WriteFile( "Test_soils.npz", Zip( { "sand.npy", "clay.npy" }, { members[3], members[2] } ) );
+    passed = passed && !npy.RunNpz( "Test_soils.npz", "Test_results.npy" ) &&
+	     npy.ErrorMessage().find( "om.npy" ) != std::string::npos;
+    std::remove( "Test_soils.npz" );
+    std::remove( "Test_results.npy" );
+    Report( passed );
+}
+
+int main ()
+{
+    TestNpy();
+    TestConvert();
+    TestNpz();
+    return 0;
+}
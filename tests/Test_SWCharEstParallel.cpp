@@ -0,0 +1,188 @@
+// file:	Test_SWCharEstParallel.cpp
+// 		Test of classes teh::SWCharEstParallel and teh::ThreadPool
+// build:
+//	g++ -std=c++11 -g -Wall -pthread -I../src -o Test_SWCharEstParallel Test_SWCharEstParallel.cpp
+//	    ../src/SWCharEstParallel.cpp ../src/ThreadPool.cpp ../src/SWCharEst.cpp
+//	    ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstParallel
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "SWCharEstParallel.h"
+#include "SWCharEstMatrix.h"
+using teh::SWCharEst;
+using teh::SWCharEstParallel;
+using teh::ThreadPool;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+struct Soils
+{
+    std::vector<float> sand, clay, ompc;
+
+    Soils ( std::size_t const n )
+    : sand (n), clay (n), ompc (n)
+    {
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    sand[i] = ( i % 97 ) / 100.0f;
+	    clay[i] = ( i % 61 ) / 100.0f;	// some invalid, sand + clay > 1
+	    ompc[i] = ( i % 23 ) * 0.35f;
+	}
+    }
+};
+
+struct Outputs
+{
+    std::vector<float> wp, fc, thetaS, ks;
+
+    Outputs ( std::size_t const n )
+    : wp (n), fc (n), thetaS (n), ks (n)
+    {
+    }
+
+    // bitwise, so that NaN Ks compare equal
+    bool operator== ( Outputs const & o ) const
+    {
+	std::size_t const bytes = wp.size() * sizeof(float);
+	return std::memcmp( &wp[0], &o.wp[0], bytes ) == 0 &&
+	       std::memcmp( &fc[0], &o.fc[0], bytes ) == 0 &&
+	       std::memcmp( &thetaS[0], &o.thetaS[0], bytes ) == 0 &&
+	       std::memcmp( &ks[0], &o.ks[0], bytes ) == 0;
+    }
+};
+
+void TestThreadPool ()
+{
+    cout << "Test: ThreadPool::Run calls each task once" << endl;
+    ThreadPool pool ( 4 );
+    bool passed = pool.NumThreads() == 4;
+    for ( std::size_t numTasks : { 0, 1, 3, 1000 } )
+    {
+	std::vector< std::atomic<int> > count ( numTasks );
+	for ( std::atomic<int> & c : count )
+	    c.store( 0 );
+	pool.Run( numTasks, [&count] ( std::size_t i, unsigned worker )
+	{
+	    if ( worker < 4 )
+		++count[i];
+	} );
+	for ( std::atomic<int> const & c : count )
+	    passed = passed && c.load() == 1;
+    }
+    Report( passed );
+}
+
+void TestThreadPoolException ()
+{
+    cout << "Test: ThreadPool::Run rethrows an exception from a task" << endl;
+    ThreadPool pool ( 3 );
+    bool caught = false;
+    try
+    {
+	pool.Run( 100, [] ( std::size_t i, unsigned )
+	{
+	    if ( i == 42 )
+		throw std::runtime_error( "task 42" );
+	} );
+    }
+    catch ( std::runtime_error const & e )
+    {
+	caught = std::strcmp( e.what(), "task 42" ) == 0;
+    }
+    // the pool is still usable
+    std::atomic<int> count ( 0 );
+    pool.Run( 10, [&count] ( std::size_t, unsigned ) { ++count; } );
+    Report( caught && count.load() == 10 );
+}
+
+void TestGetBatch ()
+{
+    cout << "Test: SWCharEstParallel::GetBatch equals SWCharEst::GetBatch" << endl;
+    std::size_t const n = 100003;
+    Soils const soils ( n );
+    Outputs expected ( n );
+    SWCharEst::GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+			 &expected.wp[0], &expected.fc[0], &expected.thetaS[0], &expected.ks[0] );
+    bool passed = true;
+    for ( unsigned numThreads : { 1u, 2u, 5u } )
+	for ( std::size_t chunkSize : { std::size_t(1), std::size_t(1000),
+					SWCharEstParallel::defaultChunkSize } )
+	{
+	    SWCharEstParallel parallel ( numThreads, chunkSize );
+	    Outputs out ( n );
+	    parallel.GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+			       &out.wp[0], &out.fc[0], &out.thetaS[0], &out.ks[0] );
+	    passed = passed && out == expected &&
+		     parallel.NumThreads() == numThreads &&
+		     parallel.ChunkSize() % 16 == 0 && parallel.ChunkSize() >= chunkSize;
+	}
+    SWCharEstParallel parallel ( 3 );
+    parallel.GetBatch( 0, 0, 0, 0, 0, 0, 0, 0 );	// nothing to do
+    Report( passed );
+}
+
+void TestBatchFunction ()
+{
+    cout << "Test: SWCharEstParallel::GetBatch with SWCharEstMatrix::GetBatch" << endl;
+    std::size_t const n = 20000;
+    Soils const soils ( n );
+    Outputs expected ( n ), out ( n );
+    teh::SWCharEstMatrix::GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+				   &expected.wp[0], &expected.fc[0], &expected.thetaS[0],
+				   &expected.ks[0] );
+    SWCharEstParallel parallel ( 4, 256 );
+    parallel.GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+		       &out.wp[0], &out.fc[0], &out.thetaS[0], &out.ks[0],
+		       teh::SWCharEstMatrix::GetBatch );
+    Report( out == expected );
+}
+
+void TestShared ()
+{
+    cout << "Test: SWCharEstParallel shared by threads, with SetChunkSize" << endl;
+    std::size_t const n = 20000;
+    Soils const soils ( n );
+    Outputs expected ( n );
+    SWCharEst::GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+			 &expected.wp[0], &expected.fc[0], &expected.thetaS[0], &expected.ks[0] );
+    SWCharEstParallel parallel ( 2, 1000 );
+    Outputs out1 ( n ), out2 ( n );
+    std::thread other ( [&] ()
+    {
+	for ( int i = 0; i < 20; ++i )
+	{
+	    parallel.SetChunkSize( 100 + 300 * ( i % 7 ) );
+	    parallel.GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+			       &out2.wp[0], &out2.fc[0], &out2.thetaS[0], &out2.ks[0] );
+	}
+    } );
+    for ( int i = 0; i < 20; ++i )
+	parallel.GetBatch( n, &soils.sand[0], &soils.clay[0], &soils.ompc[0],
+			   &out1.wp[0], &out1.fc[0], &out1.thetaS[0], &out1.ks[0] );
+    other.join();
+    Report( out1 == expected && out2 == expected && parallel.ChunkSize() % 16 == 0 );
+}
+
+int main ()
+{
+    TestThreadPool();
+    TestThreadPoolException();
+    TestGetBatch();
+    TestBatchFunction();
+    TestShared();
+    return 0;
+}
@@ -0,0 +1,142 @@
+// file:	Test_SWCharEstProfile.cpp
+// 		Test of class teh::SWCharEstProfile
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstProfile Test_SWCharEstProfile.cpp
+//	    ../src/SWCharEstProfile.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp
+//	    ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstProfile
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "SWCharEstProfile.h"
+#include "SWCharEst.h"
+using teh::SWCharEst;
+using teh::SWCharEstProfile;
+typedef SWCharEstProfile::Interval Interval;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+inline bool AreClose ( double const a, double const b )
+{
+    return std::fabs( a - b ) <= 1e-5 * std::max( 1.0, std::max( std::fabs( a ), std::fabs( b ) ) );
+}
+
+// Profiles of 1 to numHorizons horizons, by horizon;
+// some horizons are invalid, missing horizons have thickness 0.
+struct Profiles
+{
+    std::size_t const numProfiles, numHorizons;
+    std::vector<float> thickness, sand, clay, ompc, rootDepth;
+
+    Profiles ( std::size_t const P, std::size_t const H )
+	: numProfiles (P), numHorizons (H),
+	  thickness (P * H), sand (P * H), clay (P * H), ompc (P * H), rootDepth (P)
+    {
+	for ( std::size_t p = 0; p < P; ++p )
+	{
+	    rootDepth[p] = 10.0f + ( p % 9 ) * 15.0f;
+	    for ( std::size_t h = 0; h < H; ++h )
+	    {
+		std::size_t const i = h * P + p;
+		thickness[i] = ( h <= p % H ) ? 5.0f + ( ( p + h ) % 7 ) * 8.0f : 0.0f;
+		sand[i] = ( i % 89 ) / 100.0f;
+		clay[i] = ( i % 53 ) / 100.0f;	// some sand + clay > 1
+		ompc[i] = ( i % 11 ) * 0.5f;
+	    }
+	}
+	thickness[0] = std::numeric_limits<float>::quiet_NaN();	// absent
+    }
+
+    // AWC of profile p, in interval, one horizon at a time
+    double AWC ( std::size_t const p, Interval const & interval ) const
+    {
+	double awc = 0.0, top = 0.0;
+	for ( std::size_t h = 0; h < numHorizons; ++h )
+	{
+	    std::size_t const i = h * numProfiles + p;
+	    double const thk = ( thickness[i] > 0.0f ? thickness[i] : 0.0f );
+	    double const overlap = std::min( top + thk, double( interval.bottom ) )
+				   - std::max( top, double( interval.top ) );
+	    top += thk;
+	    if ( overlap <= 0.0 || SWCharEst::Status( sand[i], clay[i], ompc[i] ) != 0 )
+		continue;
+	    float r[4];
+	    SWCharEst::GetBatch( 1, &sand[i], &clay[i], &ompc[i], &r[0], &r[1], &r[2], &r[3] );
+	    awc += ( r[1] - r[0] ) * overlap;
+	}
+	return awc;
+    }
+};
+
+void TestEvaluate ()
+{
+    cout << "Test: SWCharEstProfile::Evaluate equals a profile-at-a-time calculation" << endl;
+    std::size_t const P = 1300, H = 6;	// more than one block
+    Profiles const s ( P, H );
+    Interval const intervals[] = { { 0.0f, 30.0f }, { 0.0f, 100.0f }, { 20.0f, 45.0f } };
+    SWCharEstProfile const profile ( std::vector<Interval>( intervals, intervals + 3 ) );
+    std::vector<float> wp (P * H), fc (P * H), thetaS (P * H), ks (P * H);
+    std::vector<float> awc (3 * P), rootAWC (P);
+    profile.Evaluate( P, H, &s.thickness[0], &s.sand[0], &s.clay[0], &s.ompc[0],
+		      &wp[0], &fc[0], &thetaS[0], &ks[0], &awc[0],
+		      &s.rootDepth[0], &rootAWC[0] );
+
+    // horizons equal GetBatch
+    std::vector<float> r (4 * P * H);
+    SWCharEst::GetBatch( P * H, &s.sand[0], &s.clay[0], &s.ompc[0],
+			 &r[0], &r[P * H], &r[2 * P * H], &r[3 * P * H] );
+    bool passed = std::equal( wp.begin(), wp.end(), r.begin() ) &&
+		  std::equal( ks.begin(), ks.end(), r.begin() + 3 * P * H );
+
+    bool someNonzero = false;
+    for ( std::size_t p = 0; p < P; ++p )
+    {
+	for ( std::size_t i = 0; i < 3; ++i )
+	    passed = passed && AreClose( awc[i * P + p], s.AWC( p, intervals[i] ) );
+	Interval const rootZone = { 0.0f, s.rootDepth[p] };
+	passed = passed && AreClose( rootAWC[p], s.AWC( p, rootZone ) );
+	someNonzero = someNonzero || awc[P + p] > 0.0f;
+    }
+    Report( passed && someNonzero );
+}
+
+void TestStandard ()
+{
+    cout << "Test: SWCharEstProfile standard intervals, without a root zone" << endl;
+    std::size_t const P = 40, H = 3;
+    Profiles const s ( P, H );
+    SWCharEstProfile const profile;
+    std::vector<float> wp (P * H), fc (P * H), thetaS (P * H), ks (P * H), awc (2 * P, -1.0f);
+    profile.Evaluate( P, H, &s.thickness[0], &s.sand[0], &s.clay[0], &s.ompc[0],
+		      &wp[0], &fc[0], &thetaS[0], &ks[0], &awc[0] );
+    bool passed = profile.Intervals().size() == 2;
+    for ( std::size_t p = 0; p < P; ++p )
+    {
+	passed = passed && AreClose( awc[p], s.AWC( p, profile.Intervals()[0] ) ) &&
+		 AreClose( awc[P + p], s.AWC( p, profile.Intervals()[1] ) ) &&
+		 awc[p] <= awc[P + p];
+    }
+
+    // no profiles
+    profile.Evaluate( 0, H, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+    Report( passed );
+}
+
+int main ()
+{
+    TestEvaluate();
+    TestStandard();
+    return 0;
+}
@@ -0,0 +1,162 @@
+// file:	Test_SWCharEstRaster.cpp
+// 		Test of class teh::SWCharEstRaster
+// build:
+//	g++ -std=c++11 -g -Wall -pthread -I../src -o Test_SWCharEstRaster Test_SWCharEstRaster.cpp
+//	    ../src/SWCharEstRaster.cpp ../src/ThreadPool.cpp ../src/SWCharEst.cpp
+//	    ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstRaster
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "SWCharEstRaster.h"
+#include "SWCharEst.h"
+using teh::SWCharEst;
+using teh::SWCharEstRaster;
+using teh::ThreadPool;
+
+float const nodata = -9999.0f;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// A raster which is mostly nodata, with a dense block in one corner,
+// scattered cells elsewhere, and some NaN inputs.
+struct TestRaster
+{
+    std::size_t rows, cols;
+    std::vector<float> sand, clay, ompc;
+    std::vector<float> wp, fc, thetaS, ks;	// expected
+    std::size_t validCells;
+
+    TestRaster ( std::size_t const numRows, std::size_t const numCols )
+    : rows ( numRows ), cols ( numCols ),
+      sand ( rows * cols, nodata ), clay ( rows * cols, nodata ), ompc ( rows * cols, nodata ),
+      wp ( rows * cols, nodata ), fc ( rows * cols, nodata ),
+      thetaS ( rows * cols, nodata ), ks ( rows * cols, nodata ),
+      validCells ( 0 )
+    {
+	for ( std::size_t r = 0; r < rows; ++r )
+	    for ( std::size_t c = 0; c < cols; ++c )
+	    {
+		std::size_t const i = r * cols + c;
+		bool const dense = ( r > rows / 2 && c > cols / 2 );
+		bool const scattered = ( i % 97 == 0 );
+		if ( !dense && !scattered )
+		    continue;
+		sand[i] = ( i % 89 ) / 100.0f;
+		clay[i] = ( i % 53 ) / 100.0f;
+		ompc[i] = ( i % 11 ) * 0.5f;
+		if ( i % 1001 == 0 )
+		    clay[i] = NAN;		// nodata
+		if ( i % 1003 == 0 )
+		    ompc[i] = nodata;
+		if ( std::isnan( clay[i] ) || ompc[i] == nodata )
+		    continue;
+		SWCharEst::GetBatch( 1, &sand[i], &clay[i], &ompc[i],
+				     &wp[i], &fc[i], &thetaS[i], &ks[i] );
+		++validCells;
+	    }
+    }
+
+    // bitwise, so that NaN Ks compare equal
+    bool Matches (
+	std::vector<float> const & outWP,
+	std::vector<float> const & outFC,
+	std::vector<float> const & outThetaS,
+	std::vector<float> const & outKs ) const
+    {
+	std::size_t const bytes = wp.size() * sizeof(float);
+	return std::memcmp( &wp[0], &outWP[0], bytes ) == 0 &&
+	       std::memcmp( &fc[0], &outFC[0], bytes ) == 0 &&
+	       std::memcmp( &thetaS[0], &outThetaS[0], bytes ) == 0 &&
+	       std::memcmp( &ks[0], &outKs[0], bytes ) == 0;
+    }
+};
+
+bool CheckReport (
+    SWCharEstRaster::Report const & report,
+    std::size_t const validCells )
+{
+    std::size_t tiles = 0, cells = 0;
+    for ( SWCharEstRaster::WorkerStats const & w : report.workers )
+    {
+	tiles += w.tiles;
+	cells += w.validCells;
+	if ( !( w.utilization >= 0.0 && w.utilization <= 1.0 ) )
+	    return false;
+    }
+    return tiles == report.numTiles && cells == validCells && report.validCells == validCells;
+}
+
+void TestSchedules ()
+{
+    cout << "Test: SWCharEstRaster::Evaluate equals SWCharEst::GetBatch" << endl;
+    TestRaster const raster ( 301, 257 );
+    std::size_t const n = raster.rows * raster.cols;
+    ThreadPool pool ( 4 );
+    bool passed = true;
+    for ( SWCharEstRaster::Schedule schedule :
+	  { SWCharEstRaster::ScheduleBalanced, SWCharEstRaster::ScheduleStatic } )
+	for ( int tileSize : { 1, 16, 64, 1000 } )
+	{
+	    SWCharEstRaster evaluator ( pool, tileSize, tileSize, schedule );
+	    std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+	    evaluator.Evaluate( raster.rows, raster.cols,
+				&raster.sand[0], &raster.clay[0], &raster.ompc[0], nodata,
+				&wp[0], &fc[0], &thetaS[0], &ks[0] );
+	    passed = passed && raster.Matches( wp, fc, thetaS, ks ) &&
+		     CheckReport( evaluator.LastReport(), raster.validCells );
+	}
+    Report( passed );
+}
+
+void TestReport ()
+{
+    cout << "Test: SWCharEstRaster::LastReport" << endl;
+    TestRaster const raster ( 200, 200 );
+    std::size_t const n = raster.rows * raster.cols;
+    ThreadPool pool ( 3 );
+    SWCharEstRaster evaluator ( pool, 32, 32 );
+    std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+    evaluator.Evaluate( raster.rows, raster.cols,
+			&raster.sand[0], &raster.clay[0], &raster.ompc[0], nodata,
+			&wp[0], &fc[0], &thetaS[0], &ks[0] );
+    SWCharEstRaster::Report const & report = evaluator.LastReport();
+    report.Write( cout );
+    bool passed = report.workers.size() == 3 && report.numTiles == 49 &&
+		  CheckReport( report, raster.validCells );
+
+    // one tile: one range, evaluated by one of the threads
+    SWCharEstRaster oneTile ( pool, 256, 256 );
+    oneTile.Evaluate( raster.rows, raster.cols,
+		      &raster.sand[0], &raster.clay[0], &raster.ompc[0], nodata,
+		      &wp[0], &fc[0], &thetaS[0], &ks[0] );
+    std::size_t busyThreads = 0;
+    for ( SWCharEstRaster::WorkerStats const & w : oneTile.LastReport().workers )
+	busyThreads += ( w.tiles > 0 );
+    passed = passed && oneTile.LastReport().workers.size() == 3 && busyThreads == 1 &&
+	     CheckReport( oneTile.LastReport(), raster.validCells );
+
+    // empty raster
+    evaluator.Evaluate( 0, 0, 0, 0, 0, nodata, 0, 0, 0, 0 );
+    passed = passed && evaluator.LastReport().numTiles == 0 &&
+	     evaluator.LastReport().validCells == 0;
+    Report( passed );
+}
+
+int main ()
+{
+    TestSchedules();
+    TestReport();
+    return 0;
+}
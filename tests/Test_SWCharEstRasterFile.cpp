@@ -0,0 +1,290 @@
+// file:	Test_SWCharEstRasterFile.cpp
+// 		Test of class teh::SWCharEstRasterFile
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstRasterFile Test_SWCharEstRasterFile.cpp
+//	    ../src/SWCharEstRasterFile.cpp ../src/SWCharEstRaster.cpp ../src/SWCharEstText.cpp
+//	    ../src/MappedFile.cpp ../src/ThreadPool.cpp ../src/SWCharEst.cpp
+//	    ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp -pthread
+// run:
+//	./Test_SWCharEstRasterFile
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "SWCharEstRasterFile.h"
+#include "SWCharEst.h"
+#include "ThreadPool.h"
+using teh::SWCharEst;
+using teh::SWCharEstRasterFile;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+bool LittleEndian ()
+{
+    uint16_t const one = 1;
+    return *reinterpret_cast<unsigned char const *>( &one ) == 1;
+}
+
+void WriteFile ( std::string const & fileName, std::string const & contents )
+{
+    std::ofstream os ( fileName.c_str(), std::ios::binary );
+    os << contents;
+}
+
+std::string ReadFile ( std::string const & fileName )
+{
+    std::ifstream is ( fileName.c_str(), std::ios::binary );
+    std::ostringstream os;
+    os << is.rdbuf();
+    return os.str();
+}
+
+char const * const names[4] = { "wp", "fc", "thetaS", "ks" };
+
+void RemoveOutputs ( std::string const & prefix, bool const ascii )
+{
+    for ( char const * name : names )
+    {
+	std::remove( ( prefix + name + ( ascii ? ".asc" : ".bsq" ) ).c_str() );
+	std::remove( ( prefix + name + ".hdr" ).c_str() );
+    }
+}
+
+// Rasters of inputs, with nodata cells, and the expected results.
+struct Rasters
+{
+    std::size_t rows, cols;
+    std::vector<float> in[3];		// sand, clay, om
+    std::vector<float> r[4];		// wp, fc, thetaS, ks
+    std::size_t numValid;
+
+    Rasters ( std::size_t const numRows, std::size_t const numCols, float const nodata )
+	: rows ( numRows ), cols ( numCols ), numValid ( 0 )
+    {
+	std::size_t const n = rows * cols;
+	for ( int k = 0; k < 3; ++k )
+	    in[k].resize( n );
+	for ( int k = 0; k < 4; ++k )
+	    r[k].resize( n );
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    in[0][i] = ( i % 7 == 3 ? nodata : ( i % 83 ) / 100.0f );
+	    in[1][i] = ( i % 11 == 5 ? nodata : ( i % 59 ) / 100.0f );
+	    in[2][i] = ( i % 13 == 2 ? nodata : ( i % 17 ) * 0.5f );
+	    bool const valid = ( in[0][i] != nodata && in[1][i] != nodata && in[2][i] != nodata );
+	    numValid += valid;
+	    if ( valid )
+		SWCharEst::GetBatch( 1, &in[0][i], &in[1][i], &in[2][i],
+				     &r[0][i], &r[1][i], &r[2][i], &r[3][i] );
+	    else
+		r[0][i] = r[1][i] = r[2][i] = r[3][i] = nodata;
+	}
+    }
+
+    // ESRI ASCII grid of input k, with lines of valuesPerLine values
+    std::string Ascii ( int const k, std::size_t const valuesPerLine ) const
+    {
+	std::ostringstream os;
+	os << "NCOLS " << cols << "\r\nnrows " << rows << "\r\n"
+	   << "xllcorner 500000.5\r\nyllcorner 4100000\r\ncellsize 30\r\nNODATA_value -9999\r\n";
+	char text[32];
+	for ( std::size_t i = 0; i < rows * cols; ++i )
+	{
+	    std::snprintf( text, sizeof(text), "%.9g", in[k][i] );
+	    os << text << ( ( i + 1 ) % valuesPerLine == 0 ? "\r\n" : " " );
+	}
+	return os.str();
+    }
+};
+
+// true if an output ASCII grid has the header and the values
+bool AsciiMatches ( std::string const & fileName, std::vector<float> const & values, std::size_t const cols )
+{
+    std::string const s = ReadFile( fileName );
+    std::size_t const data = s.find( '\n', s.find( "NODATA_value " ) );
+    std::string const ncols = "ncols " + std::to_string( cols ) + "\n";
+    if ( s.compare( 0, ncols.size(), ncols ) != 0 ||
+	 s.find( "xllcorner 500000.5\n" ) == std::string::npos || data == std::string::npos )
+	return false;
+    char const * p = s.c_str() + data + 1;
+    for ( std::size_t i = 0; i < values.size(); ++i )
+    {
+	char * end;
+	float const value = std::strtof( p, &end );
+	if ( end == p || value != values[i] || *end != ( ( i + 1 ) % cols == 0 ? '\n' : ' ' ) )
+	    return false;
+	p = end + 1;
+    }
+    return *p == '\0';
+}
+
+void TestAscii ()
+{
+    cout << "Test: SWCharEstRasterFile ESRI ASCII grids, by strips, with nodata" << endl;
+    Rasters const rasters ( 150, 37, -9999.0f );	// more than 2 strips
+    char const * const inputs[3] = { "Test_sand.asc", "Test_clay.asc", "Test_om.asc" };
+    for ( int k = 0; k < 3; ++k )
+	WriteFile( inputs[k], rasters.Ascii( k, k == 0 ? 37 : 10 + k ) );
+    teh::ThreadPool pool ( 3 );
+    SWCharEstRasterFile files ( pool );
+    bool passed = files.Run( inputs[0], inputs[1], inputs[2], "Test_" ) &&
+		  files.Rows() == 150 && files.Cols() == 37 && files.NumValid() == rasters.numValid;
+    for ( int k = 0; k < 4; ++k )
+	passed = passed && AsciiMatches( std::string( "Test_" ) + names[k] + ".asc", rasters.r[k], 37 );
+    RemoveOutputs( "Test_", true );
+
+    // too few values, a different size, a missing file
+    std::string const om = rasters.Ascii( 2, 37 );
+    WriteFile( inputs[2], om.substr( 0, om.size() - 20 ) );
+    passed = passed && !files.Run( inputs[0], inputs[1], inputs[2], "Test_" ) &&
+	     files.ErrorMessage().find( "fewer values" ) != std::string::npos;
+    Rasters const small ( 150, 36, -9999.0f );
+    WriteFile( inputs[2], small.Ascii( 2, 36 ) );
+    passed = passed && !files.Run( inputs[0], inputs[1], inputs[2], "Test_" ) &&
+	     files.ErrorMessage().find( "size" ) != std::string::npos;
+    std::remove( inputs[2] );
+    passed = passed && !files.Run( inputs[0], inputs[1], inputs[2], "Test_" ) &&
+	     files.ErrorMessage().find( inputs[2] ) != std::string::npos;
+    RemoveOutputs( "Test_", true );
+    std::remove( inputs[0] );
+    std::remove( inputs[1] );
+    Report( passed );
+}
+
+void TestNodataValues ()
+{
+    cout << "Test: SWCharEstRasterFile ASCII grids with different NODATA_value" << endl;
+    // sand nodata is 0; a clay of 0 and OM of 0 are valid
+    std::string const header =
+	"ncols 3\nnrows 2\nxllcorner 500000.5\nyllcorner 4100000\ncellsize 30\n";
+    char const * const inputs[3] = { "Test_sand.asc", "Test_clay.asc", "Test_om.asc" };
+    WriteFile( inputs[0], header + "NODATA_value 0\n0.4 0 0.3\n0.2 0.5 0.1\n" );
+    WriteFile( inputs[1], header + "NODATA_value -9999\n0.2 0.2 -9999\n0 0 0.3\n" );
+    WriteFile( inputs[2], header + "NODATA_value -1\n0 2 1\n-1 3 0\n" );
+    float const sand[3] = { 0.4f, 0.5f, 0.1f };	// cells 0, 4, 5 are valid
+    float const clay[3] = { 0.2f, 0.0f, 0.3f };
+    float const ompc[3] = { 0.0f, 3.0f, 0.0f };
+    float r[4][3];
+    SWCharEst::GetBatch( 3, sand, clay, ompc, r[0], r[1], r[2], r[3] );
+    teh::ThreadPool pool ( 2 );
+    SWCharEstRasterFile files ( pool );
+    bool passed = files.Run( inputs[0], inputs[1], inputs[2], "Test_" ) && files.NumValid() == 3;
+    for ( int k = 0; k < 4; ++k )
+    {
+	std::vector<float> expected ( 6, 0.0f );	// nodata of the sand raster
+	expected[0] = r[k][0];
+	expected[4] = r[k][1];
+	expected[5] = r[k][2];
+	passed = passed && AsciiMatches( std::string( "Test_" ) + names[k] + ".asc", expected, 3 );
+    }
+    RemoveOutputs( "Test_", true );
+    for ( int k = 0; k < 3; ++k )
+	std::remove( inputs[k] );
+    Report( passed );
+}
+
+// ENVI raster of the three inputs, in the interleave, as float32 in the
+// other byte order, or float64, after a header offset of 16 bytes
+void WriteEnvi ( Rasters const & rasters, std::string const & fileName, std::string const & interleave,
+		 bool const float64 )
+{
+    std::size_t const rows = rasters.rows, cols = rasters.cols, size = ( float64 ? 8 : 4 );
+    std::string data ( 16, 'x' );
+    for ( std::size_t a = 0; a < ( interleave == "bsq" ? 3 : rows ); ++a )
+	for ( std::size_t b = 0; b < ( interleave == "bsq" ? rows : interleave == "bil" ? 3 : cols ); ++b )
+	    for ( std::size_t c = 0; c < ( interleave == "bip" ? 3 : cols ); ++c )
+	    {
+		std::size_t const band = ( interleave == "bsq" ? a : interleave == "bil" ? b : c );
+		std::size_t const row = ( interleave == "bsq" ? b : a );
+		std::size_t const col = ( interleave == "bip" ? b : c );
+		float const f = rasters.in[band][row * cols + col];
+		char bytes[8];
+		if ( float64 )
+		{
+		    double const d = f;
+		    std::memcpy( bytes, &d, 8 );
+		}
+		else
+		{
+		    std::memcpy( bytes, &f, 4 );
+		    std::swap( bytes[0], bytes[3] );
+		    std::swap( bytes[1], bytes[2] );
+		}
+		data.append( bytes, size );
+	    }
+    WriteFile( fileName, data );
+    bool const bigEndian = ( LittleEndian() != float64 );
+    std::ostringstream header;
+    header << "ENVI\ndescription = {\n  soil inputs}\nsamples = " << cols << "\nlines   = " << rows
+	   << "\nbands = 3\nheader offset = 16\ndata type = " << ( float64 ? 5 : 4 )
+	   << "\nInterleave = " << interleave << "\nbyte order = " << ( bigEndian ? 1 : 0 )
+	   << "\ndata ignore value = -9999\nmap info = {UTM, 1, 1, 500000, 4100000, 30, 30, 13,\n North}\n";
+    WriteFile( fileName.substr( 0, fileName.size() - 4 ) + ".hdr", header.str() );
+}
+
+// true if an output ENVI raster has the values
+bool EnviMatches ( std::string const & prefix, int const k, std::vector<float> const & values )
+{
+    std::string const data = ReadFile( prefix + names[k] + ".bsq" );
+    std::string const header = ReadFile( prefix + names[k] + ".hdr" );
+    return data.size() == 4 * values.size() &&
+	   std::memcmp( data.data(), &values[0], data.size() ) == 0 &&
+	   header.find( "data type = 4\n" ) != std::string::npos &&
+	   header.find( "data ignore value = -9999\n" ) != std::string::npos &&
+	   header.find( "map info = {UTM, 1, 1, 500000, 4100000, 30, 30, 13,\n North}" ) != std::string::npos;
+}
+
+void TestEnvi ()
+{
+    cout << "Test: SWCharEstRasterFile ENVI bsq, bil and bip bands, by strips" << endl;
+    Rasters const rasters ( 130, 41, -9999.0f );
+    teh::ThreadPool pool ( 2 );
+    SWCharEstRasterFile files ( pool, 50 );
+    bool passed = true;
+    for ( char const * interleave : { "bsq", "bil", "bip" } )
+    {
+	for ( bool const float64 : { false, true } )
+	{
+	    std::string const fileName = std::string( "Test_soils." ) + interleave;
+	    WriteEnvi( rasters, fileName, interleave, float64 );
+	    passed = passed && files.RunBands( fileName, "Test_" ) &&
+		     files.NumValid() == rasters.numValid;
+	    for ( int k = 0; k < 4; ++k )
+		passed = passed && EnviMatches( "Test_", k, rasters.r[k] );
+	    RemoveOutputs( "Test_", false );
+	    std::remove( fileName.c_str() );
+	    std::remove( "Test_soils.hdr" );
+	}
+    }
+
+    // bands of an ASCII grid, a missing header
+    passed = passed && !files.RunBands( "Test_soils.asc", "Test_" );
+    WriteFile( "Test_soils.bsq", std::string( 100, '\0' ) );
+    passed = passed && !files.RunBands( "Test_soils.bsq", "Test_" ) &&
+	     files.ErrorMessage().find( "header" ) != std::string::npos;
+    std::remove( "Test_soils.bsq" );
+    Report( passed );
+}
+
+int main ()
+{
+    TestAscii();
+    TestNodataValues();
+    TestEnvi();
+    return 0;
+}
@@ -0,0 +1,156 @@
+// file:	Test_SWCharEstTable.cpp
+// 		Test of class teh::SWCharEstTable
+// build:
+//	g++ -std=c++11 -g -Wall -pthread -I../src -o Test_SWCharEstTable Test_SWCharEstTable.cpp
+//	    ../src/SWCharEstTable.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstTable
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "SWCharEstTable.h"
+using teh::SWCharEst;
+using teh::SWCharEstTable;
+
+bool AreEqual (
+    SWCharEst::Results const & a,
+    SWCharEst::Results const & b )
+{
+    // bitwise, so that NaN Ks compare equal
+    return std::memcmp( &a, &b, sizeof(a) ) == 0;
+}
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestGrid ( SWCharEstTable & table )
+{
+    cout << "Test: SWCharEstTable::Get equals SWCharEst::Evaluate on the grid" << endl;
+    float const om[] = { 0.0f, 0.1f, 2.5f, 3.1f, 8.0f, 69.9f, 70.0f, 85.0f };
+    bool passed = true;
+    for ( float const ompc : om )
+	for ( int i = 0; i <= 100; ++i )
+	    for ( int j = 0; j <= 100; ++j )
+	    {
+		float const sand = static_cast<float>(i) / 100.0f;
+		float const clay = static_cast<float>(j) / 100.0f;
+		passed = passed &&
+			 SWCharEstTable::IsOnGrid( sand, clay, ompc ) &&
+			 AreEqual( table.Get( sand, clay, ompc ),
+				   SWCharEst::Evaluate( sand, clay, ompc ) );
+	    }
+    // literals as they appear in data
+    passed = passed &&
+	     AreEqual( table.Get( 0.15f, 0.18f, 3.1f ),
+		       SWCharEst::Evaluate( 0.15f, 0.18f, 3.1f ) ) &&
+	     AreEqual( table.Lookup( 15, 18, 31 ),
+		       SWCharEst::Evaluate( 0.15f, 0.18f, 3.1f ) ) &&
+	     AreEqual( table.Lookup( 88, 5, 25 ),
+		       SWCharEst::Evaluate( 0.88f, 0.05f, 2.5f ) ) &&
+	     AreEqual( table.Lookup( 88, 5, 900 ),
+		       SWCharEst::Evaluate( 0.88f, 0.05f, 90.0f ) );
+    Report( passed );
+}
+
+void TestOffGridAndInvalid ( SWCharEstTable & table )
+{
+    cout << "Test: SWCharEstTable::Get off the grid and invalid arguments" << endl;
+    SWCharEst::Results const zeros = { 0.0f, 0.0f, 0.0f, 0.0f };
+    bool passed =
+	!SWCharEstTable::IsOnGrid( 0.155f, 0.18f, 3.1f ) &&
+	!SWCharEstTable::IsOnGrid( 0.15f, 0.18f, 3.05f ) &&
+	AreEqual( table.Get( 0.155f, 0.18f, 3.1f ),
+		  SWCharEst::Evaluate( 0.155f, 0.18f, 3.1f ) ) &&
+	AreEqual( table.Get( 0.15f, 0.18f, 3.05f ),
+		  SWCharEst::Evaluate( 0.15f, 0.18f, 3.05f ) ) &&
+	AreEqual( table.Get( 0.6f, 0.5f, 2.0f ), zeros ) &&
+	AreEqual( table.Get( -0.1f, 0.5f, 2.0f ), zeros ) &&
+	AreEqual( table.Get( 0.1f, 0.5f, -2.0f ), zeros ) &&
+	AreEqual( table.Lookup( 60, 50, 20 ), zeros ) &&
+	AreEqual( table.Lookup( 101, 0, 20 ), zeros ) &&
+	AreEqual( table.Lookup( 10, 10, -1 ), zeros );
+    Report( passed );
+}
+
+void TestBatch ( SWCharEstTable & table )
+{
+    cout << "Test: SWCharEstTable::GetBatch" << endl;
+    std::vector<float> sand, clay, ompc;
+    for ( int i = 0; i <= 100; i += 3 )
+	for ( int j = 0; i + j <= 100; j += 7 )
+	{
+	    sand.push_back( i / 100.0f );
+	    clay.push_back( j / 100.0f );
+	    ompc.push_back( ( i % 2 ) ? 1.3f : 1.33f );	// on and off the grid
+	}
+    std::size_t const n = sand.size();
+    std::vector<float> wp (n), fc (n), thetaS (n), ks (n);
+    table.GetBatch( n, &sand[0], &clay[0], &ompc[0], &wp[0], &fc[0], &thetaS[0], &ks[0] );
+    bool passed = true;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	SWCharEst::Results const r = { wp[i], fc[i], thetaS[i], ks[i] };
+	passed = passed && AreEqual( r, SWCharEst::Evaluate( sand[i], clay[i], ompc[i] ) );
+    }
+    Report( passed );
+}
+
+void TestThreads ()
+{
+    cout << "Test: SWCharEstTable used by several threads" << endl;
+    SWCharEstTable table;
+    bool ok[4] = { true, true, true, true };
+    std::vector<std::thread> threads;
+    for ( int t = 0; t < 4; ++t )
+	threads.push_back( std::thread( [&table, &ok, t] ()
+	{
+	    for ( int k = 0; k < 20; ++k )
+		for ( int i = 0; i <= 100; i += 5 )
+		    ok[t] = ok[t] &&
+			    AreEqual( table.Lookup( i, 100 - i, k ),
+				      SWCharEst::Evaluate( i / 100.0f, (100 - i) / 100.0f, k / 10.0f ) );
+	} ) );
+    for ( std::thread & thread : threads )
+	thread.join();
+    Report( ok[0] && ok[1] && ok[2] && ok[3] && table.NumSlicesBuilt() == 20 );
+}
+
+void TestSaveLoad ( SWCharEstTable & table )
+{
+    cout << "Test: SWCharEstTable::Save and Load" << endl;
+    char const * const fileName = "Test_SWCharEstTable.bin";
+    bool passed = table.Save( fileName );
+    SWCharEstTable loaded;
+    passed = passed && loaded.Load( fileName ) &&
+	     loaded.NumSlicesBuilt() == table.NumSlicesBuilt();
+    for ( int i = 0; i <= 100; ++i )
+	passed = passed &&
+		 AreEqual( loaded.Lookup( i, 100 - i, 25 ), table.Lookup( i, 100 - i, 25 ) );
+    std::remove( fileName );
+    SWCharEstTable notLoaded;
+    passed = passed && !notLoaded.Load( "Test_SWCharEst.cpp" ) &&
+	     !notLoaded.Load( "no such file" ) &&
+	     notLoaded.NumSlicesBuilt() == 0;
+    Report( passed );
+}
+
+int main ()
+{
+    SWCharEstTable table;
+    TestGrid( table );
+    TestOffGridAndInvalid( table );
+    TestBatch( table );
+    TestThreads();
+    TestSaveLoad( table );
+    return 0;
+}
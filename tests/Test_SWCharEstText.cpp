@@ -0,0 +1,250 @@
+// file:	Test_SWCharEstText.cpp
+// 		Test of class teh::SWCharEstText
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstText Test_SWCharEstText.cpp
+//	    ../src/SWCharEstText.cpp ../src/SWCharEst.cpp
+//	    ../src/SWCharEstSIMD.cpp ../src/SWCharEstMatrix.cpp
+// run:
+//	./Test_SWCharEstText
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "SWCharEstText.h"
+#include "SWCharEst.h"
+using teh::SWCharEstText;
+using teh::SWCharEst;
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+// true if ParseFloat and strtof agree on the text, to the bit
+bool SameAsStrtof ( std::string const & text )
+{
+    char * end;
+    float const expected = std::strtof( text.c_str(), &end );
+    bool const expectedOk = !text.empty() && end == text.c_str() + text.size() &&
+			    text[0] != ' ';	// no spaces
+    float value = 12345.0f;
+    bool const ok = SWCharEstText::ParseFloat( text.data(), text.data() + text.size(), value );
+    if ( ok != expectedOk )
+	return false;
+    return !ok || std::memcmp( &value, &expected, sizeof(float) ) == 0 ||
+	   ( std::isnan( value ) && std::isnan( expected ) );
+}
+
+void TestParse ()
+{
+    cout << "Test: SWCharEstText::ParseFloat equals strtof" << endl;
+    bool passed = true;
+    char const * const cases[] = {
+	"0", "-0", "+1", "0.15", "3.05", ".5", "5.", "1e5", "1E-5", "-2.5e+3",
+	"0.1000000000000000055511151231257827", "123456789012345678901234",
+	"16777217", "16777219", "33554434.9999999999999", "1.00000005960464477539062",
+	"3.4028235e38", "3.4028236e38", "1e39", "1e-45", "7e-46", "1.17549435e-38",
+	"0.000000000000000000000000000001", "1e22", "9007199254740993e-22",
+	"0x1p3", "inf", "-Infinity", "nan",
+	"", "-", ".", "e5", "1e", "1e+", "1.2.3", "1,5", " 1", "1 ", "abc", "--1" };
+    for ( char const * c : cases )
+	passed = passed && SameAsStrtof( c );
+
+    std::mt19937 random ( 1 );
+    char text[64];
+    for ( int i = 0; i < 200000 && passed; ++i )
+    {
+	// decimals of many lengths and exponents
+	unsigned long long const m = random() % 100000000000ULL * ( random() % 100000 + 1 );
+	int const e = int( random() % 60 ) - 40;
+	std::snprintf( text, sizeof(text), "%llue%d", m, e );
+	passed = SameAsStrtof( text );
+	// printed floats
+	uint32_t const bits = random();
+	float f;
+	std::memcpy( &f, &bits, sizeof(f) );
+	std::snprintf( text, sizeof(text), "%.*g", int( 1 + i % 12 ), f );
+	passed = passed && SameAsStrtof( text );
+	std::snprintf( text, sizeof(text), "%.*f", int( i % 8 ), ( random() % 100000 ) / 1000.0 );
+	passed = passed && SameAsStrtof( text );
+    }
+    Report( passed );
+}
+
+// number of significant digits in printed text
+int NumDigits ( std::string const & text )
+{
+    std::string digits;
+    for ( char c : text )
+    {
+	if ( c == 'e' )
+	    break;
+	if ( c >= '0' && c <= '9' )
+	    digits += c;
+    }
+    std::size_t const first = digits.find_first_not_of( '0' );
+    if ( first == std::string::npos )
+	return 1;
+    digits = digits.substr( first );
+    return int( digits.find_last_not_of( '0' ) + 1 );
+}
+
+void TestFormat ()
+{
+    cout << "Test: SWCharEstText::FormatFloat reads back, with the fewest digits" << endl;
+    bool passed = true;
+    std::size_t longer = 0;		// more digits than the shortest "%.*g"
+    std::mt19937 random ( 2 );
+    char text[32];
+    for ( int i = 0; i < 300000 && passed; ++i )
+    {
+	float f;
+	if ( i % 3 == 0 )
+	{
+	    uint32_t const bits = random();
+	    std::memcpy( &f, &bits, sizeof(f) );
+	    if ( std::isnan( f ) )
+		continue;
+	}
+	else if ( i % 3 == 1 )
+	    f = ( random() % 1000000 ) / 1000000.0f;
+	else
+	    f = std::ldexp( float( random() % 16777216 ), int( random() % 60 ) - 70 );
+
+	std::memset( text, '#', sizeof(text) );
+	char * const end = SWCharEstText::FormatFloat( f, text );
+	passed = ( end - text ) <= 15 && text[SWCharEstText::maxFormatted] == '#';
+	*end = '\0';
+	float const back = std::strtof( text, 0 );
+	passed = passed && std::memcmp( &back, &f, sizeof(f) ) == 0;
+
+	// fewest digits which read back with printf
+	char shortest[32];
+	for ( int p = 1; p <= 9; ++p )
+	{
+	    std::snprintf( shortest, sizeof(shortest), "%.*g", p, f );
+	    if ( std::strtof( shortest, 0 ) == f )
+		break;
+	}
+	longer += ( NumDigits( text ) > NumDigits( shortest ) );
+    }
+
+    char const * const cases[][2] = {
+	{ "0", "0" }, { "-0", "-0" }, { "1", "1" }, { "0.1", "0.1" }, { "-2.5", "-2.5" },
+	{ "100", "100" }, { "123456792", "123456790" }, { "1e9", "1e+09" },
+	{ "0.0001", "0.0001" }, { "0.00001", "1e-05" }, { "0.000432721834", "0.00043272183" },
+	{ "3.4028235e38", "3.4028235e+38" }, { "1.4e-45", "1e-45" }, { "inf", "inf" }, { "-inf", "-inf" } };
+    for ( auto const & c : cases )
+    {
+	float const f = std::strtof( c[0], 0 );
+	char * const end = SWCharEstText::FormatFloat( f, text );
+	passed = passed && std::string( text, end ) == c[1];
+    }
+    Report( passed && longer == 0 );
+}
+
+// FindDigits and FormatDigits write the text of FormatFloat
+bool CheckDigits ()
+{
+    std::mt19937 random ( 4 );
+    std::size_t const n = 100000 + 7;		// and a tail for each kernel
+    std::vector<float> values ( n );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+	uint32_t const bits = random();
+	if ( i % 4 == 1 )			// model-like values
+	    values[i] = ( random() % 1000000 ) / 1000000.0f;
+	else if ( i % 4 == 2 )			// near powers of 2 and 10
+	    values[i] = std::ldexp( 1.0f, int( random() % 256 ) - 149 ) *
+			( 1.0f + ( int( random() % 5 ) - 2 ) * 1.1920929e-7f );
+	else
+	    std::memcpy( &values[i], &bits, sizeof(float) );
+    }
+    float const specials[] = { 0.0f, -0.0f, 1.0f, 0.5f, 1.0e9f, 1.4e-45f, 1.0e-40f,
+			       std::numeric_limits<float>::quiet_NaN(),
+			       std::numeric_limits<float>::infinity(),
+			       -std::numeric_limits<float>::infinity(),
+			       std::numeric_limits<float>::max() };
+    std::memcpy( &values[100], specials, sizeof(specials) );
+
+    std::vector<uint32_t> digits ( n );
+    std::vector<int> exponents ( n );
+    SWCharEstText::FindDigits( n, &values[0], &digits[0], &exponents[0] );
+    bool passed = true;
+    for ( std::size_t i = 0; i < n && passed; ++i )
+    {
+	char text[32], expected[32];
+	std::memset( text, '#', sizeof(text) );
+	char * const end = SWCharEstText::FormatDigits( values[i], digits[i], exponents[i], text );
+	char * const expectedEnd = SWCharEstText::FormatFloat( values[i], expected );
+	passed = std::string( text, end ) == std::string( expected, expectedEnd ) &&
+		 text[SWCharEstText::maxFormatted] == '#';
+    }
+    return passed;
+}
+
+void TestDigits ()
+{
+    SWCharEst::BatchKernel const kernels[] = {
+	SWCharEst::KernelPortable, SWCharEst::KernelAVX2, SWCharEst::KernelAVX512 };
+    for ( int i = 0; i < 3; ++i )
+    {
+	if ( !SWCharEst::SetBatchKernel( kernels[i] ) )
+	    continue;
+	cout << "Test: SWCharEstText::FindDigits and FormatDigits equal FormatFloat with kernel "
+	     << SWCharEst::KernelName( kernels[i] ) << endl;
+	Report( CheckDigits() );
+    }
+    SWCharEst::SetBatchKernel( SWCharEst::KernelAuto );
+}
+
+void TestSeparators ()
+{
+    cout << "Test: SWCharEstText::FindSeparators finds each separator" << endl;
+    std::mt19937 random ( 3 );
+    char const alphabet[] = "0123456789.,;\"\n\t abc";
+    bool passed = true;
+    for ( std::size_t size = 0; size < 300 && passed; ++size )
+    {
+	std::string text;
+	for ( std::size_t i = 0; i < size + 1; ++i )
+	    text += alphabet[random() % ( sizeof(alphabet) - 1 )];
+	for ( char const delimiter : { ',', ';', '\t' } )
+	{
+	    // from an odd offset, so that loads are unaligned
+	    std::vector<uint32_t> positions ( size );
+	    std::size_t const n = SWCharEstText::FindSeparators(
+		text.data() + 1, size, delimiter, positions.data() );
+	    std::vector<uint32_t> expected;
+	    for ( std::size_t i = 0; i < size; ++i )
+	    {
+		char const c = text[i + 1];
+		if ( c == '\n' || c == '"' || c == delimiter )
+		    expected.push_back( uint32_t( i ) );
+	    }
+	    positions.resize( n );
+	    passed = passed && positions == expected;
+	}
+    }
+    Report( passed );
+}
+
+int main ()
+{
+    TestParse();
+    TestFormat();
+    TestDigits();
+    TestSeparators();
+    return 0;
+}
@@ -0,0 +1,119 @@
+// file:	Test_SWCharEstTexture.cpp
+// 		Test of class teh::SWCharEstTexture
+// build:
+//	g++ -std=c++11 -g -Wall -I../src -o Test_SWCharEstTexture Test_SWCharEstTexture.cpp
+//	    ../src/SWCharEstTexture.cpp ../src/SWCharEstMatrix.cpp ../src/SWCharEst.cpp ../src/SWCharEstSIMD.cpp
+// run:
+//	./Test_SWCharEstTexture
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cmath>
+#include <vector>
+#include "SWCharEstTexture.h"
+using teh::SWCharEst;
+using teh::SWCharEstTexture;
+
+//	Returns true if fabs(a-b) / a <= threshold (a != 0)
+//	or if fabs(a-b) / b <= threshold (b != 0)
+//	or true if a = b = 0, or both are NaN.
+inline bool AreCloseOrNaN (
+	float const a, float const b, float const threshold )
+{
+	if ( std::isnan(a) || std::isnan(b) )
+	    return std::isnan(a) && std::isnan(b);
+	bool result = true;
+	if ( a != b )
+	{
+		if ( a != 0.0f )
+		    result = (std::fabs ((a - b) / a) <= threshold);
+		else
+		    result = (std::fabs ((a - b) / b) <= threshold);
+	}
+	return result;
+}
+
+bool AreClose (
+    SWCharEst::Results const & a,
+    SWCharEst::Results const & b )
+{
+    return AreCloseOrNaN( a.WP, b.WP, 1.0e-5f ) &&
+	   AreCloseOrNaN( a.FC, b.FC, 1.0e-5f ) &&
+	   AreCloseOrNaN( a.thetaS, b.thetaS, 1.0e-5f ) &&
+	   // Ks is sensitive to thetaS - FC where it is near zero
+	   ( AreCloseOrNaN( a.Ks, b.Ks, 1.0e-4f ) || std::fabs( a.Ks - b.Ks ) < 1.0e-9f );
+}
+
+void Report ( bool const passed )
+{
+    if ( passed )
+	cout << "  passed" << endl;
+    else
+	cout << "  failed" << endl;
+}
+
+void TestYears ()
+{
+    cout << "Test: SWCharEstTexture::Evaluate with OM changing each year" << endl;
+    std::vector<float> sand, clay;
+    for ( int i = 0; i <= 100; i += 2 )
+	for ( int j = 0; i + j <= 100; j += 3 )
+	{
+	    sand.push_back( i / 100.0f );
+	    clay.push_back( j / 100.0f );
+	}
+    std::size_t const n = sand.size();
+    SWCharEstTexture const texture ( n, &sand[0], &clay[0] );
+    std::vector<float> ompc (n), wp (n), fc (n), thetaS (n), ks (n);
+    bool passed = texture.Size() == n;
+    for ( int year = 0; year < 10; ++year )
+    {
+	for ( std::size_t i = 0; i < n; ++i )
+	    ompc[i] = 0.5f + 0.37f * year + 0.01f * ( i % 50 );
+	texture.Evaluate( &ompc[0], &wp[0], &fc[0], &thetaS[0], &ks[0] );
+	for ( std::size_t i = 0; i < n; ++i )
+	{
+	    SWCharEst::Results const r = { wp[i], fc[i], thetaS[i], ks[i] };
+	    passed = passed && AreClose( r, SWCharEst::Evaluate( sand[i], clay[i], ompc[i] ) );
+	}
+    }
+    Report( passed );
+}
+
+// one soil from SWCharEst::GetBatch
+SWCharEst::Results GetBatchOne (
+    float const sand, float const clay, float const ompc )
+{
+    SWCharEst::Results r;
+    SWCharEst::GetBatch( 1, &sand, &clay, &ompc, &r.WP, &r.FC, &r.thetaS, &r.Ks );
+    return r;
+}
+
+void TestGet ()
+{
+    cout << "Test: SWCharEstTexture::Get, and invalid arguments" << endl;
+    float const sand[] = { 0.15f, 0.6f, -0.1f, 0.88f };
+    float const clay[] = { 0.18f, 0.5f, 0.2f, 0.05f };
+    SWCharEstTexture const texture ( 4, sand, clay );
+    SWCharEst::Results const zeros = { 0.0f, 0.0f, 0.0f, 0.0f };
+    bool const passed =
+	AreClose( texture.Get( 0, 3.1f ), SWCharEst::Evaluate( 0.15f, 0.18f, 3.1f ) ) &&
+	AreClose( texture.Get( 3, 85.0f ), SWCharEst::Evaluate( 0.88f, 0.05f, 85.0f ) ) &&
+	AreClose( texture.Get( 1, 2.0f ), zeros ) &&
+	AreClose( texture.Get( 2, 2.0f ), zeros ) &&
+	AreClose( texture.Get( 0, -1.0f ), zeros ) &&
+	// NaN OM is 70%, as in GetBatch
+	AreClose( texture.Get( 0, NAN ), SWCharEst::Evaluate( 0.15f, 0.18f, 70.0f ) ) &&
+	AreClose( texture.Get( 0, NAN ), GetBatchOne( 0.15f, 0.18f, NAN ) ) &&
+	AreClose( texture.Get( 4, 2.0f ), zeros ) &&
+	texture.MemorySize() == 4 * 8 * sizeof(float);
+    Report( passed );
+}
+
+int main ()
+{
+    TestYears();
+    TestGet();
+    return 0;
+}